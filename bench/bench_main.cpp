@@ -0,0 +1,437 @@
+/*********************************************************************
+  Purpose: Microbenchmarks of debug_logger hot paths
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+
+  Build:  cmake -S . -B build && cmake --build build --target bench_logger
+     or:  g++ -std=c++11 -O2 -pthread bench/bench_main.cpp bench/bench_nolog.cpp debug*.cpp objlog.cpp tostr_*.cpp -o bench_logger
+  Usage:  bench_logger [max_threads]
+**********************************************************************/
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>          // malloc, atoi
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../debuglog.h"
+#include "../debugbatchsink.h"
+#include "../debugcallsite.h"
+#include "../debugcompress.h"
+#include "../debugfilesink.h"
+#include "../debugflight.h"
+#include "../debugmetrics.h"
+#include "../debugresolve.h"
+#include "../debugtiming.h"
+#include "../debugwatch.h"
+#include "../objlog.h"
+
+using namespace ::tsv::debug;
+
+/************** Count heap allocations **********/
+
+static std::atomic<size_t> allocationCount( 0 );
+
+void* operator new( std::size_t size )
+{
+    allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    void* ptr = malloc( size ? size : 1 );
+    if ( !ptr )
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+    free( ptr );
+}
+
+/************** Measured functions **********/
+
+int bench_nolog_func( int x );      // bench_nolog.cpp: DEBUG_LOGGING=0
+
+__attribute__(( noinline )) int bench_callsite_func( int x )
+{
+    SENTRY_FUNC( "x=%d", x );
+    SAY_DBG( "x=%d", x );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_sentry_func( int x )
+{
+    SENTRY_FUNC( "x=%d", x );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_say_func( int x )
+{
+    SAY_DBG( "x=%d", x );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_args_func( int x )
+{
+    double ratio = 2.5;
+    SAY_ARGS( x, ratio );
+    return x + 1;
+}
+
+// Arguments which are expensive to evaluate and to print
+static std::vector<std::string> benchNames( 20, "some name" );
+
+__attribute__(( noinline )) static int benchExpensive( int x )
+{
+    int sum = x;
+    for ( const std::string& name : benchNames )
+        sum += static_cast<int>( name.size() );
+    return sum;
+}
+
+__attribute__(( noinline )) int bench_args_big_func( int x )
+{
+    double ratio = 2.5;
+    std::string name = "bench";
+    SAY_ARGS( x, ratio, name, benchNames, benchExpensive( x ), "literal", x * 2, &ratio );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_expr_big_func( int x )
+{
+    SAY_EXPR( benchExpensive( x ), "+", benchNames, "/", x );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_func_w_args_func( int x )
+{
+    SENTRY_FUNC_W_ARGS( x, benchNames, benchExpensive( x ) );
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_stream_func( int x )
+{
+    SENTRY_FNSTREAM() << "x=" << x << " y=" << 2.5 << " name=" << "bench" << "\n";
+    return x + 1;
+}
+
+// One << with many lines ( processing of lines have to be linear )
+__attribute__(( noinline )) int bench_stream_lines_func( int x )
+{
+    static std::string text;
+    if ( text.empty() )
+        for ( int i = 0; i < 500; i++ )
+            text += "some line of multi-line output\n";
+    SENTRY_SILENT();
+    sentry << text;
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_tostr_args_func( int x )
+{
+    double ratio = 2.5;
+    std::string s = TOSTR_ARGS( x, ratio, "bench" );
+    return x + ( s.empty() ? 0 : 1 );
+}
+
+__attribute__(( noinline )) int bench_tostr_expr_func( int x )
+{
+    double ratio = 2.5;
+    std::string s = TOSTR_EXPR( x, "*", ratio );
+    return x + ( s.empty() ? 0 : 1 );
+}
+
+static std::string callStrfmtVA( const char* fmt, ... )
+{
+    va_list args;
+    va_start( args, fmt );
+    std::string s = ::tsv::util::tostr::strfmtVA( fmt, &args );
+    va_end( args );
+    return s;
+}
+
+__attribute__(( noinline )) int bench_strfmt_func( int x )
+{
+    std::string s = callStrfmtVA( "x=%d y=%g name=%s", x, 2.5, "bench" );
+    return x + ( s.empty() ? 0 : 1 );
+}
+
+// Pointers and integers: dedicated formatters against stringstream baseline
+__attribute__(( noinline )) int bench_hex_addr_func( int x )
+{
+    std::string s = ::tsv::util::tostr::hex_addr( &benchNames[x & 15] );
+    return x + static_cast<int>( s.size() );
+}
+
+__attribute__(( noinline )) int bench_hex_stream_func( int x )
+{
+    std::stringstream ss;
+    ss << static_cast<const void*>( &benchNames[x & 15] );
+    return x + static_cast<int>( ss.str().size() );
+}
+
+__attribute__(( noinline )) int bench_tostr_int_func( int x )
+{
+    std::string s = ::tsv::util::tostr::toStr( x * 1000003 );
+    return x + static_cast<int>( s.size() );
+}
+
+__attribute__(( noinline )) int bench_int_stream_func( int x )
+{
+    std::stringstream ss;
+    ss << x * 1000003;
+    return x + static_cast<int>( ss.str().size() );
+}
+
+__attribute__(( noinline )) int bench_format_buf_func( int x )
+{
+    char buf[::tsv::util::tostr::DECIMAL_BUF_SIZE];
+    size_t len = ::tsv::util::tostr::formatDecimal( buf, x * 1000003 );
+    len += ::tsv::util::tostr::formatHex( buf, static_cast<unsigned>( x ) * 2654435761u );
+    return x + static_cast<int>( len );
+}
+
+// Floating point: shortest round-trip against std::to_string and stringstream
+static const double benchDoubles[16] = { 0.1, 2.5, 1.0 / 3, 123.456, 1e-7, 6.02214076e23, 299792458.0, 0.30000000000000004,
+                                         -17.25, 3.141592653589793, 1e100, 42.0, 0.001, 2.718281828459045, 1e16, -0.5 };
+
+__attribute__(( noinline )) int bench_tostr_double_func( int x )
+{
+    std::string s = ::tsv::util::tostr::toStr( benchDoubles[x & 15] * ( x & 3 ) );
+    return x + static_cast<int>( s.size() );
+}
+
+__attribute__(( noinline )) int bench_to_string_double_func( int x )
+{
+    std::string s = std::to_string( benchDoubles[x & 15] * ( x & 3 ) );
+    return x + static_cast<int>( s.size() );
+}
+
+__attribute__(( noinline )) int bench_double_stream_func( int x )
+{
+    std::stringstream ss;
+    ss.precision( 17 );
+    ss << benchDoubles[x & 15] * ( x & 3 );
+    return x + static_cast<int>( ss.str().size() );
+}
+
+__attribute__(( noinline )) int bench_format_double_func( int x )
+{
+    char buf[::tsv::util::tostr::FLOAT_BUF_SIZE];
+    return x + static_cast<int>( ::tsv::util::tostr::formatDouble( buf, benchDoubles[x & 15] * ( x & 3 ) ) );
+}
+
+__attribute__(( noinline )) int bench_format_integral_double_func( int x )
+{
+    char buf[::tsv::util::tostr::FLOAT_BUF_SIZE];
+    return x + static_cast<int>( ::tsv::util::tostr::formatDouble( buf, static_cast<double>( x ) ) );
+}
+
+struct BenchObject
+{
+    int       value_;
+    ObjLogger debug_sentry_;
+
+    explicit BenchObject( bool isTracked ) : value_( 0 ), debug_sentry_( isTracked ? this : nullptr, "BenchObject" ) {}
+};
+
+__attribute__(( noinline )) int bench_objlog_func( int x )
+{
+    BenchObject obj( true );
+    return x + 1 + obj.value_;
+}
+
+__attribute__(( noinline )) int bench_objlog_untracked_func( int x )
+{
+    BenchObject obj( false );
+    return x + 1 + obj.value_;
+}
+
+struct BenchWatched
+{
+    int value_;
+};
+
+__attribute__(( noinline )) int bench_watch_get_func( int x )
+{
+    static BenchWatched obj = { 0 };
+    return x + 1 + Watch_Getter( obj, "value_", obj.value_, 0, ::tsv::util::tostr::ENUM_TOSTR_REPR );
+}
+
+__attribute__(( noinline )) int bench_watch_set_func( int x )
+{
+    static BenchWatched obj = { 0 };
+    Watch_Setter( obj, "value_", obj.value_, x, 0, ::tsv::util::tostr::ENUM_TOSTR_REPR );
+    obj.value_ = x;
+    return x + 1;
+}
+
+__attribute__(( noinline )) int bench_backtrace_func( int x )
+{
+    return x + static_cast<int>( getBackTrace( 8, 0, true ).size() );
+}
+
+/************** Runner **********/
+
+namespace {
+
+const int ITERATIONS = 10000000;
+
+// Run "func" "iterations" times in each of "threads" threads.
+// Print wall time per call of one thread ( so contention shows as growth ) and heap allocations per call
+template<typename Func>
+void run( const char* title, Func func, int iterations = ITERATIONS, int threads = 1 )
+{
+    std::atomic<int> result( 0 );
+    auto body = [&]()
+        {
+            int x = 0;
+            for ( int i = 0; i < iterations; i++ )
+                x = func( x );
+            result += x;
+        };
+
+    size_t allocations = allocationCount.load();
+    uint64_t start = Timing::now();
+    if ( threads == 1 )
+        body();
+    else
+    {
+        std::vector<std::thread> pool;
+        for ( int i = 0; i < threads; i++ )
+            pool.emplace_back( body );
+        for ( std::thread& th : pool )
+            th.join();
+    }
+    uint64_t ns = Timing::toNs( Timing::now() - start );
+    // thread objects themselves allocate a bit, it is far below of 0.01/call
+    allocations = allocationCount.load() - allocations;
+
+    char label[64];
+    snprintf( label, sizeof(label), threads == 1 ? "%s" : "%s, %d threads", title, threads );
+    printf( "%-44s %10.2f ns/op %8.2f allocs/op  (%d)\n", label,
+            static_cast<double>( ns ) / iterations,
+            static_cast<double>( allocations ) / iterations / threads, result.load() );
+}
+
+// Run "func" in 1, 2, 4 ... "maxThreads" threads
+template<typename Func>
+void runThreads( const char* title, Func func, int iterations, int maxThreads )
+{
+    for ( int threads = 1; ; threads *= 2 )
+    {
+        if ( threads > maxThreads )
+            threads = maxThreads;
+        run( title, func, iterations, threads );
+        if ( threads == maxThreads )
+            break;
+    }
+}
+
+void nullHandler( const char* fmt, void* args )
+{
+}
+
+}   // anonymous namespace
+
+int main( int argc, char** argv )
+{
+    int maxThreads = ( argc > 1 ) ? atoi( argv[1] ) : static_cast<int>( std::thread::hardware_concurrency() );
+    if ( maxThreads < 1 )
+        maxThreads = 1;
+    if ( maxThreads > 64 )
+        maxThreads = 64;
+
+    printf( "Timing source: %s\n", Timing::getSource() == Timing::SOURCE_TSC ? "TSC" : "CLOCK_MONOTONIC" );
+    printf( "sizeof(SentryLogger): %d\n", static_cast<int>( sizeof(SentryLogger) ) );
+    printf( "Threads: 1..%d\n\n", maxThreads );
+
+    // Compiled out vs. switched off in runtime
+    runThreads( "DEBUG_LOGGING=0", bench_nolog_func, ITERATIONS, maxThreads );
+    CallSite::enableByName( "bench_*", false );
+    runThreads( "disabled callsite", bench_callsite_func, ITERATIONS, maxThreads );
+    run( "disabled SENTRY_FUNC", bench_sentry_func );
+    run( "disabled SAY_DBG", bench_say_func );
+    run( "disabled SAY_ARGS", bench_args_func );
+
+    // For reference: callsite is on, but output goes nowhere
+    CallSite::resetRules();
+    LoggerHandler::handler_s = nullHandler;
+    runThreads( "enabled callsite, null handler", bench_callsite_func, ITERATIONS / 10, maxThreads );
+    LoggerMetrics::start();
+    run( "enabled callsite, null handler, metrics", bench_callsite_func, ITERATIONS / 10 );
+    LoggerMetrics::stop();
+    run( "SENTRY_FUNC, null handler", bench_sentry_func, ITERATIONS / 10 );
+    run( "SAY_DBG, null handler", bench_say_func, ITERATIONS / 10 );
+    runThreads( "SAY_ARGS, null handler", bench_args_func, ITERATIONS / 10, maxThreads );
+    run( "stream sentry, null handler", bench_stream_func, ITERATIONS / 10 );
+    run( "stream of 500 lines, null handler", bench_stream_lines_func, ITERATIONS / 1000 );
+
+    // Nobody wants output: cost should not depend on arguments
+    LoggerHandler::handler_s = nullptr;
+    run( "filtered SAY_ARGS, 2 args", bench_args_func, ITERATIONS / 10 );
+    run( "filtered SAY_ARGS, 8 big args", bench_args_big_func, ITERATIONS / 10 );
+    run( "filtered SAY_EXPR, big args", bench_expr_big_func, ITERATIONS / 10 );
+    run( "filtered SENTRY_FUNC_W_ARGS, big args", bench_func_w_args_func, ITERATIONS / 10 );
+    LoggerHandler::handler_s = nullHandler;
+
+    // Formatting without logging
+    run( "TOSTR_ARGS", bench_tostr_args_func, ITERATIONS / 10 );
+    run( "TOSTR_EXPR", bench_tostr_expr_func, ITERATIONS / 10 );
+    run( "strfmtVA", bench_strfmt_func, ITERATIONS / 10 );
+    run( "hex_addr", bench_hex_addr_func, ITERATIONS / 10 );
+    run( "stringstream << ptr", bench_hex_stream_func, ITERATIONS / 10 );
+    run( "toStr(int)", bench_tostr_int_func, ITERATIONS / 10 );
+    run( "stringstream << int", bench_int_stream_func, ITERATIONS / 10 );
+    run( "formatDecimal + formatHex to buffer", bench_format_buf_func, ITERATIONS / 10 );
+    run( "toStr(double)", bench_tostr_double_func, ITERATIONS / 10 );
+    run( "std::to_string(double)", bench_to_string_double_func, ITERATIONS / 10 );
+    run( "stringstream << double, precision 17", bench_double_stream_func, ITERATIONS / 10 );
+    run( "formatDouble to buffer", bench_format_double_func, ITERATIONS / 10 );
+    run( "formatDouble to buffer, integral value", bench_format_integral_double_func, ITERATIONS / 10 );
+
+    // Objects and members tracking ( ObjLogger registry is not thread-safe )
+    run( "ObjLogger ctor/dtor, null handler", bench_objlog_func, ITERATIONS / 100 );
+    run( "ObjLogger ctor/dtor, not tracked", bench_objlog_untracked_func, ITERATIONS / 10 );
+    run( "Watch_Getter, null handler", bench_watch_get_func, ITERATIONS / 100 );
+    run( "Watch_Setter, null handler", bench_watch_set_func, ITERATIONS / 100 );
+    run( "getBackTrace(8)", bench_backtrace_func, ITERATIONS / 10000 );
+
+    // Flight recorder at full verbosity while text output is off
+    LoggerHandler::handler_s = nullptr;
+    FlightRecorder::open( "/tmp/bench_logger.flight" );
+    runThreads( "flight recorder, no handler", bench_callsite_func, ITERATIONS / 10, maxThreads );
+    FlightRecorder::close();
+    remove( "/tmp/bench_logger.flight" );
+
+    // Rotating file sink instead of handler
+    FileSink::open( "/tmp/bench_logger.log", 16 * 1024 * 1024, 1 );
+    run( "file sink, no handler", bench_callsite_func, ITERATIONS / 10 );
+    FileSink::close();
+    remove( "/tmp/bench_logger.log" );
+    remove( "/tmp/bench_logger.log.1" );
+
+    // Same with compression stage in front of file sink
+    FileSink::open( "/tmp/bench_logger.log", 16 * 1024 * 1024, 1 );
+    LogCompressor::open();
+    run( "compressed file sink, no handler", bench_callsite_func, ITERATIONS / 10 );
+    LogCompressor::close();
+    FileSink::close();
+    remove( "/tmp/bench_logger.log" );
+    remove( "/tmp/bench_logger.log.1" );
+
+    // Batched writev() of LOG_STDOUT copies into /dev/null
+    int devNull = ::open( "/dev/null", O_WRONLY );
+    SentryLogger::setLogStdoutSystemFlag( true );
+    BatchSink::open( devNull );
+    runThreads( "batch sink, LOG_STDOUT", bench_callsite_func, ITERATIONS / 10, maxThreads );
+    BatchSink::close();
+    SentryLogger::setLogStdoutSystemFlag( false );
+    ::close( devNull );
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+// Same functions as in bench_main.cpp, but compiled without logging at all
+#define DEBUG_LOGGING 0
+#include "../debuglog.h"
+
+__attribute__(( noinline )) int bench_nolog_func( int x )
+{
+    SENTRY_FUNC( "x=%d", x );
+    SAY_DBG( "x=%d", x );
+    return x + 1;
+}
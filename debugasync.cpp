@@ -0,0 +1,355 @@
+/*********************************************************************
+  Purpose: Asynchronous output of logger
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>       // unique_ptr
+#include <cstring>      // memcpy
+
+#include "debugasync.h"
+#include "debuglog.h"
+
+namespace tsv {
+namespace debug {
+
+namespace {
+
+/***************************************************************************
+    Bounded lock-free multi-producer queue of prepared lines
+    ( D.Vyukov bounded MPMC queue: each cell has own sequence number,
+      so producers never wait each other and queue could be dequeued
+      by producer too - that is how POLICY_DROP_OLDEST works )
+***************************************************************************/
+class LineRing
+{
+    public:
+        // Size of line which is kept inside of cell (longer ones are on heap)
+        // ( chosen to make cell exactly 256 bytes )
+        static const size_t INLINE_SIZE = 224;
+
+        struct Cell
+        {
+            std::atomic<size_t> seq_;
+            size_t      pos_;               // position of acquired cell (used by release)
+            int         level_;
+            unsigned    len_;
+            char*       heap_;              // line if it is too long for data_
+            char        data_[INLINE_SIZE];
+
+            const char* line() const { return heap_ ? heap_ : data_; }
+        };
+
+        explicit LineRing( size_t capacity )
+        {
+            size_t size = 2;
+            while ( size < capacity )
+                size <<= 1;
+            mask_ = size - 1;
+            cells_.reset( new Cell[size] );
+            for ( size_t i = 0; i < size; i++ )
+            {
+                cells_[i].seq_.store( i, std::memory_order_relaxed );
+                cells_[i].heap_ = nullptr;
+            }
+            enqueuePos_.store( 0, std::memory_order_relaxed );
+            dequeuePos_.store( 0, std::memory_order_relaxed );
+        }
+
+        ~LineRing()
+        {
+            Cell* cell;
+            while ( ( cell = acquire() ) )
+                release( cell );
+        }
+
+        // Put line into queue. Return false if queue is full
+        bool push( int level, const char* line, size_t len )
+        {
+            Cell* cell;
+            size_t pos = enqueuePos_.load( std::memory_order_relaxed );
+            for (;;)
+            {
+                cell = &cells_[ pos & mask_ ];
+                size_t seq = cell->seq_.load( std::memory_order_acquire );
+                intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+                if ( dif == 0 )
+                {
+                    if ( enqueuePos_.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                        break;
+                }
+                else if ( dif < 0 )
+                    return false;
+                else
+                    pos = enqueuePos_.load( std::memory_order_relaxed );
+            }
+
+            char* dst = cell->data_;
+            if ( len >= INLINE_SIZE )
+                dst = cell->heap_ = new char[ len + 1 ];
+            memcpy( dst, line, len );
+            dst[len] = 0;
+            cell->level_ = level;
+            cell->len_ = len;
+
+            cell->seq_.store( pos + 1, std::memory_order_release );
+            return true;
+        }
+
+        // Get the oldest cell from queue (nullptr if empty).
+        // Cell have to be returned back by release()
+        Cell* acquire()
+        {
+            Cell* cell;
+            size_t pos = dequeuePos_.load( std::memory_order_relaxed );
+            for (;;)
+            {
+                cell = &cells_[ pos & mask_ ];
+                size_t seq = cell->seq_.load( std::memory_order_acquire );
+                intptr_t dif = (intptr_t)seq - (intptr_t)( pos + 1 );
+                if ( dif == 0 )
+                {
+                    if ( dequeuePos_.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                        break;
+                }
+                else if ( dif < 0 )
+                    return nullptr;
+                else
+                    pos = dequeuePos_.load( std::memory_order_relaxed );
+            }
+            cell->pos_ = pos;
+            return cell;
+        }
+
+        void release( Cell* cell )
+        {
+            delete[] cell->heap_;
+            cell->heap_ = nullptr;
+            cell->seq_.store( cell->pos_ + mask_ + 1, std::memory_order_release );
+        }
+
+        // How many lines were pushed ever
+        size_t pushedCount() const { return enqueuePos_.load( std::memory_order_acquire ); }
+
+    private:
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_;
+        // Producers and consumer positions are on different cache lines
+        char pad1_[64];
+        std::atomic<size_t> enqueuePos_;
+        char pad2_[64];
+        std::atomic<size_t> dequeuePos_;
+};
+
+/***************************************************************************
+    State of asynchronous mode
+***************************************************************************/
+struct AsyncState
+{
+    std::atomic<bool>     active_;        // true if producers could push
+    std::atomic<int>      inflight_;      // how many producers are inside of push() or flush() now
+    std::atomic<bool>     running_;       // false means consumer should drain queue and exit
+    std::atomic<bool>     sleeping_;      // true if consumer waits for notification
+    std::atomic<size_t>   consumed_;      // how many lines were handled or dropped from queue
+    std::atomic<uint64_t> droppedNewest_;
+    std::atomic<uint64_t> droppedOldest_;
+
+    AsyncLogger::Policy   policy_;
+    std::unique_ptr<LineRing> ring_;
+    std::thread           consumer_;
+    std::mutex            mutex_;         // used only to sleep/wakeup consumer and start/stop
+    std::condition_variable cond_;
+
+    AsyncState() : active_( false ), inflight_( 0 ), running_( false ), sleeping_( false ),
+                   consumed_( 0 ), droppedNewest_( 0 ), droppedOldest_( 0 ), policy_( AsyncLogger::POLICY_BLOCK ) {}
+
+    // Flush tail events if user forgot to call stop()
+    ~AsyncState() { AsyncLogger::stop(); }
+
+    void wakeup()
+    {
+        if ( sleeping_.load() )
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            cond_.notify_one();
+        }
+    }
+};
+
+AsyncState state_s;
+
+// Output all lines which are in queue now. Return number of handled lines
+size_t drainQueue()
+{
+    size_t count = 0;
+    LineRing::Cell* cell;
+    while ( ( cell = state_s.ring_->acquire() ) )
+    {
+        LoggerHandler::output( cell->level_, cell->line(), cell->len_ );
+        state_s.ring_->release( cell );
+        state_s.consumed_.fetch_add( 1, std::memory_order_release );
+        count++;
+    }
+    return count;
+}
+
+// Body of background thread
+void consumerLoop()
+{
+    int idle = 0;
+    while ( state_s.running_.load() )
+    {
+        if ( drainQueue() )
+        {
+            idle = 0;
+            continue;
+        }
+
+        // Spin a bit before going to sleep ( to not pay for wakeup on each burst )
+        if ( ++idle < 64 )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( state_s.mutex_ );
+        state_s.sleeping_.store( true );
+        if ( state_s.running_.load() && state_s.ring_->pushedCount() == state_s.consumed_.load() )
+            state_s.cond_.wait_for( lock, std::chrono::milliseconds( 10 ) );
+        state_s.sleeping_.store( false );
+        idle = 0;
+    }
+    drainQueue();
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Start background consumer
+**********************************************************************************/
+bool AsyncLogger::start( size_t capacity /*=8192*/, Policy policy /*=POLICY_BLOCK*/ )
+{
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    if ( state_s.running_.load() )
+        return false;
+
+    state_s.ring_.reset( new LineRing( capacity ) );
+    state_s.policy_ = policy;
+    state_s.consumed_.store( 0 );
+    state_s.running_.store( true );
+    state_s.consumer_ = std::thread( consumerLoop );
+    state_s.active_.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Flush tail and join background thread
+**********************************************************************************/
+void AsyncLogger::stop()
+{
+    if ( !state_s.running_.load() )
+        return;
+
+    // New lines go synchronously. Wait producers which are pushing right now
+    state_s.active_.store( false );
+    while ( state_s.inflight_.load() )
+        std::this_thread::yield();
+
+    {
+        std::lock_guard<std::mutex> lock( state_s.mutex_ );
+        state_s.running_.store( false );
+        state_s.cond_.notify_one();
+    }
+    if ( state_s.consumer_.joinable() )
+        state_s.consumer_.join();
+    state_s.ring_.reset();
+}
+
+/**********************************************************************************
+   PURPOSE:   Wait until all lines which were pushed before are handled
+**********************************************************************************/
+void AsyncLogger::flush()
+{
+    // Counted as producer, so stop() does not free ring while we read it
+    state_s.inflight_.fetch_add( 1 );
+    if ( !state_s.active_.load() )
+    {
+        state_s.inflight_.fetch_sub( 1 );
+        return;
+    }
+    size_t target = state_s.ring_->pushedCount();
+    state_s.inflight_.fetch_sub( 1 );
+
+    while ( state_s.active_.load() && state_s.consumed_.load( std::memory_order_acquire ) < target )
+    {
+        state_s.wakeup();
+        std::this_thread::yield();
+    }
+}
+
+bool AsyncLogger::isActive()
+{
+    return state_s.active_.load( std::memory_order_relaxed );
+}
+
+/**********************************************************************************
+   PURPOSE:   Push prepared line to the queue
+   RETURN:    false if async mode is not active ( line was not handled )
+**********************************************************************************/
+bool AsyncLogger::push( int level, const char* line, size_t len )
+{
+    state_s.inflight_.fetch_add( 1 );
+    if ( !state_s.active_.load() )
+    {
+        state_s.inflight_.fetch_sub( 1 );
+        return false;
+    }
+
+    LineRing& ring = *state_s.ring_;
+    while ( !ring.push( level, line, len ) )
+    {
+        if ( state_s.policy_ == POLICY_DROP_NEWEST )
+        {
+            state_s.droppedNewest_.fetch_add( 1, std::memory_order_relaxed );
+            break;
+        }
+        else if ( state_s.policy_ == POLICY_DROP_OLDEST )
+        {
+            LineRing::Cell* cell = ring.acquire();
+            if ( cell )
+            {
+                ring.release( cell );
+                state_s.consumed_.fetch_add( 1, std::memory_order_release );
+                state_s.droppedOldest_.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+        else
+        {
+            // POLICY_BLOCK: wait until consumer frees some space
+            state_s.wakeup();
+            std::this_thread::yield();
+        }
+    }
+
+    state_s.wakeup();
+    state_s.inflight_.fetch_sub( 1 );
+    return true;
+}
+
+uint64_t AsyncLogger::getDroppedNewest()
+{
+    return state_s.droppedNewest_.load( std::memory_order_relaxed );
+}
+
+uint64_t AsyncLogger::getDroppedOldest()
+{
+    return state_s.droppedOldest_.load( std::memory_order_relaxed );
+}
+
+}   // namespace debug
+}   // namespace tsv
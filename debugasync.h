@@ -0,0 +1,68 @@
+#ifndef DEBUGASYNC_H_
+#define DEBUGASYNC_H_ 1
+
+/*********************************************************************
+  Purpose: Asynchronous output of logger
+           ( caller thread only prepare line and push it to the
+             bounded lock-free queue, background thread drains it
+             into LoggerHandler )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Asynchronous logging mode
+
+  HOWTO USE:
+     AsyncLogger::start( 8192, AsyncLogger::POLICY_DROP_OLDEST );
+     ... all SENTRY_* and SAY_* output goes through background thread ...
+     AsyncLogger::stop();      // flush tail events and join background thread
+
+  NOTES:
+    1. Handler (LoggerHandler::handler_s) is called from background thread only.
+    2. Order of lines from one thread is kept. Lines of different threads are
+       ordered by the moment they were pushed.
+    3. Queue is bounded. What happens if it is full is defined by policy:
+         POLICY_BLOCK       - producer waits until consumer frees slot
+         POLICY_DROP_NEWEST - pushed line is dropped
+         POLICY_DROP_OLDEST - the oldest line in queue is dropped to free slot
+******************************************************************************/
+
+class AsyncLogger
+{
+    public:
+        enum Policy { POLICY_BLOCK, POLICY_DROP_NEWEST, POLICY_DROP_OLDEST };
+
+        // Start background consumer thread
+        //      capacity = how many lines queue could keep (rounded up to power of 2)
+        // Return false if already started
+        static bool start( size_t capacity = 8192, Policy policy = POLICY_BLOCK );
+
+        // Flush all pending lines and join background thread
+        static void stop();
+
+        // Wait until all lines pushed before this call are handled
+        static void flush();
+
+        static bool isActive();
+
+        // Push prepared line to queue ( "level" is set of LOG_* flags )
+        // Return false if async mode is not active (so caller should output line itself)
+        static bool push( int level, const char* line, size_t len );
+
+        // Counters of lines which were lost because queue was full
+        static uint64_t getDroppedNewest();
+        static uint64_t getDroppedOldest();
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,273 @@
+/*********************************************************************
+  Purpose: Batched output of lines by writev() from per-thread buffers
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <algorithm>        // min, find
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>           // fflush
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <climits>          // IOV_MAX
+#include <sys/uio.h>
+
+#include "debugbatchsink.h"
+#include "debugtiming.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> BatchSink::active_s( false );
+
+namespace {
+
+const size_t CHUNK_SIZE = 4096;
+
+struct Batch;
+
+struct SinkState
+{
+    std::mutex               mutex_;        // open/close, batches_
+    std::vector<Batch*>      batches_;      // batches of all alive threads
+    std::mutex               writeMutex_;   // writev() of whole batch is never mixed with others
+
+    std::atomic<int>         fd_;
+    std::atomic<size_t>      batchBytes_;
+    uint64_t                 intervalNs_;
+    int                      intervalMs_;
+
+    std::thread              thread_;
+    std::condition_variable  cond_;
+    bool                     stop_;
+
+    SinkState() : fd_( STDOUT_FILENO ), batchBytes_( 0 ), intervalNs_( 0 ), intervalMs_( 0 ), stop_( false ) {}
+    ~SinkState() { BatchSink::close(); }
+};
+
+SinkState state_s;
+
+// Write whole iovec array ( continue after partial write )
+void writeAll( int fd, iovec* iov, int count )
+{
+    while ( count > 0 )
+    {
+        ssize_t n = writev( fd, iov, std::min( count, IOV_MAX ) );
+        if ( n < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            return;                             // nowhere to report error of log output
+        }
+        for ( ; count > 0 && static_cast<size_t>( n ) >= iov->iov_len; iov++, count-- )
+            n -= iov->iov_len;
+        if ( count > 0 )
+        {
+            iov->iov_base = static_cast<char*>( iov->iov_base ) + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+/***************************************************************************
+    Lines of one thread
+
+  Text is copied into chunks ( they are reused after flush ), adjacent
+  lines of the same chunk are coalesced into one iovec.
+  Owner thread and background flusher access it under mutex_ ( it is
+  contended only at moment of background flush ).
+***************************************************************************/
+struct Batch
+{
+    struct Chunk
+    {
+        std::unique_ptr<char[]> data_;
+        size_t                  size_;
+
+        Chunk() : size_( 0 ) {}
+    };
+
+    std::mutex          mutex_;
+    std::vector<Chunk>  chunks_;
+    size_t              chunk_;             // index of chunk which is filled now
+    size_t              used_;              // bytes used in chunks_[chunk_]
+    std::vector<iovec>  iov_;
+    size_t              bytes_;             // bytes in batch
+    uint64_t            firstNs_;           // time of oldest line in batch
+
+    Batch() : chunk_( 0 ), used_( 0 ), bytes_( 0 ), firstNs_( 0 )
+    {
+        std::lock_guard<std::mutex> lock( state_s.mutex_ );
+        state_s.batches_.push_back( this );
+    }
+
+    // Thread is finished: output what is left
+    ~Batch()
+    {
+        {
+            std::lock_guard<std::mutex> lock( state_s.mutex_ );
+            auto& batches = state_s.batches_;
+            batches.erase( std::find( batches.begin(), batches.end(), this ) );
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+        flushLocked();
+    }
+
+    // Return place for "n" bytes
+    char* reserve( size_t n )
+    {
+        if ( !chunks_.empty() && used_ + n <= chunks_[chunk_].size_ )
+            return chunks_[chunk_].data_.get() + used_;
+
+        if ( !chunks_.empty() && used_ )
+            chunk_++;
+        used_ = 0;
+        if ( chunk_ == chunks_.size() )
+            chunks_.emplace_back();
+        Chunk& chunk = chunks_[chunk_];
+        if ( chunk.size_ < n )                  // new chunk or line bigger than chunk
+        {
+            chunk.size_ = std::max( n, CHUNK_SIZE );
+            chunk.data_.reset( new char[chunk.size_] );
+        }
+        return chunk.data_.get();
+    }
+
+    void append( const char* line, size_t len )
+    {
+        char* dst = reserve( len + 1 );
+        memcpy( dst, line, len );
+        dst[len] = '\n';
+        if ( !iov_.empty() && static_cast<char*>( iov_.back().iov_base ) + iov_.back().iov_len == dst )
+            iov_.back().iov_len += len + 1;
+        else
+            iov_.push_back( iovec{ dst, len + 1 } );
+        used_ += len + 1;
+        if ( !bytes_ )
+            firstNs_ = Timing::nowNs();
+        bytes_ += len + 1;
+    }
+
+    void flushLocked()
+    {
+        if ( !bytes_ )
+            return;
+        {
+            std::lock_guard<std::mutex> lock( state_s.writeMutex_ );
+            writeAll( state_s.fd_.load(), iov_.data(), static_cast<int>( iov_.size() ) );
+        }
+        iov_.clear();
+        chunk_ = used_ = bytes_ = 0;
+    }
+};
+
+Batch& getBatch()
+{
+    static thread_local Batch batch;
+    return batch;
+}
+
+/**********************************************************************************
+   PURPOSE:   Background thread: flush batches with too old lines
+**********************************************************************************/
+void flushLoop()
+{
+    std::unique_lock<std::mutex> lock( state_s.mutex_ );
+    while ( !state_s.stop_ )
+    {
+        uint64_t now = Timing::nowNs();
+        for ( Batch* batch : state_s.batches_ )
+        {
+            std::lock_guard<std::mutex> batchLock( batch->mutex_ );
+            if ( batch->bytes_ && now - batch->firstNs_ >= state_s.intervalNs_ )
+                batch->flushLocked();
+        }
+        // check twice per interval, so line waits no more than 1.5 interval
+        int waitMs = std::max( state_s.intervalMs_ / 2, 1 );
+        state_s.cond_.wait_for( lock, std::chrono::milliseconds( waitMs ) );
+    }
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Start batching of output to "fd"
+**********************************************************************************/
+bool BatchSink::open( int fd /*=STDOUT_FILENO*/, size_t batchBytes /*=64KB*/, int flushIntervalMs /*=100*/ )
+{
+    close();
+    if ( fd < 0 || flushIntervalMs <= 0 )
+        return false;
+
+    // What is already printed should go before batched lines
+    std::cout.flush();
+    fflush( stdout );
+
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    state_s.fd_.store( fd );
+    state_s.batchBytes_.store( batchBytes );
+    state_s.intervalMs_ = flushIntervalMs;
+    state_s.intervalNs_ = static_cast<uint64_t>( flushIntervalMs ) * 1000000;
+    state_s.stop_ = false;
+    state_s.thread_ = std::thread( flushLoop );
+    active_s.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Flush batches of all threads and stop batching
+**********************************************************************************/
+void BatchSink::close()
+{
+    {
+        std::lock_guard<std::mutex> lock( state_s.mutex_ );
+        if ( !active_s.exchange( false ) )
+            return;
+        for ( Batch* batch : state_s.batches_ )
+        {
+            std::lock_guard<std::mutex> batchLock( batch->mutex_ );
+            batch->flushLocked();
+        }
+        state_s.stop_ = true;
+        state_s.cond_.notify_one();
+    }
+    state_s.thread_.join();
+}
+
+/**********************************************************************************
+   PURPOSE:   Append line to batch of current thread
+**********************************************************************************/
+void BatchSink::write( const char* line, size_t len )
+{
+    Batch& batch = getBatch();
+    std::lock_guard<std::mutex> lock( batch.mutex_ );
+    batch.append( line, len );
+    // sink could be closed right now - then nobody else will flush it
+    if ( batch.bytes_ >= state_s.batchBytes_.load( std::memory_order_relaxed )
+         || batch.iov_.size() >= static_cast<size_t>( IOV_MAX ) || !isActive() )
+        batch.flushLocked();
+}
+
+/**********************************************************************************
+   PURPOSE:   Output batch of current thread
+**********************************************************************************/
+void BatchSink::flush()
+{
+    Batch& batch = getBatch();
+    std::lock_guard<std::mutex> lock( batch.mutex_ );
+    batch.flushLocked();
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,75 @@
+#ifndef DEBUGBATCHSINK_H_
+#define DEBUGBATCHSINK_H_ 1
+
+/*********************************************************************
+  Purpose: Batched output of lines by writev() from per-thread buffers
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <unistd.h>         // STDOUT_FILENO
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Batch sink
+
+  HOWTO USE:
+     BatchSink::open();                             // stdout, 64KB batches, flush each 100ms
+     ... SENTRY_*, SAY_* as usual ...
+     {
+        BatchSink::FlushGuard guard;                // output batch of this thread at scope exit
+        ...
+     }
+     BatchSink::close();                            // output everything which left
+
+  NOTES:
+    1. While sink is active, the default handler and LOG_STDOUT copies go to
+       the sink instead of std::cout / printf(). Custom handler_s is called as usual.
+    2. Each thread collects lines into own batch ( no lock contention ).
+       Batch is written by one writev() when it has "batchBytes" of text,
+       when its oldest line is older than "flushIntervalMs", at FlushGuard scope exit,
+       at exit of thread and by close().
+    3. Lines of batch are always complete and writev() calls of all threads are
+       serialized, so lines of different threads are never mixed.
+    4. Batched lines are not seen until flush: don't use it if process could crash
+       ( see FlightRecorder ).
+******************************************************************************/
+
+class BatchSink
+{
+    public:
+        // Start batching of output to "fd". Return false if failed
+        //      batchBytes = text size which causes flush
+        //      flushIntervalMs = max age of line in batch
+        static bool open( int fd = STDOUT_FILENO, size_t batchBytes = 64 * 1024, int flushIntervalMs = 100 );
+
+        // Flush batches of all threads and stop batching
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Append line to batch of current thread ( '\n' is added )
+        static void write( const char* line, size_t len );
+
+        // Output batch of current thread right now
+        static void flush();
+
+        // Flush batch of current thread at exit of scope
+        struct FlushGuard
+        {
+            ~FlushGuard() { BatchSink::flush(); }
+        };
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,795 @@
+/*********************************************************************
+  Purpose: Binary log with deferred formatting
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>           // unique_ptr
+#include <vector>
+#include <unordered_map>
+#include <algorithm>        // stable_sort
+#include <cstdio>
+#include <cstring>          // memcpy, strlen
+#include <cwchar>           // wint_t
+
+#include "debugbinlog.h"
+#include "debuglog.h"
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+using namespace SentryLoggerFlags;
+
+namespace {
+
+const char     BINLOG_MAGIC[] = "DBGBIN2\n";
+const unsigned REC_STRING = 1;
+const unsigned REC_BLOCK  = 2;
+const unsigned LEVEL_NESTED = 0x80;
+const unsigned LEVEL_SPAN_IDS = 0x40;           // text prefix has ids ( SentryLogger::setSpanIdMode )
+const size_t   BLOCK_FLUSH_SIZE = 64 * 1024;     // flush thread buffer if it is bigger
+
+/***************************************************************************
+    Parsing of printf-like format
+    ( the same parser is used by writer to know how to take arguments
+      and by decoder to know how to print them )
+***************************************************************************/
+
+namespace tostr = ::tsv::util::tostr;
+using tostr::FormatSpec;
+using tostr::FormatArg;
+
+void parseFormat( const char* fmt, std::vector<FormatSpec>& specs )
+{
+    FormatSpec spec;
+    for ( unsigned pos = 0; fmt[pos]; pos++ )
+    {
+        if ( fmt[pos] != '%' )
+            continue;
+        if ( fmt[pos+1] == '%' )
+            pos++;
+        else if ( tostr::parseFormatSpec( fmt, pos, spec ) )
+        {
+            specs.push_back( spec );
+            pos = spec.end_ - 1;
+        }
+    }
+}
+
+/***************************************************************************
+    Varints
+***************************************************************************/
+
+inline uint8_t* putVarint( uint8_t* p, uint64_t v )
+{
+    while ( v >= 0x80 )
+    {
+        *p++ = static_cast<uint8_t>( v | 0x80 );
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>( v );
+    return p;
+}
+
+inline uint64_t zigzag( int64_t v )    { return ( static_cast<uint64_t>( v ) << 1 ) ^ static_cast<uint64_t>( v >> 63 ); }
+inline int64_t  unzigzag( uint64_t v ) { return static_cast<int64_t>( v >> 1 ) ^ -static_cast<int64_t>( v & 1 ); }
+
+bool getVarint( const uint8_t*& p, const uint8_t* end, uint64_t& v )
+{
+    v = 0;
+    for ( int shift = 0; p < end && shift < 64; shift += 7 )
+    {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>( b & 0x7f ) << shift;
+        if ( !( b & 0x80 ) )
+            return true;
+    }
+    return false;
+}
+
+/***************************************************************************
+    Dictionary of strings ( format strings, prefixes, context names )
+***************************************************************************/
+
+struct DictEntry
+{
+    uint32_t id_;
+    std::atomic<uint32_t> writtenGen_;     // generation of file where this entry was written
+    std::string text_;
+    std::vector<FormatSpec> specs_;
+    size_t argsSize_;                       // longest encoding of all arguments except strings' text
+};
+
+/***************************************************************************
+    Per-thread buffer of events
+***************************************************************************/
+
+struct ThreadBuffer
+{
+    std::atomic_flag lock_;             // owner and close() only, so it is never contended for long
+    uint32_t threadId_;
+    uint32_t gen_;                      // generation of file which buffer belongs to
+    uint64_t lastTime_;                 // time of previous event in buffer
+    size_t   size_;
+    size_t   capacity_;
+    std::unique_ptr<uint8_t[]> data_;
+
+    // thread-local caches of dictionary ( no lock needed to lookup )
+    std::unordered_map<const char*, DictEntry*> ptrCache_;
+    std::unordered_map<const char*, DictEntry*> strCache_;
+
+    ThreadBuffer() : threadId_( 0 ), gen_( 0 ), lastTime_( 0 ), size_( 0 ), capacity_( 0 )
+    {
+        lock_.clear();
+    }
+
+    // Make sure that "n" more bytes could be written
+    uint8_t* reserve( size_t n )
+    {
+        if ( size_ + n > capacity_ )
+        {
+            size_t cap = std::max( capacity_ * 2, size_ + n + BLOCK_FLUSH_SIZE );
+            std::unique_ptr<uint8_t[]> data( new uint8_t[cap] );
+            if ( size_ )
+                memcpy( data.get(), data_.get(), size_ );
+            data_.swap( data );
+            capacity_ = cap;
+        }
+        return data_.get() + size_;
+    }
+};
+
+struct SpinLock
+{
+    std::atomic_flag& flag_;
+    explicit SpinLock( std::atomic_flag& flag ) : flag_( flag )
+    {
+        while ( flag_.test_and_set( std::memory_order_acquire ) )
+            ;
+    }
+    ~SpinLock() { flag_.clear( std::memory_order_release ); }
+};
+
+/***************************************************************************
+    Global state of binary log
+
+ Lock order: registryMutex_ -> ThreadBuffer::lock_ -> fileMutex_
+***************************************************************************/
+
+struct BinLogState
+{
+    std::atomic<bool>     active_;
+    std::atomic<uint32_t> gen_;             // generation of currently opened file
+    uint64_t     epoch_;                    // time of open() ( Timing::now() ticks )
+
+    std::mutex   fileMutex_;
+    FILE*        file_;
+
+    std::mutex   dictMutex_;
+    uint32_t     lastId_;
+    std::unordered_map<const char*, DictEntry*> ptrDict_;
+    std::unordered_map<std::string, DictEntry*> strDict_;
+
+    std::mutex   registryMutex_;
+    std::vector<ThreadBuffer*> buffers_;
+
+    BinLogState() : active_( false ), gen_( 0 ), epoch_( 0 ), file_( nullptr ), lastId_( 0 ) {}
+    ~BinLogState() { BinaryLog::close(); }
+};
+
+BinLogState state_s;
+
+// Write record to file. fileMutex_ have to be locked
+void writeRecord( unsigned type, uint64_t id, const void* data, size_t len )
+{
+    uint8_t header[24];
+    uint8_t* p = header;
+    *p++ = static_cast<uint8_t>( type );
+    p = putVarint( p, id );
+    p = putVarint( p, len );
+    fwrite( header, 1, p - header, state_s.file_ );
+    fwrite( data, 1, len, state_s.file_ );
+}
+
+// Write content of buffer as a block of events. Buffer lock have to be taken
+void flushBuffer( ThreadBuffer* tb )
+{
+    if ( !tb->size_ )
+        return;
+    {
+        std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+        if ( state_s.file_ && tb->gen_ == state_s.gen_.load() )
+            writeRecord( REC_BLOCK, tb->threadId_, tb->data_.get(), tb->size_ );
+    }
+    tb->size_ = 0;
+    tb->lastTime_ = 0;
+}
+
+// Make sure that dictionary entry is written to file of generation "gen"
+void ensureWritten( DictEntry* entry, uint32_t gen )
+{
+    if ( entry->writtenGen_.load( std::memory_order_acquire ) == gen )
+        return;
+    std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+    if ( entry->writtenGen_.load( std::memory_order_relaxed ) == gen || !state_s.file_ )
+        return;
+    writeRecord( REC_STRING, entry->id_, entry->text_.data(), entry->text_.size() );
+    entry->writtenGen_.store( gen, std::memory_order_release );
+}
+
+// Longest encoding of one argument (except strings)
+const size_t MAX_ARG_SIZE = 10;
+
+DictEntry* newEntry( const char* text, size_t len )
+{
+    DictEntry* entry = new DictEntry();
+    entry->id_ = ++state_s.lastId_;
+    entry->writtenGen_.store( 0 );
+    entry->text_.assign( text, len );
+    parseFormat( entry->text_.c_str(), entry->specs_ );
+    entry->argsSize_ = 0;
+    for ( const FormatSpec& spec : entry->specs_ )
+        entry->argsSize_ += ( 1 + spec.stars_ ) * MAX_ARG_SIZE;     // each '*' takes one more argument
+    return entry;
+}
+
+// Find entry of static string (prefix)
+DictEntry* lookupPtr( ThreadBuffer* tb, const char* str )
+{
+    auto it = tb->ptrCache_.find( str );
+    if ( it != tb->ptrCache_.end() )
+        return it->second;
+
+    std::lock_guard<std::mutex> lock( state_s.dictMutex_ );
+    DictEntry*& entry = state_s.ptrDict_[ str ];
+    if ( !entry )
+        entry = newEntry( str, strlen( str ) );
+    tb->ptrCache_[ str ] = entry;
+    return entry;
+}
+
+// Find entry of string by its content (format or context name)
+//  String could come from any buffer ( vwrite() and print_event() are public,
+//  context name is not copied ), so pointer is only a hint: cached entry
+//  is taken if its text still matches, otherwise entry is found by content.
+DictEntry* lookupStr( ThreadBuffer* tb, const char* str )
+{
+    DictEntry*& cached = tb->strCache_[ str ];
+    if ( cached && !strcmp( cached->text_.c_str(), str ) )
+        return cached;
+
+    std::lock_guard<std::mutex> lock( state_s.dictMutex_ );
+    DictEntry*& entry = state_s.strDict_[ str ];
+    if ( !entry )
+        entry = newEntry( str, strlen( str ) );
+    cached = entry;
+    return entry;
+}
+
+// Owner of per-thread buffer. Flush and unregister it on thread exit
+struct ThreadBufferHolder
+{
+    ThreadBuffer* tb_;
+    ThreadBufferHolder() : tb_( nullptr ) {}
+    ~ThreadBufferHolder()
+    {
+        if ( !tb_ )
+            return;
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        {
+            SpinLock spin( tb_->lock_ );
+            flushBuffer( tb_ );
+        }
+        state_s.buffers_.erase( std::find( state_s.buffers_.begin(), state_s.buffers_.end(), tb_ ) );
+        delete tb_;
+    }
+};
+
+ThreadBuffer* threadBuffer()
+{
+    static thread_local ThreadBufferHolder holder;
+    if ( !holder.tb_ )
+    {
+        holder.tb_ = new ThreadBuffer();
+        holder.tb_->threadId_ = SentryLogger::getThreadId();
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        state_s.buffers_.push_back( holder.tb_ );
+    }
+    return holder.tb_;
+}
+
+/***************************************************************************
+    Sources of event arguments
+***************************************************************************/
+
+// C variadic arguments
+struct VaReader
+{
+    va_list& ap_;
+
+    explicit VaReader( va_list& ap ) : ap_( ap ) {}
+
+    int                getInt()    { return va_arg( ap_, int ); }
+    unsigned           getUInt()   { return va_arg( ap_, unsigned ); }
+    long long          getInt64()  { return va_arg( ap_, long long ); }
+    unsigned long long getUInt64() { return va_arg( ap_, unsigned long long ); }
+    const void*        getPtr()    { return va_arg( ap_, void* ); }
+    void               skip()      { va_arg( ap_, void* ); }
+    double getDouble( bool isLong ) { return isLong ? static_cast<double>( va_arg( ap_, long double ) ) : va_arg( ap_, double ); }
+    void getStr( bool isWide, const char*& s, const wchar_t*& ws )
+    {
+        if ( isWide )
+            ws = va_arg( ap_, const wchar_t* );
+        else
+            s = va_arg( ap_, const char* );
+    }
+};
+
+// Typed arguments ( value is converted to what conversion expects,
+//                   missed arguments are treated as zero )
+struct TypedReader
+{
+    const FormatArg* cur_;
+    const FormatArg* end_;
+    char buf_[64];              // number printed for %s
+
+    TypedReader( const FormatArg* args, size_t count ) : cur_( args ), end_( args + count ) {}
+
+    const FormatArg* next() { return ( cur_ < end_ ) ? cur_++ : nullptr; }
+
+    unsigned long long getUInt64()
+    {
+        const FormatArg* arg = next();
+        if ( !arg )
+            return 0;
+        switch ( arg->type_ )
+        {
+            case FormatArg::ARG_INT:    return static_cast<unsigned long long>( arg->int_ );
+            case FormatArg::ARG_UINT:   return arg->uint_;
+            case FormatArg::ARG_DOUBLE: return static_cast<unsigned long long>( static_cast<long long>( arg->double_ ) );
+            case FormatArg::ARG_PTR:    return reinterpret_cast<uintptr_t>( arg->ptr_ );
+            default:                    return 0;
+        }
+    }
+    int                getInt()    { return static_cast<int>( getUInt64() ); }
+    unsigned           getUInt()   { return static_cast<unsigned>( getUInt64() ); }
+    long long          getInt64()  { return static_cast<long long>( getUInt64() ); }
+    const void*        getPtr()    { return reinterpret_cast<const void*>( static_cast<uintptr_t>( getUInt64() ) ); }
+    void               skip()      { next(); }
+    double getDouble( bool )
+    {
+        const FormatArg* arg = next();
+        if ( !arg )
+            return 0.0;
+        switch ( arg->type_ )
+        {
+            case FormatArg::ARG_INT:    return static_cast<double>( arg->int_ );
+            case FormatArg::ARG_UINT:   return static_cast<double>( arg->uint_ );
+            case FormatArg::ARG_DOUBLE: return arg->double_;
+            default:                    return 0.0;
+        }
+    }
+    void getStr( bool, const char*& s, const wchar_t*& )
+    {
+        const FormatArg* arg = next();
+        if ( !arg )
+            return;
+        switch ( arg->type_ )
+        {
+            case FormatArg::ARG_STR:    s = arg->str_; return;
+            case FormatArg::ARG_INT:    snprintf( buf_, sizeof(buf_), "%lld", arg->int_ ); break;
+            case FormatArg::ARG_UINT:   snprintf( buf_, sizeof(buf_), "%llu", arg->uint_ ); break;
+            case FormatArg::ARG_DOUBLE: snprintf( buf_, sizeof(buf_), "%g", arg->double_ ); break;
+            case FormatArg::ARG_PTR:    snprintf( buf_, sizeof(buf_), "%p", arg->ptr_ ); break;
+        }
+        s = buf_;
+    }
+};
+
+// Store event into per-thread buffer
+template<typename Reader>
+void writeEvent( int level, int depth, const char* context, bool isNested,
+                 const SpanContext& span, uint64_t parentSpanId,
+                 const char* prefix, const char* format, Reader& reader )
+{
+    ThreadBuffer* tb = threadBuffer();
+    uint64_t now = Timing::toNs( Timing::now() - state_s.epoch_ );
+
+    DictEntry* fmt = lookupStr( tb, format );
+    DictEntry* pfx = ( prefix && prefix[0] ) ? lookupPtr( tb, prefix ) : nullptr;
+    DictEntry* ctx = context[0] ? lookupStr( tb, context ) : nullptr;
+
+    SpinLock spin( tb->lock_ );
+    uint32_t gen = state_s.gen_.load( std::memory_order_relaxed );
+    if ( tb->gen_ != gen )
+    {
+        // buffer has data of previous file (if any) - drop it
+        tb->gen_ = gen;
+        tb->size_ = 0;
+        tb->lastTime_ = 0;
+    }
+    ensureWritten( fmt, gen );
+    if ( pfx )
+        ensureWritten( pfx, gen );
+    if ( ctx )
+        ensureWritten( ctx, gen );
+
+    // Header of event
+    uint8_t* p = tb->reserve( 1 + 8 * 10 + fmt->argsSize_ );
+    *p++ = static_cast<uint8_t>( ( level & LOG_ALL ) | ( isNested ? LEVEL_NESTED : 0 )
+                                 | ( SentryLogger::isSpanIdMode() ? LEVEL_SPAN_IDS : 0 ) );
+    p = putVarint( p, depth );
+    p = putVarint( p, now - tb->lastTime_ );
+    p = putVarint( p, fmt->id_ );
+    p = putVarint( p, ctx ? ctx->id_ : 0 );
+    p = putVarint( p, pfx ? pfx->id_ : 0 );
+    p = putVarint( p, span.traceId_ );
+    p = putVarint( p, span.spanId_ );
+    p = putVarint( p, parentSpanId );
+    tb->lastTime_ = now;
+
+    // Raw arguments
+    for ( const FormatSpec& spec : fmt->specs_ )
+    {
+        for ( int i = 0; i < spec.stars_; i++ )
+            p = putVarint( p, zigzag( reader.getInt() ) );
+
+        switch ( spec.kind_ )
+        {
+            case tostr::FMT_INT:   p = putVarint( p, zigzag( reader.getInt() ) ); break;
+            case tostr::FMT_UINT:  p = putVarint( p, reader.getUInt() ); break;
+            case tostr::FMT_INT64: p = putVarint( p, zigzag( reader.getInt64() ) ); break;
+            case tostr::FMT_UINT64:p = putVarint( p, reader.getUInt64() ); break;
+            case tostr::FMT_PTR:   p = putVarint( p, reinterpret_cast<uintptr_t>( reader.getPtr() ) ); break;
+            case tostr::FMT_NONE:  reader.skip(); break;
+            case tostr::FMT_DOUBLE:
+            case tostr::FMT_LDOUBLE:
+            {
+                double d = reader.getDouble( spec.kind_ == tostr::FMT_LDOUBLE );
+                memcpy( p, &d, sizeof(d) );
+                p += sizeof(d);
+                break;
+            }
+            case tostr::FMT_STR:
+            case tostr::FMT_WSTR:
+            {
+                // Strings are copied as is, so they could be printed after the source is gone
+                // (len+1 to distinguish nullptr)
+                const char* s = nullptr;
+                const wchar_t* ws = nullptr;
+                reader.getStr( spec.kind_ == tostr::FMT_WSTR, s, ws );
+                size_t len = s ? strlen( s ) : ( ws ? wcslen( ws ) : 0 );
+
+                // grow buffer keeping already written part of event
+                size_t used = p - tb->data_.get() - tb->size_;
+                tb->size_ += used;
+                p = tb->reserve( len + MAX_ARG_SIZE + fmt->argsSize_ );
+                tb->size_ -= used;
+
+                p = putVarint( p, ( s || ws ) ? len + 1 : 0 );
+                if ( s )
+                {
+                    memcpy( p, s, len );
+                    p += len;
+                }
+                for ( size_t i = 0; ws && i < len; i++ )
+                    *p++ = ( ws[i] < 0x80 ) ? static_cast<char>( ws[i] ) : '?';
+                break;
+            }
+        }
+    }
+
+    tb->size_ = p - tb->data_.get();
+    if ( tb->size_ >= BLOCK_FLUSH_SIZE )
+        flushBuffer( tb );
+}
+
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Open binary log file
+**********************************************************************************/
+bool BinaryLog::open( const char* path )
+{
+    close();
+
+    FILE* file = fopen( path, "wb" );
+    if ( !file )
+        return false;
+
+    uint64_t wallTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch() ).count();
+    uint8_t header[16];
+    memcpy( header, BINLOG_MAGIC, 8 );
+    for ( int i = 0; i < 8; i++ )
+        header[8+i] = static_cast<uint8_t>( wallTime >> ( i * 8 ) );
+    fwrite( header, 1, sizeof(header), file );
+
+    std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+    state_s.file_ = file;
+    state_s.epoch_ = Timing::now();
+    state_s.gen_.fetch_add( 1 );
+    state_s.active_.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Flush buffers of all threads and close file
+**********************************************************************************/
+void BinaryLog::close()
+{
+    if ( !state_s.active_.exchange( false ) )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        for ( auto tb : state_s.buffers_ )
+        {
+            SpinLock spin( tb->lock_ );
+            flushBuffer( tb );
+        }
+    }
+
+    std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+    if ( state_s.file_ )
+        fclose( state_s.file_ );
+    state_s.file_ = nullptr;
+}
+
+bool BinaryLog::isActive()
+{
+    return state_s.active_.load( std::memory_order_acquire );
+}
+
+/**********************************************************************************
+   PURPOSE:   Store event into per-thread buffer
+**********************************************************************************/
+void BinaryLog::write( int level, int depth, const char* context, bool isNested,
+                       const SpanContext& span, uint64_t parentSpanId,
+                       const char* prefix, const char* format, va_list* args )
+{
+    VaReader reader( *args );
+    writeEvent( level, depth, context, isNested, span, parentSpanId, prefix, format, reader );
+}
+
+void BinaryLog::write( int level, int depth, const char* context, bool isNested,
+                       const SpanContext& span, uint64_t parentSpanId,
+                       const char* prefix, const char* format, const FormatArg* args, size_t count )
+{
+    TypedReader reader( args, count );
+    writeEvent( level, depth, context, isNested, span, parentSpanId, prefix, format, reader );
+}
+
+/**********************************************************************************
+   PURPOSE:   Decode binary log to text
+**********************************************************************************/
+bool BinaryLog::decode( const char* path, std::ostream& out, bool withTime /*=false*/, bool withIds /*=false*/ )
+{
+    FILE* file = fopen( path, "rb" );
+    if ( !file )
+        return false;
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ( ( n = fread( chunk, 1, sizeof(chunk), file ) ) > 0 )
+        data.insert( data.end(), chunk, chunk + n );
+    fclose( file );
+
+    if ( data.size() < 16 || memcmp( data.data(), BINLOG_MAGIC, 8 ) )
+        return false;
+
+    struct Entry
+    {
+        std::string text_;
+        std::vector<FormatSpec> specs_;
+    };
+    std::unordered_map<uint64_t, Entry> dict;
+
+    struct Line
+    {
+        uint64_t time_;
+        std::string text_;
+    };
+    std::vector<Line> lines;
+
+    const uint8_t* p = data.data() + 16;
+    const uint8_t* end = data.data() + data.size();
+    char buf[512];
+    bool ok = true;
+    while ( p < end && ok )
+    {
+        unsigned type = *p++;
+        uint64_t id, len;
+        if ( !getVarint( p, end, id ) || !getVarint( p, end, len ) || len > static_cast<uint64_t>( end - p ) )
+            break;          // truncated tail
+        const uint8_t* recEnd = p + len;
+
+        if ( type == REC_STRING )
+        {
+            Entry& entry = dict[id];
+            entry.text_.assign( reinterpret_cast<const char*>( p ), len );
+            parseFormat( entry.text_.c_str(), entry.specs_ );
+            p = recEnd;
+            continue;
+        }
+        if ( type != REC_BLOCK )
+        {
+            p = recEnd;
+            continue;
+        }
+
+        // Block of events of thread "id"
+        uint64_t time = 0;
+        while ( p < recEnd && ok )
+        {
+            unsigned level = *p++;
+            uint64_t depth, delta, fmtId, ctxId, pfxId, traceId, spanId, parentSpanId;
+            if ( !getVarint( p, recEnd, depth ) || !getVarint( p, recEnd, delta ) || !getVarint( p, recEnd, fmtId ) ||
+                 !getVarint( p, recEnd, ctxId ) || !getVarint( p, recEnd, pfxId ) ||
+                 !getVarint( p, recEnd, traceId ) || !getVarint( p, recEnd, spanId ) || !getVarint( p, recEnd, parentSpanId ) )
+            {
+                ok = false;
+                break;
+            }
+            time += delta;
+
+            Line line;
+            line.time_ = time;
+            std::string& s = line.text_;
+            if ( withTime )
+            {
+                snprintf( buf, sizeof(buf), "%llu.%09llu ", static_cast<unsigned long long>( time / 1000000000 ),
+                                                             static_cast<unsigned long long>( time % 1000000000 ) );
+                s += buf;
+            }
+
+            // Prefix the same as text mode has
+            snprintf( buf, sizeof(buf), "[DBG]T%llu ", static_cast<unsigned long long>( id ) );
+            s += buf;
+            if ( withIds )
+            {
+                snprintf( buf, sizeof(buf), "%016llx:%016llx:%016llx ", static_cast<unsigned long long>( traceId ),
+                          static_cast<unsigned long long>( spanId ), static_cast<unsigned long long>( parentSpanId ) );
+                s += buf;
+            }
+            else if ( level & LEVEL_SPAN_IDS )
+            {
+                snprintf( buf, sizeof(buf), "%016llx:%016llx ", static_cast<unsigned long long>( traceId ),
+                          static_cast<unsigned long long>( spanId ) );
+                s += buf;
+            }
+            if ( level & LEVEL_NESTED )
+            {
+                snprintf( buf, sizeof(buf), "%02d", static_cast<int>( depth ) );
+                s += buf;
+                char indent = ' ';
+                if ( ( level & LOG_ALL ) == LOG_ENTER )
+                    indent = '>';
+                else if ( ( level & LOG_ALL ) == LOG_LEAVE )
+                    indent = '<';
+                s.append( depth, indent );
+            }
+            if ( ctxId )
+                s += "{" + dict[ctxId].text_ + "}";
+            s += " ";
+            if ( pfxId )
+                s += dict[pfxId].text_;
+
+            // Message: print each conversion with its own raw argument
+            const Entry& fmt = dict[fmtId];
+            const char* f = fmt.text_.c_str();
+            size_t pos = 0;
+            for ( const FormatSpec& spec : fmt.specs_ )
+            {
+                for ( ; pos < spec.start_; pos++ )
+                {
+                    s += f[pos];
+                    if ( f[pos] == '%' && f[pos+1] == '%' )
+                        pos++;
+                }
+
+                int stars[2] = { 0, 0 };
+                for ( int i = 0; i < spec.stars_ && ok; i++ )
+                {
+                    uint64_t v;
+                    ok = getVarint( p, recEnd, v );
+                    if ( i < 2 )
+                        stars[i] = static_cast<int>( unzigzag( v ) );
+                }
+
+                // Rebuild conversion with length modifier which match stored value
+                std::string conv( f + spec.start_, spec.modifier_ - spec.start_ );
+                switch ( spec.kind_ )
+                {
+                    case tostr::FMT_INT64: case tostr::FMT_UINT64: conv += "ll"; break;
+                    case tostr::FMT_LDOUBLE: conv += "L"; break;
+                    case tostr::FMT_INT: case tostr::FMT_UINT: conv.append( f + spec.modifier_, spec.end_ - 1 - spec.modifier_ ); break;
+                }
+                conv += ( spec.kind_ == tostr::FMT_WSTR ) ? 's' : spec.conv_;
+
+                std::string strArg;
+                uint64_t v = 0;
+                double d = 0.0;
+                if ( spec.kind_ == tostr::FMT_DOUBLE || spec.kind_ == tostr::FMT_LDOUBLE )
+                {
+                    if ( recEnd - p < static_cast<long>( sizeof(d) ) )
+                        ok = false;
+                    else
+                    {
+                        memcpy( &d, p, sizeof(d) );
+                        p += sizeof(d);
+                    }
+                }
+                else if ( spec.kind_ == tostr::FMT_STR || spec.kind_ == tostr::FMT_WSTR )
+                {
+                    ok = ok && getVarint( p, recEnd, v ) && ( v == 0 || v - 1 <= static_cast<uint64_t>( recEnd - p ) );
+                    if ( ok && v )
+                    {
+                        strArg.assign( reinterpret_cast<const char*>( p ), v - 1 );
+                        p += v - 1;
+                    }
+                }
+                else if ( spec.kind_ != tostr::FMT_NONE )
+                    ok = ok && getVarint( p, recEnd, v );
+                if ( !ok )
+                    break;
+
+                // Print single conversion
+                std::vector<char> out( 64 );
+                for ( int attempt = 0; attempt < 2; attempt++ )
+                {
+                    int n = 0;
+                    const char* c = conv.c_str();
+                    #define BINLOG_PRINT( value ) \
+                        ( spec.stars_ == 0 ? snprintf( out.data(), out.size(), c, value ) : \
+                          spec.stars_ == 1 ? snprintf( out.data(), out.size(), c, stars[0], value ) : \
+                                             snprintf( out.data(), out.size(), c, stars[0], stars[1], value ) )
+                    switch ( spec.kind_ )
+                    {
+                        case tostr::FMT_INT:    n = BINLOG_PRINT( static_cast<int>( unzigzag( v ) ) ); break;
+                        case tostr::FMT_UINT:   n = BINLOG_PRINT( static_cast<unsigned>( v ) ); break;
+                        case tostr::FMT_INT64:  n = BINLOG_PRINT( static_cast<long long>( unzigzag( v ) ) ); break;
+                        case tostr::FMT_UINT64: n = BINLOG_PRINT( static_cast<unsigned long long>( v ) ); break;
+                        case tostr::FMT_PTR:    n = BINLOG_PRINT( reinterpret_cast<void*>( static_cast<uintptr_t>( v ) ) ); break;
+                        case tostr::FMT_DOUBLE: n = BINLOG_PRINT( d ); break;
+                        case tostr::FMT_LDOUBLE:n = BINLOG_PRINT( static_cast<long double>( d ) ); break;
+                        case tostr::FMT_STR:
+                        case tostr::FMT_WSTR:   n = BINLOG_PRINT( v ? strArg.c_str() : static_cast<const char*>( nullptr ) ); break;
+                        default:         out[0] = 0; break;
+                    }
+                    #undef BINLOG_PRINT
+                    if ( n < static_cast<int>( out.size() ) )
+                        break;
+                    out.resize( n + 1 );
+                }
+                s += out.data();
+                pos = spec.end_;
+            }
+            for ( ; ok && f[pos]; pos++ )
+            {
+                s += f[pos];
+                if ( f[pos] == '%' && f[pos+1] == '%' )
+                    pos++;
+            }
+
+            lines.push_back( std::move( line ) );
+        }
+        p = recEnd;
+    }
+
+    // Blocks of different threads are interleaved - restore order by time
+    std::stable_sort( lines.begin(), lines.end(),
+                      []( const Line& a, const Line& b ) { return a.time_ < b.time_; } );
+    for ( const Line& line : lines )
+        out << line.text_ << "\n";
+    return true;
+}
+
+}   // namespace debug
+}   // namespace tsv
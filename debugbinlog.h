@@ -0,0 +1,90 @@
+#ifndef DEBUGBINLOG_H_
+#define DEBUGBINLOG_H_ 1
+
+/*********************************************************************
+  Purpose: Binary log with deferred formatting
+           ( hot path stores only id of format string and raw
+             arguments, text is produced later by decoder )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <cstdarg>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include "tostr_handler.h"
+
+namespace tsv {
+namespace debug {
+
+struct SpanContext;
+
+/******************************************************************************
+  Binary logging mode
+
+  HOWTO USE:
+     BinaryLog::open( "/tmp/app.dbglog" );   // from now output goes to binary file
+     ... SENTRY_*, SAY_* as usual ...
+     BinaryLog::close();                     // flush buffers of all threads
+
+     Decode it later:  debuglog_decode /tmp/app.dbglog
+                  or:  BinaryLog::decode( "/tmp/app.dbglog", std::cout );
+
+  NOTES:
+    1. While binary log is open, text output (handler_s, LOG_STDOUT) is not produced.
+    2. Prefixes are remembered by pointer, so they have to be string literals.
+       Format strings are cached by pointer too, but cached text is compared
+       with the format, so format could be built in any buffer.
+    3. Each string (format, context name) is written to file only once,
+       event refers to it by id.
+    4. Events are collected into per-thread buffers and flushed by blocks,
+       so the order of events of different threads is restored by timestamp.
+
+  FILE FORMAT ( all integers are LEB128 varints unless said otherwise ):
+     header:  "DBGBIN2\n", u64 wall-clock time of open() in ns (little endian)
+     records: u8 REC_STRING, id, len, bytes[len]        - dictionary entry
+              u8 REC_BLOCK,  thread_id, len, bytes[len] - block of events of one thread
+     event:   u8 level (LOG_* | 0x80 if nested mode | 0x40 if span id mode), depth, time delta in ns
+              ( from previous event of the block ), format_id, context_id, prefix_id,
+              trace_id, span_id, parent_span_id ( 0 if there is no sentry ),
+              arguments ( in order of format conversions: zigzag varint for signed,
+              varint for unsigned/pointer, 8 bytes double, len+bytes for %s )
+******************************************************************************/
+
+class BinaryLog
+{
+    public:
+        // Start binary logging into file "path". Return false if failed
+        static bool open( const char* path );
+
+        // Flush buffers of all threads and close file
+        static void close();
+
+        static bool isActive();
+
+        // Store event ( called by SentryLogger instead of text output )
+        //      span, parentSpanId = ids of sentry of event ( as LogRecord has )
+        //      args = C variadic arguments of format
+        static void write( int level, int depth, const char* context, bool isNested,
+                           const SpanContext& span, uint64_t parentSpanId,
+                           const char* prefix, const char* format, va_list* args );
+
+        //      args = typed arguments ( converted to what format conversion expects )
+        static void write( int level, int depth, const char* context, bool isNested,
+                           const SpanContext& span, uint64_t parentSpanId,
+                           const char* prefix, const char* format,
+                           const ::tsv::util::tostr::FormatArg* args, size_t count );
+
+        // Decode binary log "path" into text lines
+        //      withTime = if true, then prefix each line with time since open
+        //      withIds  = if true, then each line has "trace:span:parent" ids, otherwise
+        //                 "trace:span" is shown only if it was on in text mode ( setSpanIdMode )
+        static bool decode( const char* path, std::ostream& out, bool withTime = false, bool withIds = false );
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,250 @@
+/*********************************************************************
+  Purpose: Per-callsite runtime enable flags of SENTRY_*, SAY_* macros
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "debugcallsite.h"
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+// Registered callsites and rules
+struct CallSiteRegistry
+{
+    struct Rule
+    {
+        bool         byFile_;
+        std::string  pattern_;
+        bool         isSampling_;       // true = rule sets policy_, false = rule sets enable_
+        bool         enable_;
+        SamplePolicy policy_;
+    };
+
+    std::mutex        mutex_;
+    CallSite*         head_;
+    size_t            count_;
+    std::vector<Rule> rules_;
+
+    CallSiteRegistry() : head_( nullptr ), count_( 0 ) {}
+
+    // Apply rules to callsite. mutex_ have to be locked
+    void apply( CallSite* site )
+    {
+        bool enabled = true;
+        SamplePolicy policy = site->defaultPolicy_;
+        for ( const Rule& rule : rules_ )
+            if ( CallSite::matchPattern( rule.pattern_.c_str(), rule.byFile_ ? site->file_ : site->func_ ) )
+            {
+                if ( rule.isSampling_ )
+                    policy = rule.policy_;
+                else
+                    enabled = rule.enable_;
+            }
+
+        // New policy starts counting from scratch
+        if ( site->policy_.load( std::memory_order_relaxed ) != policy.pack() )
+        {
+            site->counter_.store( 0, std::memory_order_relaxed );
+            site->policy_.store( policy.pack(), std::memory_order_relaxed );
+        }
+
+        int state = CallSite::STATE_DISABLED;
+        if ( enabled )
+            state = ( policy.kind_ == SamplePolicy::SAMPLE_ALL ) ? CallSite::STATE_ENABLED : CallSite::STATE_SAMPLED;
+        site->state_.store( state, std::memory_order_relaxed );
+    }
+
+    void addRule( const Rule& rule )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        rules_.push_back( rule );
+        for ( CallSite* site = head_; site; site = site->next_ )
+            apply( site );
+    }
+};
+
+namespace {
+
+CallSiteRegistry& registry()
+{
+    // Leaked intentionally: callsites could be called from static destructors
+    static CallSiteRegistry* registry = new CallSiteRegistry();
+    return *registry;
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Register callsite on first call and apply rules
+**********************************************************************************/
+int CallSite::resolve()
+{
+    CallSiteRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    if ( state_.load( std::memory_order_relaxed ) == STATE_UNRESOLVED )
+    {
+        next_ = reg.head_;
+        reg.head_ = this;
+        reg.count_++;
+        reg.apply( this );
+    }
+    return state_.load( std::memory_order_relaxed );
+}
+
+bool CallSite::checkSlow( int state )
+{
+    if ( state == STATE_UNRESOLVED )
+        state = resolve();
+    if ( state == STATE_SAMPLED )
+        return sample();
+    return state == STATE_ENABLED;
+}
+
+/**********************************************************************************
+   PURPOSE:   Decide if this call of sampled callsite is logged
+**********************************************************************************/
+bool CallSite::sample()
+{
+    uint64_t policy = policy_.load( std::memory_order_relaxed );
+    uint32_t param = static_cast<uint32_t>( policy );
+    bool pass = true;
+    switch ( static_cast<int>( policy >> 32 ) )
+    {
+    case SamplePolicy::SAMPLE_EVERY_N:
+        pass = ( param <= 1 ) || ( counter_.fetch_add( 1, std::memory_order_relaxed ) % param == 0 );
+        break;
+    case SamplePolicy::SAMPLE_FIRST_N:
+        // do not touch counter after limit is reached ( no contention on hot callsite )
+        pass = counter_.load( std::memory_order_relaxed ) < param &&
+               counter_.fetch_add( 1, std::memory_order_relaxed ) < param;
+        break;
+    case SamplePolicy::SAMPLE_PER_SECOND:
+    {
+        // Token bucket as GCRA: counter_ is theoretical arrival time of next call,
+        // bucket is full when it is "param" intervals behind of now
+        if ( !param )
+        {
+            pass = false;
+            break;
+        }
+        uint64_t interval = 1000000000ULL / param;
+        uint64_t burst = interval * ( param - 1 );
+        uint64_t now = Timing::nowNs() + burst;      // shifted, so tat==0 means full bucket
+        uint64_t tat = counter_.load( std::memory_order_relaxed );
+        do
+        {
+            if ( tat > now )
+            {
+                pass = false;
+                break;
+            }
+        } while ( !counter_.compare_exchange_weak( tat, ( tat + burst > now ? tat : now - burst ) + interval, std::memory_order_relaxed ) );
+        break;
+    }
+    }
+    if ( !pass )
+        suppressed_.fetch_add( 1, std::memory_order_relaxed );
+    return pass;
+}
+
+void CallSite::enableByName( const char* pattern, bool enable )
+{
+    registry().addRule( CallSiteRegistry::Rule{ false, pattern ? pattern : "", false, enable, SamplePolicy() } );
+}
+
+void CallSite::enableByFile( const char* pattern, bool enable )
+{
+    registry().addRule( CallSiteRegistry::Rule{ true, pattern ? pattern : "", false, enable, SamplePolicy() } );
+}
+
+void CallSite::sampleByName( const char* pattern, SamplePolicy policy )
+{
+    registry().addRule( CallSiteRegistry::Rule{ false, pattern ? pattern : "", true, true, policy } );
+}
+
+void CallSite::sampleByFile( const char* pattern, SamplePolicy policy )
+{
+    registry().addRule( CallSiteRegistry::Rule{ true, pattern ? pattern : "", true, true, policy } );
+}
+
+void CallSite::resetRules()
+{
+    CallSiteRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    reg.rules_.clear();
+    for ( CallSite* site = reg.head_; site; site = site->next_ )
+        reg.apply( site );
+}
+
+void CallSite::reportSuppressed( std::ostream& out )
+{
+    CallSiteRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    for ( CallSite* site = reg.head_; site; site = site->next_ )
+    {
+        uint64_t suppressed = site->getSuppressed();
+        if ( suppressed )
+            out << site->file_ << ':' << site->line_ << ' ' << site->func_ << " suppressed=" << suppressed << '\n';
+    }
+}
+
+size_t CallSite::getRegisteredCount()
+{
+    CallSiteRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    return reg.count_;
+}
+
+uint64_t CallSite::getSuppressedTotal()
+{
+    CallSiteRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    uint64_t total = 0;
+    for ( CallSite* site = reg.head_; site; site = site->next_ )
+        total += site->getSuppressed();
+    return total;
+}
+
+/**********************************************************************************
+   PURPOSE:   Glob matching of whole string
+**********************************************************************************/
+bool CallSite::matchPattern( const char* pattern, const char* str )
+{
+    const char* starPattern = nullptr;      // position after last '*'
+    const char* starStr = nullptr;          // position in str where that '*' started to match
+    while ( *str )
+    {
+        if ( *pattern == '*' )
+        {
+            starPattern = ++pattern;
+            starStr = str;
+        }
+        else if ( *pattern == '?' || *pattern == *str )
+        {
+            pattern++;
+            str++;
+        }
+        else if ( starPattern )
+        {
+            // let last '*' eat one more char
+            pattern = starPattern;
+            str = ++starStr;
+        }
+        else
+            return false;
+    }
+    while ( *pattern == '*' )
+        pattern++;
+    return !*pattern;
+}
+
+}   // namespace debug
+}   // namespace tsv
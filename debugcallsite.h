@@ -0,0 +1,156 @@
+#ifndef DEBUGCALLSITE_H_
+#define DEBUGCALLSITE_H_ 1
+
+/*********************************************************************
+  Purpose: Per-callsite runtime enable flags of SENTRY_*, SAY_* macros
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Callsite of logging macro
+
+  Each SENTRY_*, SAY_* macro expansion has own static CallSite record
+  ( constant-initialized, so it costs nothing until the first call ).
+  It is descriptor of source location: function, file, line and the id
+  ( hash of them computed at compile time, so it is stable between runs ).
+  On the first call callsite is registered and matched against the rules,
+  after that its state is cached. Disabled callsite costs one load and branch:
+  no sentry is linked, no argument is evaluated.
+
+  HOWTO USE:
+     CallSite::enableByName( "parse*", false );           // turn off all callsites in functions parse*
+     CallSite::enableByFile( "*network*", false );        // ... or in these files
+     CallSite::enableByName( "parseHeader", true );       // rules are applied in order, the last matched wins
+     CallSite::resetRules();                              // everything is enabled again
+
+  Patterns are matched as whole string, '*' = any sequence, '?' = any char.
+
+  SAMPLING:
+     Enabled callsite could log only part of its calls ( see SamplePolicy ).
+     Policy is given by *_SAMPLED macro or by runtime rule:
+        CallSite::sampleByName( "hotLoop", SamplePolicy::perSecond( 10 ) );
+        CallSite::sampleByName( "hotLoop", SamplePolicy::all() );          // back to log everything
+     Skipped call costs the same as disabled one plus sampling check:
+     no sentry, no formatting. Each callsite counts skipped calls:
+        CallSite::reportSuppressed( std::cout );
+******************************************************************************/
+
+// PURPOSE: Which calls of callsite are logged
+//=========================
+struct SamplePolicy
+{
+    enum Kind { SAMPLE_ALL = 0, SAMPLE_EVERY_N, SAMPLE_FIRST_N, SAMPLE_PER_SECOND };
+
+    int      kind_;
+    uint32_t param_;
+
+    constexpr SamplePolicy( int kind = SAMPLE_ALL, uint32_t param = 0 ) : kind_( kind ), param_( param ) {}
+
+    static constexpr SamplePolicy all()                    { return SamplePolicy(); }
+    static constexpr SamplePolicy everyN( uint32_t n )     { return SamplePolicy( SAMPLE_EVERY_N, n ); }     // 1st, (n+1)th, ...
+    static constexpr SamplePolicy firstN( uint32_t n )     { return SamplePolicy( SAMPLE_FIRST_N, n ); }
+    static constexpr SamplePolicy perSecond( uint32_t n )  { return SamplePolicy( SAMPLE_PER_SECOND, n ); }  // token bucket of n tokens
+
+    constexpr uint64_t pack() const { return ( static_cast<uint64_t>( kind_ ) << 32 ) | param_; }
+};
+
+class CallSite
+{
+    public:
+        enum State { STATE_DISABLED = 0, STATE_ENABLED = 1, STATE_UNRESOLVED = 2, STATE_SAMPLED = 3 };
+
+        constexpr CallSite( const char* func, const char* file, int line, SamplePolicy policy = SamplePolicy() )
+            : func_( func ), file_( file ), line_( line ),
+              id_( hashStr( func, ( hashStr( file, HASH_OFFSET ) ^ static_cast<uint64_t>( line ) ) * HASH_PRIME ) ),
+              defaultPolicy_( policy ), state_( STATE_UNRESOLVED ), policy_( policy.pack() ),
+              counter_( 0 ), suppressed_( 0 ), next_( nullptr ) {}
+
+        // Should this call be logged
+        bool isEnabled()
+        {
+            int state = state_.load( std::memory_order_relaxed );
+            if ( state == STATE_DISABLED )          // the only check of disabled callsite
+                return false;
+            return state == STATE_ENABLED || checkSlow( state );
+        }
+
+        const char* getFunc() const { return func_; }
+        const char* getFile() const { return file_; }
+        int         getLine() const { return line_; }
+        uint64_t    getId() const   { return id_; }
+
+        // How many calls were skipped by sampling
+        uint64_t    getSuppressed() const { return suppressed_.load( std::memory_order_relaxed ); }
+
+        // Add rule for callsites in functions which match "pattern"
+        static void enableByName( const char* pattern, bool enable );
+        // Add rule for callsites in files which match "pattern"
+        static void enableByFile( const char* pattern, bool enable );
+        // Add rule of sampling for callsites in functions/files which match "pattern"
+        static void sampleByName( const char* pattern, SamplePolicy policy );
+        static void sampleByFile( const char* pattern, SamplePolicy policy );
+        // Remove all rules ( all callsites are enabled, sampling is as given by macro )
+        static void resetRules();
+
+        // Print "file:line function suppressed=N" of each callsite which skipped some calls
+        static void reportSuppressed( std::ostream& out );
+
+        // How many callsites are registered (were called at least once)
+        static size_t getRegisteredCount();
+
+        // Sum of suppressed calls of all callsites
+        static uint64_t getSuppressedTotal();
+
+        // Simple glob matching: '*' = any sequence, '?' = any char
+        static bool matchPattern( const char* pattern, const char* str );
+
+    protected:
+        // Register callsite and apply rules. Return new state
+        int resolve();
+
+        // Unresolved or sampled callsite
+        bool checkSlow( int state );
+
+        // Decide by sampling policy
+        bool sample();
+
+        // FNV-1a
+        static constexpr uint64_t HASH_OFFSET = 14695981039346656037ULL;
+        static constexpr uint64_t HASH_PRIME  = 1099511628211ULL;
+        static constexpr uint64_t hashStr( const char* str, uint64_t hash )
+        {
+            return *str ? hashStr( str + 1, ( hash ^ static_cast<unsigned char>( *str ) ) * HASH_PRIME ) : hash;
+        }
+
+        const char*      func_;
+        const char*      file_;
+        int              line_;
+        uint64_t         id_;           // hash of func_, file_, line_
+        SamplePolicy     defaultPolicy_;    // given by macro
+        std::atomic<int> state_;            // State
+        std::atomic<uint64_t> policy_;      // current SamplePolicy::pack()
+        std::atomic<uint64_t> counter_;     // calls (EVERY_N, FIRST_N) or theoretical arrival time in ns (PER_SECOND)
+        std::atomic<uint64_t> suppressed_;  // calls skipped by sampling
+        CallSite*        next_;         // list of registered callsites
+
+        friend struct CallSiteRegistry;
+
+    private:
+        CallSite( const CallSite& );
+        CallSite& operator=( const CallSite& );
+};
+
+}
+}
+
+#endif
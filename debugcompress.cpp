@@ -0,0 +1,449 @@
+/*********************************************************************
+  Purpose: Block compression of log output ( built-in LZ codec or zlib )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "debugcompress.h"
+#include "debugfilesink.h"
+
+#if DEBUGLOG_ZLIB
+#include <zlib.h>
+#endif
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> LogCompressor::active_s( false );
+
+namespace {
+
+const char   BLOCK_MAGIC[4] = { 'D', 'L', 'Z', '1' };
+const size_t MAX_BLOCK = 64 * 1024 * 1024;      // sanity limit of decoder
+
+struct BlockHeader
+{
+    char     magic_[4];
+    uint8_t  codec_;
+    uint8_t  reserved_[3];
+    uint32_t rawSize_;
+    uint32_t packedSize_;
+    uint32_t checksum_;         // FNV-1a of raw text
+};
+static_assert( sizeof(BlockHeader) == 20, "BlockHeader is part of file format" );
+
+uint32_t checksum( const char* data, size_t len )
+{
+    uint32_t hash = 2166136261u;
+    for ( size_t i = 0; i < len; i++ )
+        hash = ( hash ^ static_cast<uint8_t>( data[i] ) ) * 16777619u;
+    return hash;
+}
+
+//=================================================================
+//  Built-in LZ codec
+//
+//  Sequence: token ( literal length:4 | match length-4:4 ), extra literal length bytes,
+//  literals, offset(2 bytes LE), extra match length bytes. Length nibble 15 means that
+//  bytes follow ( 255 - continue ). The last sequence has only literals.
+//=================================================================
+
+const int    LZ_HASH_BITS = 12;
+const size_t LZ_MIN_MATCH = 4;
+const size_t LZ_MAX_OFFSET = 65535;
+
+inline uint32_t read32( const char* p )
+{
+    uint32_t v;
+    memcpy( &v, p, 4 );
+    return v;
+}
+
+void putLength( std::string& out, size_t len )
+{
+    for ( ; len >= 255; len -= 255 )
+        out += static_cast<char>( 255 );
+    out += static_cast<char>( len );
+}
+
+void putSequence( std::string& out, const char* literals, size_t litLen, size_t offset, size_t matchLen )
+{
+    size_t m = matchLen ? matchLen - LZ_MIN_MATCH : 0;
+    out += static_cast<char>( ( ( litLen < 15 ? litLen : 15 ) << 4 ) | ( m < 15 ? m : 15 ) );
+    if ( litLen >= 15 )
+        putLength( out, litLen - 15 );
+    out.append( literals, litLen );
+    if ( !matchLen )
+        return;
+    out += static_cast<char>( offset & 0xFF );
+    out += static_cast<char>( offset >> 8 );
+    if ( m >= 15 )
+        putLength( out, m - 15 );
+}
+
+void lzCompress( const char* src, size_t len, std::string& out )
+{
+    uint32_t table[1 << LZ_HASH_BITS] = {};     // position + 1 of last 4 bytes with this hash
+    const char* end = src + len;
+    const char* anchor = src;
+    const char* ip = src;
+    while ( ip + LZ_MIN_MATCH <= end )
+    {
+        uint32_t seq = read32( ip );
+        uint32_t h = ( seq * 2654435761u ) >> ( 32 - LZ_HASH_BITS );
+        uint32_t pos = static_cast<uint32_t>( ip - src );
+        uint32_t cand = table[h];
+        table[h] = pos + 1;
+        if ( !cand || pos + 1 - cand > LZ_MAX_OFFSET || read32( src + cand - 1 ) != seq )
+        {
+            ip++;
+            continue;
+        }
+
+        const char* ref = src + cand - 1;
+        const char* m = ip + LZ_MIN_MATCH;
+        for ( const char* r = ref + LZ_MIN_MATCH; m < end && *m == *r; m++, r++ )
+            ;
+        putSequence( out, anchor, ip - anchor, ip - ref, m - ip );
+        ip = anchor = m;
+    }
+    putSequence( out, anchor, end - anchor, 0, 0 );
+}
+
+// Read extra length bytes. Return false if input is over
+bool getLength( const uint8_t*& ip, const uint8_t* end, size_t& len )
+{
+    for ( ;; )
+    {
+        if ( ip >= end )
+            return false;
+        uint8_t b = *ip++;
+        len += b;
+        if ( b != 255 )
+            return true;
+    }
+}
+
+bool lzDecompress( const char* packed, size_t packedSize, char* dst, size_t rawSize )
+{
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>( packed );
+    const uint8_t* end = ip + packedSize;
+    size_t op = 0;
+    while ( ip < end )
+    {
+        uint8_t token = *ip++;
+        size_t litLen = token >> 4;
+        if ( litLen == 15 && !getLength( ip, end, litLen ) )
+            return false;
+        if ( litLen > static_cast<size_t>( end - ip ) || litLen > rawSize - op )
+            return false;
+        memcpy( dst + op, ip, litLen );
+        ip += litLen;
+        op += litLen;
+        if ( ip == end )
+            break;                              // the last sequence
+
+        if ( end - ip < 2 )
+            return false;
+        size_t offset = ip[0] | ( ip[1] << 8 );
+        ip += 2;
+        size_t matchLen = token & 15;
+        if ( matchLen == 15 && !getLength( ip, end, matchLen ) )
+            return false;
+        matchLen += LZ_MIN_MATCH;
+        if ( !offset || offset > op || matchLen > rawSize - op )
+            return false;
+        for ( size_t i = 0; i < matchLen; i++, op++ )     // could overlap
+            dst[op] = dst[op - offset];
+    }
+    return op == rawSize;
+}
+
+// Unpack data of block into "dst" ( rawSize bytes )
+bool unpack( int codec, const char* packed, size_t packedSize, char* dst, size_t rawSize )
+{
+    switch ( codec )
+    {
+    case LogCompressor::CODEC_STORE:
+        if ( packedSize != rawSize )
+            return false;
+        memcpy( dst, packed, rawSize );
+        return true;
+    case LogCompressor::CODEC_LZ:
+        return lzDecompress( packed, packedSize, dst, rawSize );
+#if DEBUGLOG_ZLIB
+    case LogCompressor::CODEC_ZLIB:
+    {
+        uLongf size = rawSize;
+        return uncompress( reinterpret_cast<Bytef*>( dst ), &size,
+                           reinterpret_cast<const Bytef*>( packed ), packedSize ) == Z_OK && size == rawSize;
+    }
+#endif
+    }
+    return false;                               // unknown codec or zlib is not built in
+}
+
+/***************************************************************************
+    Streaming stage
+
+  Writers fill current_ under mutex, full blocks are queued to background
+  thread which compresses them in the same order and passes to FileSink.
+***************************************************************************/
+struct StageState
+{
+    std::mutex               mutex_;
+    std::string              current_;
+    std::vector<std::string> full_;             // blocks to compress
+    std::vector<std::string> spare_;            // buffers for reuse
+
+    LogCompressor::Codec     codec_;
+    size_t                   blockSize_;
+    int                      flushIntervalMs_;
+
+    std::thread              thread_;
+    std::condition_variable  cond_;
+    bool                     stop_;
+
+    StageState() : codec_( LogCompressor::CODEC_DEFAULT ), blockSize_( 0 ), flushIntervalMs_( 0 ), stop_( false ) {}
+    ~StageState() { LogCompressor::close(); }
+};
+
+StageState stage_s;
+
+// Queue current block. mutex_ have to be locked
+void queueCurrent()
+{
+    std::string next;
+    if ( !stage_s.spare_.empty() )
+    {
+        next.swap( stage_s.spare_.back() );
+        stage_s.spare_.pop_back();
+    }
+    stage_s.full_.emplace_back();
+    stage_s.full_.back().swap( stage_s.current_ );
+    stage_s.current_.swap( next );
+    stage_s.current_.reserve( stage_s.blockSize_ + 256 );
+}
+
+/**********************************************************************************
+   PURPOSE:   Background thread: compress queued blocks and write them
+**********************************************************************************/
+void compressLoop()
+{
+    std::vector<std::string> blocks;
+    std::string packed;
+    std::unique_lock<std::mutex> lock( stage_s.mutex_ );
+    for ( ;; )
+    {
+        if ( stage_s.full_.empty() && !stage_s.stop_ )
+            stage_s.cond_.wait_for( lock, std::chrono::milliseconds( stage_s.flushIntervalMs_ ) );
+
+        // Timeout or stop: partial block goes too, so file is never far behind
+        if ( stage_s.full_.empty() && !stage_s.current_.empty() )
+            queueCurrent();
+        if ( stage_s.full_.empty() && stage_s.stop_ )
+            break;
+
+        blocks.swap( stage_s.full_ );
+        lock.unlock();
+        for ( std::string& block : blocks )
+        {
+            packed.clear();
+            LogCompressor::compressBlock( block.data(), block.size(), packed, stage_s.codec_ );
+            FileSink::writeBlock( packed.data(), packed.size() );
+            block.clear();
+        }
+        lock.lock();
+        for ( std::string& block : blocks )
+            stage_s.spare_.emplace_back( std::move( block ) );
+        blocks.clear();
+    }
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Start compression of lines which go to FileSink
+**********************************************************************************/
+bool LogCompressor::open( Codec codec /*=CODEC_DEFAULT*/, size_t blockSize /*=64KB*/, int flushIntervalMs /*=1000*/ )
+{
+    close();
+    if ( !blockSize || flushIntervalMs <= 0 )
+        return false;
+#if !DEBUGLOG_ZLIB
+    if ( codec == CODEC_ZLIB )
+        return false;
+#endif
+
+    std::lock_guard<std::mutex> lock( stage_s.mutex_ );
+    stage_s.codec_ = codec;
+    stage_s.blockSize_ = blockSize;
+    stage_s.flushIntervalMs_ = flushIntervalMs;
+    stage_s.current_.clear();
+    stage_s.current_.reserve( blockSize + 256 );
+    stage_s.stop_ = false;
+    stage_s.thread_ = std::thread( compressLoop );
+    active_s.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Write what is left and stop compression
+**********************************************************************************/
+void LogCompressor::close()
+{
+    {
+        std::lock_guard<std::mutex> lock( stage_s.mutex_ );
+        if ( !active_s.exchange( false ) )
+            return;
+        stage_s.stop_ = true;
+        stage_s.cond_.notify_one();
+    }
+    stage_s.thread_.join();
+}
+
+/**********************************************************************************
+   PURPOSE:   Append line to current block
+**********************************************************************************/
+void LogCompressor::write( const char* line, size_t len )
+{
+    std::lock_guard<std::mutex> lock( stage_s.mutex_ );
+    if ( stage_s.stop_ )
+        return;
+    stage_s.current_.append( line, len ).append( 1, '\n' );
+    if ( stage_s.current_.size() >= stage_s.blockSize_ )
+    {
+        queueCurrent();
+        stage_s.cond_.notify_one();
+    }
+}
+
+/**********************************************************************************
+   PURPOSE:   Append to "out" framed block with compressed "data"
+**********************************************************************************/
+void LogCompressor::compressBlock( const char* data, size_t len, std::string& out, Codec codec /*=CODEC_DEFAULT*/ )
+{
+    size_t headerPos = out.size();
+    out.resize( headerPos + sizeof(BlockHeader) );
+
+    switch ( codec )
+    {
+    case CODEC_LZ:
+        lzCompress( data, len, out );
+        break;
+#if DEBUGLOG_ZLIB
+    case CODEC_ZLIB:
+    {
+        uLongf size = compressBound( len );
+        out.resize( headerPos + sizeof(BlockHeader) + size );
+        if ( compress2( reinterpret_cast<Bytef*>( &out[headerPos + sizeof(BlockHeader)] ), &size,
+                        reinterpret_cast<const Bytef*>( data ), len, Z_BEST_SPEED ) == Z_OK )
+        {
+            out.resize( headerPos + sizeof(BlockHeader) + size );
+            break;
+        }
+        out.resize( headerPos + sizeof(BlockHeader) );
+        codec = CODEC_STORE;
+        out.append( data, len );
+        break;
+    }
+#endif
+    default:
+        codec = CODEC_STORE;
+        out.append( data, len );
+        break;
+    }
+
+    // Incompressible text is stored as is
+    size_t packedSize = out.size() - headerPos - sizeof(BlockHeader);
+    if ( codec != CODEC_STORE && packedSize >= len )
+    {
+        out.resize( headerPos + sizeof(BlockHeader) );
+        out.append( data, len );
+        codec = CODEC_STORE;
+        packedSize = len;
+    }
+
+    BlockHeader header;
+    memcpy( header.magic_, BLOCK_MAGIC, sizeof(BLOCK_MAGIC) );
+    header.codec_ = static_cast<uint8_t>( codec );
+    memset( header.reserved_, 0, sizeof(header.reserved_) );
+    header.rawSize_ = static_cast<uint32_t>( len );
+    header.packedSize_ = static_cast<uint32_t>( packedSize );
+    header.checksum_ = checksum( data, len );
+    memcpy( &out[headerPos], &header, sizeof(header) );
+}
+
+/**********************************************************************************
+   PURPOSE:   Decode sequence of blocks into text
+**********************************************************************************/
+bool LogCompressor::decompress( std::istream& in, std::ostream& out )
+{
+    std::vector<char> packed, raw;
+    for ( ;; )
+    {
+        BlockHeader header;
+        in.read( reinterpret_cast<char*>( &header ), sizeof(header) );
+        if ( in.gcount() == 0 )
+            return true;                        // end of stream right after block
+        if ( in.gcount() != sizeof(header) || memcmp( header.magic_, BLOCK_MAGIC, sizeof(BLOCK_MAGIC) ) )
+            return false;                       // truncated ( or zero tail of unfinished file )
+        if ( header.rawSize_ > MAX_BLOCK || header.packedSize_ > MAX_BLOCK )
+            return false;
+
+        packed.resize( header.packedSize_ );
+        raw.resize( header.rawSize_ );
+        in.read( packed.data(), packed.size() );
+        if ( static_cast<size_t>( in.gcount() ) != packed.size() ||
+             !unpack( header.codec_, packed.data(), packed.size(), raw.data(), raw.size() ) ||
+             checksum( raw.data(), raw.size() ) != header.checksum_ )
+            return false;
+        out.write( raw.data(), raw.size() );
+    }
+}
+
+/**********************************************************************************
+   PURPOSE:   Compress whole file "src" into "dst"
+**********************************************************************************/
+bool LogCompressor::compressFile( const char* src, const char* dst, Codec codec /*=CODEC_DEFAULT*/ )
+{
+    std::ifstream in( src, std::ios::binary );
+    std::ofstream out( dst, std::ios::binary | std::ios::trunc );
+    if ( !in || !out )
+        return false;
+
+    // Blocks of the same size as streaming stage gives
+    std::vector<char> data( 64 * 1024 );
+    std::string packed;
+    while ( in )
+    {
+        in.read( data.data(), data.size() );
+        if ( in.gcount() <= 0 )
+            break;
+        packed.clear();
+        compressBlock( data.data(), in.gcount(), packed, codec );
+        out.write( packed.data(), packed.size() );
+    }
+    out.close();
+    return !in.bad() && !out.fail();
+}
+
+/**********************************************************************************
+   PURPOSE:   True if "data" starts with block header
+**********************************************************************************/
+bool LogCompressor::isCompressed( const char* data, size_t len )
+{
+    return len >= sizeof(BLOCK_MAGIC) && !memcmp( data, BLOCK_MAGIC, sizeof(BLOCK_MAGIC) );
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,96 @@
+#ifndef DEBUGCOMPRESS_H_
+#define DEBUGCOMPRESS_H_ 1
+
+/*********************************************************************
+  Purpose: Block compression of log output ( built-in LZ codec or zlib )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Compression of log
+
+  HOWTO USE:
+     FileSink::open( "/var/log/app.dbg" );
+     LogCompressor::open();                         // lines go to file as compressed blocks
+     ... SENTRY_*, SAY_* as usual ...
+     LogCompressor::close();                        // compress and write the last block
+     FileSink::close();
+
+     Read:  tools/dlzcat /var/log/app.dbg*          ( or LogCompressor::decompress() )
+
+  NOTES:
+    1. Lines are collected into blocks of "blockSize" text bytes. Background thread
+       compresses full blocks ( and partial one each "flushIntervalMs" ) and passes
+       them to FileSink. So writer only copies line to buffer under short lock.
+    2. Each block is self-contained and has header with checksum. If file is truncated
+       ( crash, disk full ), it is decoded up to the last complete block.
+       Each rotated file is decoded separately.
+    3. CODEC_ZLIB is available if library is built with -DDEBUGLOG_ZLIB=1 ( and -lz ),
+       otherwise built-in fast LZ codec is used. Decoder understands both.
+    4. Rotated plain text files could be compressed instead in background:
+       FileSink::open( ..., compressRotated = true ).
+
+  FILE FORMAT ( native byte order ):
+     sequence of { BlockHeader, packed data }
+     BlockHeader: "DLZ1", codec(1 byte), 3 reserved, rawSize(4), packedSize(4), FNV-1a of raw text(4)
+******************************************************************************/
+
+#ifndef DEBUGLOG_ZLIB
+#define DEBUGLOG_ZLIB 0
+#endif
+
+class LogCompressor
+{
+    public:
+        enum Codec
+        {
+            CODEC_STORE = 0,        // no compression
+            CODEC_LZ    = 1,        // built-in LZ77 codec ( LZ4-like, fast )
+            CODEC_ZLIB  = 2,        // zlib deflate ( better ratio, slower )
+            CODEC_DEFAULT = DEBUGLOG_ZLIB ? CODEC_ZLIB : CODEC_LZ
+        };
+
+        // Start compression of lines which go to FileSink. Return false if failed
+        static bool open( Codec codec = CODEC_DEFAULT, size_t blockSize = 64 * 1024, int flushIntervalMs = 1000 );
+
+        // Write what is left and stop compression ( call before FileSink::close() )
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Append line to current block ( '\n' is added )
+        static void write( const char* line, size_t len );
+
+        // Append to "out" framed block with compressed "data"
+        static void compressBlock( const char* data, size_t len, std::string& out, Codec codec = CODEC_DEFAULT );
+
+        // Decode sequence of blocks into text. Return false if stream is truncated or corrupted
+        // ( all complete blocks before that point are decoded )
+        static bool decompress( std::istream& in, std::ostream& out );
+
+        // Compress whole file "src" into "dst". Return false if failed
+        static bool compressFile( const char* src, const char* dst, Codec codec = CODEC_DEFAULT );
+
+        // True if "data" starts with block header
+        static bool isCompressed( const char* data, size_t len );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,475 @@
+/*********************************************************************
+  Purpose: Rotating file output through preallocated mmap segments
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <algorithm>        // min
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>           // rename, perror
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "debugcompress.h"
+#include "debugfilesink.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> FileSink::active_s( false );
+
+namespace {
+
+const size_t NOT_SEALED = std::numeric_limits<size_t>::max();
+const char   COMPRESSED_SUFFIX[] = ".dz";
+const char   SPARE_SUFFIX[] = ".next";
+
+/***************************************************************************
+    One mapped file
+
+  Writers reserve space by reserved_.fetch_add(), so the first reservation
+  which does not fit gives the final size of file ( sealAt_ ). File could be
+  finalized when all successful writers are done ( committed_ == sealAt_ ).
+***************************************************************************/
+struct Segment
+{
+    int    fd_;
+    char*  base_;                       // base_ and size_ are not changed: late writer could read them
+    size_t size_;
+    std::atomic<size_t> reserved_;      // bytes reserved by writers ( could be more than size_ )
+    std::atomic<size_t> committed_;     // bytes which are written
+    std::atomic<size_t> sealAt_;        // used size of full segment
+    uint64_t            seq_;           // number of segment since open ( gives name of rotated file )
+
+    Segment() : fd_( -1 ), base_( nullptr ), size_( 0 ), reserved_( 0 ), committed_( 0 ), sealAt_( NOT_SEALED ), seq_( 0 ) {}
+
+    // Make all next reservations fail
+    void seal()
+    {
+        size_t off = reserved_.fetch_add( size_ + 1 );
+        if ( off <= size_ )
+            sealAt_.store( off );
+    }
+};
+
+struct SinkState
+{
+    std::mutex               mutex_;        // rotation, open/close, retired_
+    std::atomic<Segment*>    current_;
+    Segment*                 spare_;        // next file prepared by background thread ( "path.next" )
+    bool                     renamePending_;// current file is still "path.next" ( it is renamed by shiftFiles() )
+    bool                     errorReported_;// do not repeat the same error until success
+    std::atomic<uint64_t>    dropped_;      // lines lost because there was no file to write
+    std::vector<Segment*>    retired_;      // full segments which wait for writers
+    std::vector<Segment*>    compress_;     // finalized rotated segments which wait for compression
+    uint64_t                 seq_;          // number of segments created since open
+    // descriptors are never deleted: writer could keep pointer to old segment
+    std::vector< std::unique_ptr<Segment> > all_;
+
+    std::string              path_;
+    size_t                   fileSize_;
+    int                      maxFiles_;
+    FileSink::SyncPolicy     syncPolicy_;
+    int                      syncIntervalMs_;
+    bool                     compressRotated_;
+
+    std::thread              thread_;
+    std::condition_variable  cond_;
+    bool                     stop_;
+
+    SinkState() : current_( nullptr ), spare_( nullptr ), renamePending_( false ), errorReported_( false ), dropped_( 0 ), seq_( 0 ), fileSize_( 0 ), maxFiles_( 0 ),
+                  syncPolicy_( FileSink::SYNC_NONE ), syncIntervalMs_( 0 ), compressRotated_( false ), stop_( false ) {}
+    ~SinkState() { FileSink::close(); }
+};
+
+SinkState state_s;
+
+// Print error once until the next success. mutex_ have to be locked
+void reportError( const char* what )
+{
+    if ( !state_s.errorReported_ )
+        perror( what );
+    state_s.errorReported_ = true;
+}
+
+// Create and map file ( no lock needed: path_ is not changed while sink is open )
+Segment* createSegment( const std::string& name )
+{
+    int fd = ::open( name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 )
+        return nullptr;
+
+    // Reserve disk space now, so writing into mapping never gets SIGBUS because of ENOSPC
+    size_t size = state_s.fileSize_;
+    int err = posix_fallocate( fd, 0, size );
+    void* base = MAP_FAILED;
+    if ( err == 0 || ftruncate( fd, size ) == 0 )
+    {
+        base = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        err = errno;
+    }
+    if ( base == MAP_FAILED )
+    {
+        ::close( fd );
+        errno = err;
+        return nullptr;
+    }
+
+    Segment* seg = new Segment();
+    seg->fd_ = fd;
+    seg->base_ = static_cast<char*>( base );
+    seg->size_ = size;
+    return seg;
+}
+
+// Make "seg" the current one. mutex_ have to be locked
+void activate( Segment* seg )
+{
+    seg->seq_ = ++state_s.seq_;
+    state_s.all_.emplace_back( seg );
+    state_s.current_.store( seg, std::memory_order_release );
+}
+
+// Name of rotated file ( index 0 is the current one )
+std::string rotatedName( int index )
+{
+    return index ? state_s.path_ + "." + std::to_string( index ) : state_s.path_;
+}
+
+std::string spareName()
+{
+    return state_s.path_ + SPARE_SUFFIX;
+}
+
+// path -> path.1 -> path.2 ... ( the oldest one is removed ). mutex_ have to be locked
+void shiftFiles()
+{
+    int last = std::max( state_s.maxFiles_, 0 );
+    unlink( rotatedName( last ).c_str() );
+    unlink( ( rotatedName( last ) + COMPRESSED_SUFFIX ).c_str() );
+    for ( int i = last - 1; i >= 0; i-- )
+    {
+        rename( rotatedName( i ).c_str(), rotatedName( i + 1 ).c_str() );
+        if ( i )
+            rename( ( rotatedName( i ) + COMPRESSED_SUFFIX ).c_str(), ( rotatedName( i + 1 ) + COMPRESSED_SUFFIX ).c_str() );
+    }
+}
+
+// Current file was started from spare one: shift files and give it the name "path".
+// mutex_ have to be locked
+void finishRename()
+{
+    if ( !state_s.renamePending_ )
+        return;
+    state_s.renamePending_ = false;
+    shiftFiles();
+    if ( rename( spareName().c_str(), state_s.path_.c_str() ) != 0 )
+        reportError( "FileSink: rename" );
+}
+
+// Segment "full" has no room: start new file. Return false if output is stopped
+//  Usually the next file is already prepared by background thread, so writer makes
+//  no syscall. If it is not ready yet, the file is created here. If that failed,
+//  sink is stopped ( "active" is cleared ), so lines are not formatted for nothing.
+bool rotate( Segment* full, std::atomic<bool>& active )
+{
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    if ( !active.load() )
+        return false;
+    if ( state_s.current_.load() != full )
+        return true;                // somebody already did it
+
+    full->seal();
+    state_s.retired_.push_back( full );
+    state_s.cond_.notify_one();
+
+    Segment* seg = state_s.spare_;
+    state_s.spare_ = nullptr;
+    if ( seg )
+        state_s.renamePending_ = true;
+    else
+    {
+        finishRename();
+        shiftFiles();
+        seg = createSegment( state_s.path_ );
+    }
+    if ( !seg )
+    {
+        perror( "FileSink: no file to write, output is stopped" );
+        state_s.current_.store( nullptr, std::memory_order_release );
+        active.store( false );
+        return false;
+    }
+    activate( seg );
+    return true;
+}
+
+// Unmap and remove prepared file which is not used. mutex_ have to be locked
+void dropSpare()
+{
+    Segment* seg = state_s.spare_;
+    if ( !seg )
+        return;
+    state_s.spare_ = nullptr;
+    munmap( seg->base_, seg->size_ );
+    ::close( seg->fd_ );
+    unlink( spareName().c_str() );
+    delete seg;
+}
+
+// Cut unused tail of segment and release it. Return false if some writer is still here
+bool finalize( Segment* seg )
+{
+    size_t used = seg->sealAt_.load();
+    if ( used == NOT_SEALED || seg->committed_.load( std::memory_order_acquire ) != used )
+        return false;
+    munmap( seg->base_, seg->size_ );
+    if ( ftruncate( seg->fd_, used ) != 0 )
+        perror( "FileSink: ftruncate" );
+    // file is still opened to read it for compression even if it is renamed meanwhile
+    if ( state_s.compressRotated_ && seg->seq_ != state_s.seq_ )
+        state_s.compress_.push_back( seg );
+    else
+        ::close( seg->fd_ );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Replace rotated file of "seg" with compressed one
+              ( compression is done without lock, "lock" is locked on return )
+**********************************************************************************/
+void compressRotated( Segment* seg, std::unique_lock<std::mutex>& lock )
+{
+    std::string tmpName = state_s.path_ + ".tmp" + std::to_string( seg->seq_ ) + COMPRESSED_SUFFIX;
+    lock.unlock();
+    bool isOk = false;
+    {
+        std::ofstream out( tmpName, std::ios::binary | std::ios::trunc );
+        std::vector<char> data( 64 * 1024 );
+        std::string packed;
+        size_t used = seg->sealAt_.load();
+        for ( size_t pos = 0; out && pos < used; )
+        {
+            ssize_t n = pread( seg->fd_, data.data(), std::min( data.size(), used - pos ), pos );
+            if ( n <= 0 )
+                break;
+            packed.clear();
+            LogCompressor::compressBlock( data.data(), n, packed );
+            out.write( packed.data(), packed.size() );
+            pos += n;
+            isOk = ( pos == used );
+        }
+        isOk = isOk && out.flush();
+    }
+    ::close( seg->fd_ );
+    lock.lock();
+
+    // Find where file is now ( it is shifted by rotations which happened meanwhile )
+    finishRename();
+    uint64_t index = state_s.seq_ - seg->seq_;
+    if ( isOk && index <= static_cast<uint64_t>( state_s.maxFiles_ ) )
+    {
+        std::string name = rotatedName( static_cast<int>( index ) );
+        if ( !rename( tmpName.c_str(), ( name + COMPRESSED_SUFFIX ).c_str() ) )
+            unlink( name.c_str() );
+    }
+    unlink( tmpName.c_str() );
+}
+
+/**********************************************************************************
+   PURPOSE:   Background thread: sync current file, finalize rotated ones
+**********************************************************************************/
+void syncLoop()
+{
+    std::unique_lock<std::mutex> lock( state_s.mutex_ );
+    for ( ;; )
+    {
+        finishRename();
+        auto& retired = state_s.retired_;
+        for ( size_t i = 0; i < retired.size(); )
+        {
+            if ( finalize( retired[i] ) )
+                retired.erase( retired.begin() + i );
+            else
+                i++;
+        }
+        while ( !state_s.compress_.empty() )
+        {
+            Segment* seg = state_s.compress_.back();
+            state_s.compress_.pop_back();
+            compressRotated( seg, lock );
+        }
+        if ( state_s.stop_ && retired.empty() )
+            break;
+
+        // Prepare the next file, so writer which fills the current one does not wait for it
+        // ( "path.next" is free: pending rename of it is done above )
+        if ( !state_s.spare_ && !state_s.stop_ )
+        {
+            finishRename();
+            lock.unlock();
+            Segment* spare = createSegment( spareName() );
+            lock.lock();
+            if ( spare )
+            {
+                state_s.spare_ = spare;
+                state_s.errorReported_ = false;
+            }
+            else
+                reportError( "FileSink: prepare next file" );
+        }
+
+        // Segment could be unmapped only by this thread, so sync it without lock
+        Segment* seg = state_s.current_.load();
+        if ( seg && state_s.syncPolicy_ != FileSink::SYNC_NONE )
+        {
+            size_t len = std::min( seg->reserved_.load( std::memory_order_relaxed ), seg->size_ );
+            int flags = ( state_s.syncPolicy_ == FileSink::SYNC_FULL ) ? MS_SYNC : MS_ASYNC;
+            lock.unlock();
+            if ( len )
+                msync( seg->base_, len, flags );
+            lock.lock();
+        }
+
+        // writers of retired segments are about to finish, so check them soon
+        int waitMs = retired.empty() ? state_s.syncIntervalMs_ : 1;
+        state_s.cond_.wait_for( lock, std::chrono::milliseconds( waitMs ) );
+    }
+    finishRename();
+    dropSpare();
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Start writing into "path"
+**********************************************************************************/
+bool FileSink::open( const char* path, size_t fileSize /*=64MB*/, int maxFiles /*=5*/,
+                     SyncPolicy syncPolicy /*=SYNC_ASYNC*/, int syncIntervalMs /*=1000*/,
+                     bool compressRotated /*=false*/ )
+{
+    close();
+    if ( !path || fileSize < 2 )
+        return false;
+
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    state_s.path_ = path;
+    state_s.fileSize_ = fileSize;
+    state_s.maxFiles_ = maxFiles;
+    state_s.syncPolicy_ = syncPolicy;
+    state_s.syncIntervalMs_ = ( syncIntervalMs > 0 ) ? syncIntervalMs : 1000;
+    state_s.compressRotated_ = compressRotated;
+    state_s.seq_ = 0;
+    state_s.renamePending_ = false;
+    state_s.errorReported_ = false;
+
+    Segment* seg = createSegment( state_s.path_ );
+    if ( !seg )
+        return false;
+    activate( seg );
+    state_s.stop_ = false;
+    state_s.thread_ = std::thread( syncLoop );
+    active_s.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Stop writing and finalize files
+**********************************************************************************/
+void FileSink::close()
+{
+    {
+        std::lock_guard<std::mutex> lock( state_s.mutex_ );
+        active_s.store( false );
+        if ( !state_s.thread_.joinable() )
+            return;             // not opened ( sink could be already stopped by error )
+        Segment* seg = state_s.current_.exchange( nullptr );
+        if ( seg )
+        {
+            seg->seal();
+            state_s.retired_.push_back( seg );
+        }
+        state_s.stop_ = true;
+        state_s.cond_.notify_one();
+    }
+    state_s.thread_.join();
+}
+
+uint64_t FileSink::getDropped()
+{
+    return state_s.dropped_.load( std::memory_order_relaxed );
+}
+
+/**********************************************************************************
+   PURPOSE:   Append data ( lock-free, no syscall unless file is full )
+**********************************************************************************/
+void FileSink::append( const char* data, size_t len, bool isLine )
+{
+    for ( ;; )
+    {
+        Segment* seg = state_s.current_.load( std::memory_order_acquire );
+        if ( !seg )
+        {
+            state_s.dropped_.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        size_t n = len + ( isLine ? 1 : 0 );
+        if ( n > seg->size_ )
+        {
+            if ( !isLine )
+                return;                     // truncated block is useless
+            len = seg->size_ - 1;           // line bigger than file
+            n = seg->size_;
+        }
+        size_t off = seg->reserved_.fetch_add( n, std::memory_order_relaxed );
+        if ( off + n <= seg->size_ )
+        {
+            memcpy( seg->base_ + off, data, len );
+            if ( isLine )
+                seg->base_[off + len] = '\n';
+            seg->committed_.fetch_add( n, std::memory_order_release );
+            return;
+        }
+
+        // Only the first reservation which does not fit starts inside of segment
+        if ( off <= seg->size_ )
+            seg->sealAt_.store( off );
+        if ( !rotate( seg, active_s ) )
+        {
+            state_s.dropped_.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+    }
+}
+
+/**********************************************************************************
+   PURPOSE:   Append line
+**********************************************************************************/
+void FileSink::write( const char* line, size_t len )
+{
+    append( line, len, true );
+}
+
+/**********************************************************************************
+   PURPOSE:   Append block of data ( it is never split between files )
+**********************************************************************************/
+void FileSink::writeBlock( const char* data, size_t len )
+{
+    append( data, len, false );
+}
+
+}   // namespace debug
+}   // namespace tsv
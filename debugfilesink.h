@@ -0,0 +1,83 @@
+#ifndef DEBUGFILESINK_H_
+#define DEBUGFILESINK_H_ 1
+
+/*********************************************************************
+  Purpose: Rotating file output through preallocated mmap segments
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  File sink
+
+  HOWTO USE:
+     FileSink::open( "/var/log/app.dbg" );          // 64MB files, keep 5 rotated ones
+     LoggerHandler::handler_s = nullptr;            // optional: output goes only to file
+     ... SENTRY_*, SAY_* as usual ...
+     FileSink::close();                             // cut preallocated tail of the last file
+
+  NOTES:
+    1. Each file is preallocated and mapped into memory. Line is appended by
+       atomic bump of write offset and memcpy: no lock, no syscall per line.
+    2. When file reaches "fileSize", it is renamed to "path.1" ( "path.1" to "path.2", ... )
+       and new "path" is started. Only "maxFiles" rotated files are kept.
+    3. Background thread syncs current file ( policy ) and finalizes rotated
+       ones ( cut unused preallocated tail, unmap ). Until close() the current file
+       has zero bytes at the end.
+       It also prepares the next file ( "path.next" ) and does renames, so writer which
+       fills the file only switches to it. If new file could not be created ( no space,
+       no descriptors ), error is printed once, sink stops and lost lines are counted
+       in getDropped() ( and "dropped" of LoggerMetrics ).
+    4. Lines go to file in addition to handler_s.
+    5. If "compressRotated" is true, background thread compresses each rotated file
+       into "path.N.dz" ( see LogCompressor ). To compress all output while it is
+       written, open LogCompressor after FileSink.
+******************************************************************************/
+
+class FileSink
+{
+    public:
+        enum SyncPolicy
+        {
+            SYNC_NONE,              // kernel writes pages back when it wants
+            SYNC_ASYNC,             // msync(MS_ASYNC) each "syncIntervalMs": start writeback
+            SYNC_FULL               // msync(MS_SYNC) each "syncIntervalMs": data is on disk
+        };
+
+        // Start writing into "path". Return false if failed
+        static bool open( const char* path, size_t fileSize = 64 * 1024 * 1024, int maxFiles = 5,
+                          SyncPolicy syncPolicy = SYNC_ASYNC, int syncIntervalMs = 1000,
+                          bool compressRotated = false );
+
+        // Finalize all files and stop background thread
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Append line ( '\n' is added )
+        static void write( const char* line, size_t len );
+
+        // Append block of data as is ( it is dropped if it is bigger than file )
+        static void writeBlock( const char* data, size_t len );
+
+        // Lines lost because new file could not be created
+        static uint64_t getDropped();
+
+    protected:
+        static std::atomic<bool> active_s;
+
+        static void append( const char* data, size_t len, bool isLine );
+};
+
+}
+}
+
+#endif
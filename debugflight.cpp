@@ -0,0 +1,301 @@
+/*********************************************************************
+  Purpose: Crash-persistent flight recorder
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <algorithm>        // sort
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debugflight.h"
+#include "debuglog.h"
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> FlightRecorder::active_s( false );
+
+namespace {
+
+const char FLIGHT_MAGIC[8] = { 'D', 'B', 'G', 'F', 'L', 'T', '1', '\n' };
+
+enum { RING_FREE = 0, RING_USED = 1 };
+
+/***************************************************************************
+    Layout of mapped file
+***************************************************************************/
+
+struct FileHeader
+{
+    char     magic_[8];
+    uint32_t maxThreads_;
+    uint32_t slotsPerThread_;
+    uint32_t slotSize_;
+    uint32_t reserved_;
+    uint64_t wallTime_;                 // time of open() in ns since unix epoch
+    std::atomic<uint32_t> ringsUsed_;   // how many rings were claimed at least once
+    char     pad_[28];
+};
+
+struct RingHeader
+{
+    std::atomic<uint32_t> state_;       // RING_FREE / RING_USED
+    uint32_t threadId_;
+    std::atomic<uint64_t> head_;        // how many events were written into ring
+    char     pad_[48];
+};
+
+struct SlotHeader
+{
+    std::atomic<uint64_t> seq_;         // index of event + 1 ( 0 = slot is being written )
+    uint64_t ns_;                       // time since open()
+    uint16_t len_;
+    uint8_t  level_;
+    char     pad_[5];
+};
+
+static_assert( sizeof(FileHeader) == 64 && sizeof(RingHeader) == 64 && sizeof(SlotHeader) == 24,
+               "layout of flight recorder file" );
+
+// One opened file ( never unmapped, because some thread could write right now )
+struct Mapping
+{
+    char*       base_;
+    size_t      size_;
+    size_t      ringSize_;              // RingHeader + slots
+    uint64_t    epoch_;                 // Timing::now() of open()
+    FileHeader* header_;
+
+    RingHeader* ring( uint32_t idx ) { return reinterpret_cast<RingHeader*>( base_ + sizeof(FileHeader) + ringSize_ * idx ); }
+    SlotHeader* slot( RingHeader* ring, uint64_t idx )
+    {
+        return reinterpret_cast<SlotHeader*>( reinterpret_cast<char*>( ring + 1 ) + header_->slotSize_ * idx );
+    }
+};
+
+std::atomic<Mapping*> current_s( nullptr );
+std::mutex openMutex_s;
+
+// Ring of current thread
+struct RingHolder
+{
+    Mapping*    mapping_;
+    RingHeader* ring_;
+    RingHolder() : mapping_( nullptr ), ring_( nullptr ) {}
+    ~RingHolder()
+    {
+        // let another thread reuse it ( its events are kept until overwritten )
+        if ( ring_ )
+            ring_->state_.store( RING_FREE, std::memory_order_release );
+    }
+};
+
+// Take never used ring or free ring of exited thread
+RingHeader* claimRing( Mapping* m )
+{
+    FileHeader* hdr = m->header_;
+    RingHeader* ring = nullptr;
+    uint32_t used = hdr->ringsUsed_.load( std::memory_order_relaxed );
+    while ( used < hdr->maxThreads_ )
+    {
+        if ( hdr->ringsUsed_.compare_exchange_weak( used, used + 1 ) )
+        {
+            ring = m->ring( used );
+            ring->state_.store( RING_USED, std::memory_order_relaxed );
+            break;
+        }
+    }
+    for ( uint32_t i = 0; !ring && i < hdr->maxThreads_; i++ )
+    {
+        uint32_t state = RING_FREE;
+        if ( m->ring( i )->state_.compare_exchange_strong( state, RING_USED ) )
+            ring = m->ring( i );
+    }
+    if ( ring )
+        ring->threadId_ = SentryLogger::getThreadId();
+    return ring;
+}
+
+RingHeader* threadRing( Mapping* m )
+{
+    static thread_local RingHolder holder;
+    if ( holder.mapping_ != m )
+    {
+        if ( holder.ring_ )
+            holder.ring_->state_.store( RING_FREE, std::memory_order_release );
+        holder.mapping_ = m;
+        holder.ring_ = claimRing( m );
+    }
+    return holder.ring_;
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Create file of recorder and start recording
+**********************************************************************************/
+bool FlightRecorder::open( const char* path, uint32_t slotsPerThread /*=4096*/,
+                           uint32_t maxThreads /*=64*/, uint32_t slotSize /*=256*/ )
+{
+    std::lock_guard<std::mutex> lock( openMutex_s );
+    close();
+    if ( !slotsPerThread || !maxThreads || slotSize <= sizeof(SlotHeader) || slotSize > 65536 )
+        return false;
+
+    slotSize = ( slotSize + 7 ) & ~7u;
+    size_t ringSize = sizeof(RingHeader) + static_cast<size_t>( slotSize ) * slotsPerThread;
+    size_t size = sizeof(FileHeader) + ringSize * maxThreads;
+
+    int fd = ::open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 )
+        return false;
+    // file is sparse: only touched pages take space
+    void* base = ( ftruncate( fd, size ) == 0 ) ? mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) : MAP_FAILED;
+    ::close( fd );
+    if ( base == MAP_FAILED )
+        return false;
+
+    Mapping* m = new Mapping();
+    m->base_ = static_cast<char*>( base );
+    m->size_ = size;
+    m->ringSize_ = ringSize;
+    m->epoch_ = Timing::now();
+    m->header_ = reinterpret_cast<FileHeader*>( base );
+
+    FileHeader* hdr = m->header_;
+    hdr->maxThreads_ = maxThreads;
+    hdr->slotsPerThread_ = slotsPerThread;
+    hdr->slotSize_ = slotSize;
+    hdr->wallTime_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch() ).count();
+    memcpy( hdr->magic_, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC) );    // header is complete
+
+    current_s.store( m, std::memory_order_release );
+    active_s.store( true );
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if ( !active_s.exchange( false ) )
+        return;
+    sync();
+    current_s.store( nullptr, std::memory_order_release );
+}
+
+void FlightRecorder::sync()
+{
+    Mapping* m = current_s.load( std::memory_order_acquire );
+    if ( m )
+        msync( m->base_, m->size_, MS_SYNC );
+}
+
+/**********************************************************************************
+   PURPOSE:   Store line into ring of current thread ( no lock, no syscall )
+**********************************************************************************/
+void FlightRecorder::record( int level, const char* line, size_t len )
+{
+    Mapping* m = current_s.load( std::memory_order_acquire );
+    if ( !m )
+        return;
+    RingHeader* ring = threadRing( m );
+    if ( !ring )
+        return;
+
+    uint64_t index = ring->head_.load( std::memory_order_relaxed );
+    SlotHeader* slot = m->slot( ring, index % m->header_->slotsPerThread_ );
+    size_t room = m->header_->slotSize_ - sizeof(SlotHeader);
+    if ( len > room )
+        len = room;
+
+    // seq_ is written last, so slot torn by crash is recognized by reader
+    slot->seq_.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    slot->ns_ = Timing::toNs( Timing::now() - m->epoch_ );
+    slot->len_ = static_cast<uint16_t>( len );
+    slot->level_ = static_cast<uint8_t>( level );
+    memcpy( reinterpret_cast<char*>( slot + 1 ), line, len );
+    slot->seq_.store( index + 1, std::memory_order_release );
+    ring->head_.store( index + 1, std::memory_order_release );
+}
+
+/**********************************************************************************
+   PURPOSE:   Print events of all rings ordered by time
+**********************************************************************************/
+bool FlightRecorder::decode( const char* path, std::ostream& out, bool withTime /*=false*/ )
+{
+    int fd = ::open( path, O_RDONLY );
+    if ( fd < 0 )
+        return false;
+    struct stat st;
+    void* base = ( fstat( fd, &st ) == 0 && static_cast<size_t>( st.st_size ) >= sizeof(FileHeader) )
+                 ? mmap( nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0 ) : MAP_FAILED;
+    ::close( fd );
+    if ( base == MAP_FAILED )
+        return false;
+
+    Mapping m;
+    m.base_ = static_cast<char*>( base );
+    m.size_ = st.st_size;
+    m.header_ = reinterpret_cast<FileHeader*>( base );
+    const FileHeader* hdr = m.header_;
+    m.ringSize_ = sizeof(RingHeader) + static_cast<size_t>( hdr->slotSize_ ) * hdr->slotsPerThread_;
+    if ( memcmp( hdr->magic_, FLIGHT_MAGIC, sizeof(FLIGHT_MAGIC) ) || hdr->slotSize_ <= sizeof(SlotHeader) ||
+         !hdr->slotsPerThread_ || sizeof(FileHeader) + m.ringSize_ * hdr->maxThreads_ > m.size_ )
+    {
+        munmap( base, st.st_size );
+        return false;
+    }
+
+    struct Event
+    {
+        uint64_t ns_;
+        const SlotHeader* slot_;
+    };
+    std::vector<Event> events;
+    uint32_t rings = std::min( hdr->ringsUsed_.load(), hdr->maxThreads_ );
+    for ( uint32_t r = 0; r < rings; r++ )
+    {
+        RingHeader* ring = m.ring( r );
+        uint64_t head = ring->head_.load();
+        // event "head" could be complete if crash happened just before head_ was updated
+        // ( then it is in the slot of the oldest event, only one of them passes check of seq_ )
+        uint64_t first = ( head > hdr->slotsPerThread_ ) ? head - hdr->slotsPerThread_ : 0;
+        for ( uint64_t i = first; i <= head; i++ )
+        {
+            const SlotHeader* slot = m.slot( ring, i % hdr->slotsPerThread_ );
+            if ( slot->seq_.load() == i + 1 && slot->len_ <= hdr->slotSize_ - sizeof(SlotHeader) )
+                events.push_back( Event{ slot->ns_, slot } );
+        }
+    }
+    std::stable_sort( events.begin(), events.end(), []( const Event& a, const Event& b ) { return a.ns_ < b.ns_; } );
+
+    for ( const Event& ev : events )
+    {
+        if ( withTime )
+        {
+            char buf[32];
+            snprintf( buf, sizeof(buf), "%llu.%09llu ", static_cast<unsigned long long>( ev.ns_ / 1000000000ULL ),
+                      static_cast<unsigned long long>( ev.ns_ % 1000000000ULL ) );
+            out << buf;
+        }
+        out.write( reinterpret_cast<const char*>( ev.slot_ + 1 ), ev.slot_->len_ );
+        out << '\n';
+    }
+    munmap( base, st.st_size );
+    return true;
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,80 @@
+#ifndef DEBUGFLIGHT_H_
+#define DEBUGFLIGHT_H_ 1
+
+/*********************************************************************
+  Purpose: Crash-persistent flight recorder
+           ( last events of each thread in file-backed mmap ring )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Flight recorder
+
+  HOWTO USE:
+     FlightRecorder::open( "/tmp/app.flight" );     // keep last 4096 events of each thread
+     LoggerHandler::handler_s = nullptr;            // text output could be quiet
+     ... SENTRY_*, SAY_* as usual ...
+
+     After crash ( or at any time ):  flight_decode /tmp/app.flight
+                                 or:  FlightRecorder::decode( "/tmp/app.flight", std::cout );
+
+  NOTES:
+    1. File is mapped with MAP_SHARED, so each event is in page cache right after
+       it is written: it survives SIGSEGV, abort() and even SIGKILL of process
+       ( but not power loss - use close() or sync() for that ).
+    2. Each thread has own ring of fixed-size slots, writing is memcpy into the ring
+       without any lock or syscall. Lines longer than slot are truncated.
+    3. Events which pass sentry flags are recorded even if handler_s is nullptr.
+       Disabled callsites are not recorded.
+    4. If there are more threads than "maxThreads", ring of exited thread is reused
+       ( or events of new thread are not recorded ).
+    5. Mapping is never unmapped ( thread could be writing right now ),
+       close() only syncs file and stops recording.
+
+  FILE FORMAT ( native byte order ):
+     FileHeader, then "maxThreads" of { RingHeader, "slotsPerThread" of slot }
+     slot:  SlotHeader, text[ slotSize - sizeof(SlotHeader) ]
+******************************************************************************/
+
+class FlightRecorder
+{
+    public:
+        // Create file "path" and start recording into it. Return false if failed
+        //      slotsPerThread = how many last events of each thread are kept
+        //      slotSize = max size of event ( including 24 bytes of header )
+        static bool open( const char* path, uint32_t slotsPerThread = 4096,
+                          uint32_t maxThreads = 64, uint32_t slotSize = 256 );
+
+        // Sync file and stop recording
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Write msync() of whole file ( data are already safe from crash of process )
+        static void sync();
+
+        // Store rendered line ( called by SentryLogger )
+        static void record( int level, const char* line, size_t len );
+
+        // Decode file "path" into text lines ordered by time
+        //      withTime = if true, then prefix each line with time since open
+        static bool decode( const char* path, std::ostream& out, bool withTime = false );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
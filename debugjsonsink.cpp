@@ -0,0 +1,223 @@
+/*********************************************************************
+  Purpose: Output of events as JSON lines ( with typed fields of SAY_ARGS )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>            // isfinite
+#include <cstdio>           // snprintf
+#include <cstring>          // strlen
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "debuglog.h"
+#include "debugjsonsink.h"
+#include "debugsink.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> JsonSink::active_s( false );
+
+namespace {
+
+struct SinkState
+{
+    std::mutex  mutex_;             // fd_ ( write() of one line is short )
+    int         fd_;
+
+    SinkState() : fd_( -1 ) {}
+    ~SinkState() { JsonSink::close(); }
+};
+
+SinkState state_s;
+
+void appendUnsigned( std::string& out, unsigned long long v )
+{
+    char buf[24];
+    char* p = buf + sizeof(buf);
+    do
+    {
+        *--p = static_cast<char>( '0' + v % 10 );
+        v /= 10;
+    } while ( v );
+    out.append( p, buf + sizeof(buf) - p );
+}
+
+void appendSigned( std::string& out, long long v )
+{
+    if ( v < 0 )
+    {
+        out += '-';
+        appendUnsigned( out, 0ULL - static_cast<unsigned long long>( v ) );
+    }
+    else
+        appendUnsigned( out, v );
+}
+
+void appendValue( std::string& out, const LogField& field )
+{
+    char buf[32];
+    switch ( field.type_ )
+    {
+    case LogField::FIELD_INT:    appendSigned( out, field.int_ ); break;
+    case LogField::FIELD_UINT:   appendUnsigned( out, field.uint_ ); break;
+    case LogField::FIELD_BOOL:   out += field.int_ ? "true" : "false"; break;
+    case LogField::FIELD_DOUBLE:
+        if ( std::isfinite( field.double_ ) )
+            out.append( buf, snprintf( buf, sizeof(buf), "%.17g", field.double_ ) );
+        else
+            out += "null";                  // JSON has no nan/inf
+        break;
+    case LogField::FIELD_PTR:
+        if ( field.ptr_ )
+            out.append( buf, snprintf( buf, sizeof(buf), "\"%p\"", field.ptr_ ) );
+        else
+            out += "null";
+        break;
+    default:
+        JsonSink::appendString( out, field.str_.data(), field.str_.size() );
+        break;
+    }
+}
+
+void appendId( std::string& out, const char* key, uint64_t id )
+{
+    static const char hex[] = "0123456789abcdef";
+    if ( !id )
+        return;
+    out += key;
+    char buf[18];
+    buf[0] = buf[17] = '"';
+    for ( int i = 16; i >= 1; i--, id >>= 4 )
+        buf[i] = hex[id & 15];
+    out.append( buf, sizeof(buf) );
+}
+
+const char* levelName( int level )
+{
+    switch ( level & SentryLoggerFlags::LOG_ALL )
+    {
+    case SentryLoggerFlags::LOG_ENTER: return "enter";
+    case SentryLoggerFlags::LOG_LEAVE: return "leave";
+    default:                           return "event";
+    }
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Create file "path" and start output
+**********************************************************************************/
+bool JsonSink::open( const char* path )
+{
+    close();
+    int fd = ::open( path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644 );
+    if ( fd < 0 )
+        return false;
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    state_s.fd_ = fd;
+    active_s.store( true );
+    return true;
+}
+
+void JsonSink::close()
+{
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    active_s.store( false );
+    if ( state_s.fd_ >= 0 )
+        ::close( state_s.fd_ );
+    state_s.fd_ = -1;
+}
+
+/**********************************************************************************
+   PURPOSE:   Append "text" as JSON string
+**********************************************************************************/
+void JsonSink::appendString( std::string& out, const char* text, size_t len )
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    size_t start = 0;
+    for ( size_t i = 0; i < len; i++ )
+    {
+        unsigned char c = static_cast<unsigned char>( text[i] );
+        if ( c >= 0x20 && c != '"' && c != '\\' )
+            continue;                       // UTF-8 is passed as is
+        out.append( text + start, i - start );
+        start = i + 1;
+        switch ( c )
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    out.append( text + start, len - start );
+    out += '"';
+}
+
+/**********************************************************************************
+   PURPOSE:   Write one event
+**********************************************************************************/
+void JsonSink::write( const LogRecord& rec )
+{
+    // Line is rendered without lock into per-thread buffer
+    static thread_local std::string line;
+    line.assign( "{\"ts\":" );
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch() ).count();
+    appendSigned( line, us / 1000000 );
+    char frac[8];
+    line.append( frac, snprintf( frac, sizeof(frac), ".%06d", static_cast<int>( us % 1000000 ) ) );
+    line += ",\"thread\":";
+    appendSigned( line, rec.threadId_ );
+    appendId( line, ",\"trace\":", rec.traceId_ );
+    appendId( line, ",\"span\":", rec.spanId_ );
+    appendId( line, ",\"parent\":", rec.parentSpanId_ );
+    line += ",\"depth\":";
+    appendSigned( line, rec.depth_ );
+    line += ",\"level\":\"";
+    line += levelName( rec.level_ );
+    line += "\",\"context\":";
+    appendString( line, rec.context_, strlen( rec.context_ ) );
+    line += ",\"msg\":";
+    appendString( line, rec.message_, rec.line_ + rec.len_ - rec.message_ );
+
+    bool hasFields = false;
+    for ( size_t i = 0; i < rec.fieldCount_; i++ )
+    {
+        const LogField& field = rec.fields_[i];
+        if ( field.isLiteral() )
+            continue;
+        line += hasFields ? "," : ",\"fields\":{";
+        hasFields = true;
+        appendString( line, field.name_, field.nameLen_ );
+        line += ':';
+        appendValue( line, field );
+    }
+    line += hasFields ? "}}\n" : "}\n";
+
+    std::lock_guard<std::mutex> lock( state_s.mutex_ );
+    for ( size_t pos = 0; state_s.fd_ >= 0 && pos < line.size(); )
+    {
+        ssize_t n = ::write( state_s.fd_, line.data() + pos, line.size() - pos );
+        if ( n < 0 && errno == EINTR )
+            continue;
+        if ( n <= 0 )
+            break;
+        pos += n;
+    }
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,67 @@
+#ifndef DEBUGJSONSINK_H_
+#define DEBUGJSONSINK_H_ 1
+
+/*********************************************************************
+  Purpose: Output of events as JSON lines ( with typed fields of SAY_ARGS )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace tsv {
+namespace debug {
+
+struct LogRecord;
+
+/******************************************************************************
+  JSON lines sink
+
+  HOWTO USE:
+     JsonSink::open( "/var/log/app.jsonl" );
+     SENTRY_FUNC();
+     SAY_ARGS( count, name );
+     JsonSink::close();
+
+  Output ( one object per line ):
+     {"ts":1697461234.123456,"thread":1,"trace":"5bd1e9951b3a07c2","span":"0c93f8e2a1d06b44",
+      "parent":"5bd1e9951b3a07c2","depth":1,"level":"event","context":"func",
+      "msg":"count = 5, name = \"abc\"","fields":{"count":5,"name":"abc"}}
+
+  NOTES:
+    1. "ts" is wall clock time ( seconds ), "level" is "enter", "leave" or "event".
+    2. "trace", "span" and "parent" are ids of sentry of event ( hex ). They are
+       absent if there is no sentry, "parent" is absent for root span of trace.
+    3. "fields" exists only for SAY_ARGS events: values keep their type
+       ( number, true/false, string, null ), pointers are "0x..." strings.
+    4. Line is rendered without lock and written by one write() under short lock,
+       so lines of threads are never mixed. Works in addition to other outputs.
+******************************************************************************/
+
+class JsonSink
+{
+    public:
+        // Create file "path" and start output. Return false if failed
+        static bool open( const char* path );
+
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Write one event ( called by SINK_JSON )
+        static void write( const LogRecord& rec );
+
+        // Append "text" as JSON string ( with quotes )
+        static void appendString( std::string& out, const char* text, size_t len );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
@@ -10,13 +10,23 @@
 #define DEBUG_LOGGING 1
 
 #include <iostream>
-#include <sys/time.h>
+#include <algorithm>    // max
 #include <memory>       // unique_ptr
-#include <cstring>      // strlen
-#include <cstdio>       // sprintf
+#include <cstring>      // strlen, memchr
+#include <cstdio>       // vsnprintf
+#include <atomic>
+#include <chrono>
+#include <unistd.h>     // getpid
 
 
 #include "debuglog.h"
+#include "debugbatchsink.h"
+#include "debugbinlog.h"
+#include "debugmetrics.h"
+#include "debugprofile.h"
+#include "debugsink.h"
+#include "debugtiming.h"
+#include "debugtrace.h"
 #include "tostr.h"
 
 namespace tsv {
@@ -36,10 +46,103 @@ namespace
 }
 
 LoggerHandler::handle_t LoggerHandler::handler_s = defaultLoggerHandler;  //
+LoggerHandler::timing_handle_t LoggerHandler::timing_handler_s = nullptr;
+
+namespace
+{
+  // Call printf-like handler with prepared arguments
+  void callHandler( LoggerHandler::handle_t handler, const char* fmt, ... )
+  {
+    va_list args;
+    va_start( args, fmt );
+    handler( fmt, &args );
+    va_end( args );
+  }
+
+  // Indentation of nested mode is copied from these tables ( no per-call strings )
+  #define DEBUGLOG_INDENT_X8( s )  s s s s s s s s
+  const char   indentEnter[]  = DEBUGLOG_INDENT_X8( DEBUGLOG_INDENT_X8( ">" ) );
+  const char   indentEvents[] = DEBUGLOG_INDENT_X8( DEBUGLOG_INDENT_X8( " " ) );
+  const char   indentLeave[]  = DEBUGLOG_INDENT_X8( DEBUGLOG_INDENT_X8( "<" ) );
+  const size_t INDENT_TABLE_SIZE = sizeof( indentEnter ) - 1;
+  #undef DEBUGLOG_INDENT_X8
+
+  void appendIndent( std::string& out, const char* table, int depth )
+  {
+    while ( depth > 0 )
+    {
+        size_t n = ( static_cast<size_t>( depth ) < INDENT_TABLE_SIZE ) ? depth : INDENT_TABLE_SIZE;
+        out.append( table, n );
+        depth -= n;
+    }
+  }
+
+  // Append decimal value ( at least "minDigits" digits, zero padded )
+  void appendDecimal( std::string& out, unsigned value, int minDigits )
+  {
+    char buf[::tsv::util::tostr::DECIMAL_BUF_SIZE];
+    size_t len = ::tsv::util::tostr::formatDecimal( buf, value );
+    if ( static_cast<int>( len ) < minDigits )
+        out.append( minDigits - len, '0' );
+    out.append( buf, len );
+  }
+
+  // Append value as 16 hex digits
+  void appendHex64( std::string& out, uint64_t value )
+  {
+    char buf[16];
+    out.append( buf, ::tsv::util::tostr::formatHex( buf, value, 16 ) );
+  }
+
+  // Append to "out" format filled with C variadic arguments
+  void appendVA( std::string& out, const char* format, va_list* args )
+  {
+    size_t oldSize = out.size();
+    size_t room = 128;
+    va_list argsCopy;
+    va_copy( argsCopy, *args );
+    out.resize( oldSize + room );
+    int n = vsnprintf( &out[oldSize], room, format, *args );
+    if ( n >= static_cast<int>( room ) )
+    {
+        out.resize( oldSize + n + 1 );
+        n = vsnprintf( &out[oldSize], n + 1, format, argsCopy );
+    }
+    va_end( argsCopy );
+    out.resize( oldSize + ( n > 0 ? n : 0 ) );
+  }
+}
+
+// Output of already prepared line
+//=================================================================
+void LoggerHandler::output( int level, const char* line, size_t len )
+{
+    // Default handler just writes the line, so skip printf-like processing
+    // ( and collect it into batch if batch sink is active )
+    bool isBatched = BatchSink::isActive();
+    if ( handler_s == defaultLoggerHandler )
+    {
+        if ( isBatched )
+            BatchSink::write( line, len );
+        else
+            std::cout.write( line, len ).put( '\n' );
+    }
+    else if ( handler_s )
+        callHandler( handler_s, "%s", line );
+    if ( level & SentryLoggerFlags::LOG_STDOUT )
+    {
+        if ( isBatched )
+            BatchSink::write( line + 5, len - 5 );      // skip "[DBG]"
+        else
+            printf( "%s\n", line + 5 );
+    }
+}
 
 /************** SentryLogger defaults and settings **********************/
 bool SentryLogger::logStdoutFlag_s       = false;        // if true, when duplicate log output to stdout
 bool SentryLogger::isNestedLevelMode_s   = true;         // if true, then show graphically hierarchy
+bool SentryLogger::isThreadIdMode_s      = true;         // if true, then include thread id into prefix
+bool SentryLogger::isSpanIdMode_s        = false;        // if true, then include "trace:span" ids into prefix
 static bool SentryLogger_contextname_vwrite = true;      // include {contextname} as event prefix in vwrite()
 
 //**************************************************************************
@@ -47,18 +150,73 @@ static bool SentryLogger_contextname_vwrite = true;      // include {contextname
 //**************************************************************************
 
 using namespace SentryLoggerFlags;
-int  SentryLogger::curLevel_s          = 0 ;
-SentryLogger* SentryLogger::last_s  = nullptr ;
+thread_local int  SentryLogger::curLevel_s          = 0 ;
+thread_local int  SentryLogger::threadId_s          = 0 ;
+thread_local SentryLogger* SentryLogger::last_s  = nullptr ;
+thread_local SpanContext SentryLogger::context_s;
+thread_local const SentryLogger* SentryLogger::contextBase_s = nullptr ;
+
+namespace
+{
+  // Unique in process and unlikely repeated by other process:
+  // ( thread, sequence ) pair is mixed by bijective function
+  uint64_t newSpanId()
+  {
+    static const uint64_t seed = static_cast<uint64_t>( std::chrono::system_clock::now().time_since_epoch().count() )
+                                 ^ ( static_cast<uint64_t>( getpid() ) << 32 );
+    static thread_local uint64_t sequence = 0;
+    uint64_t z = seed + ( ( static_cast<uint64_t>( SentryLogger::getThreadId() ) << 40 ) | ++sequence );
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;          // splitmix64 finalizer
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return z ? z : 1;
+  }
+}
+
+SpanScope::SpanScope( const SpanContext& context )
+    : prevContext_( SentryLogger::context_s ), prevBase_( SentryLogger::contextBase_s )
+{
+    SentryLogger::context_s = context;
+    SentryLogger::contextBase_s = SentryLogger::last_s;
+}
+
+SpanScope::~SpanScope()
+{
+    SentryLogger::context_s = prevContext_;
+    SentryLogger::contextBase_s = prevBase_;
+}
+
+SpanContext SentryLogger::captureContext()
+{
+    // sentry created after SpanScope wins, otherwise entered context is the current one
+    if ( last_s && last_s != contextBase_s )
+        return SpanContext( last_s->traceId_, last_s->spanId_ );
+    return context_s;
+}
+
+// Return id of current thread (assign next one on first call)
+//=================================================================
+int SentryLogger::getThreadId()
+{
+    static std::atomic<int> lastThreadId( 0 );
+    if ( !threadId_s )
+        threadId_s = ++lastThreadId;
+    return threadId_s;
+}
 
 /**********************************************************************************
-   PURPOSE:   Ctor
+   PURPOSE:   Ctor of active sentry
    ARGUMENTS: name = function name (mentioned in prefix of all events for this level)
 	          args = text of suffix "Enter/Leave" events (if empty or null ptr = "scope" )
 	          logFlags = set of flags
 ************************************************************************************/
-SentryLogger::SentryLogger( const char* name /*=""*/, const char* args /*=""*/, int logFlags /*=LOG_ALL*/ ) :
-        name_( name ? name : "" ), loggingFlags_ ( logFlags )
+void SentryLogger::init( const CallSite* callsite, const char* name, const char* args, int logFlags )
 {
+    name_ = name ? name : "";
+    callsite_ = callsite;
+    loggingFlags_ = logFlags;
+    stream_ = nullptr;
+
     if ( logStdoutFlag_s )
         loggingFlags_ |= LOG_STDOUT;
 
@@ -71,10 +229,16 @@ SentryLogger::SentryLogger( const char* name /*=""*/, const char* args /*=""*/,
         comment = args;
 
     // Track timing
-    starttime_ = 0.0;
+    startTicks_ = 0;
     if ( loggingFlags_ & LOG_TIMING )
         startTiming( true );
 
+    // Span is child of the current context, or root of new trace
+    SpanContext parent = captureContext();
+    spanId_ = newSpanId();
+    parentSpanId_ = parent.spanId_;
+    traceId_ = parent.isValid() ? parent.traceId_ : spanId_;
+
     // Add to the list
     prev_sentry_ = last_s;
     last_s = this;
@@ -88,26 +252,45 @@ SentryLogger::SentryLogger( const char* name /*=""*/, const char* args /*=""*/,
         vwrite( "%sEnter %s", (isNestedLevelMode_s?"":">> "), comment );
     // ..and go to main state
     log_state_ = state_ = LOG_EVENTS;
+
+    // Profiling mode counts each sentry regardless of its output flags
+    profNode_ = nullptr;
+    if ( name && Profiler::isActive() )
+    {
+        profNode_ = Profiler::enter( name_ );
+        profStartTicks_ = Timing::now();
+    }
+    traced_ = ( name && ChromeTrace::isActive() );
+    if ( traced_ )
+        ChromeTrace::begin( name_ );
 }
 
 /**********************************************************************************
-   PURPOSE:   Dtor
+   PURPOSE:   Dtor of active sentry
 **********************************************************************************/
-SentryLogger::~SentryLogger()
+void SentryLogger::finish()
 {
+    if ( profNode_ )
+        Profiler::leave( profNode_, profStartTicks_ );
+    if ( traced_ && ChromeTrace::isActive() )
+        ChromeTrace::end( name_ );
+
     // Finalize << operations
-    if ( stream.str().length() )
+    if ( stream_ )
+    {
         processStream(true);
+        delete stream_;
+    }
 
     // Print leave message
     log_state_  = LOG_LEAVE;
     if ( loggingFlags_ & LOG_TIMING )
     {
-        struct timeval t;
-        gettimeofday( &t, nullptr );
-        double fintime = t.tv_sec + (double)t.tv_usec/1000.0;
+        uint64_t ns = getElapsedNs();
+        if ( LoggerHandler::timing_handler_s )
+            LoggerHandler::timing_handler_s( name_, ns );
 
-        vwrite( "%sLeave scope. exectime=%.2lf s", (isNestedLevelMode_s?">> ":""), fintime-starttime_ );
+        vwrite( "%sLeave scope. exectime=%llu ns", (isNestedLevelMode_s?">> ":""), static_cast<unsigned long long>( ns ) );
     }
     else
         vwrite( "%sLeave scope", (isNestedLevelMode_s?">> ":"") );
@@ -121,7 +304,7 @@ SentryLogger::~SentryLogger()
     {
         // something strange happens. deallocate not in order of allocation
         SentryLogger* cur = last_s;
-        for( ; !cur ; cur = cur->prev_sentry_ )
+        for( ; cur ; cur = cur->prev_sentry_ )
         {
             if ( cur->prev_sentry_ == this )
             {
@@ -138,51 +321,122 @@ SentryLogger::~SentryLogger()
 //=====================
 void SentryLogger::startTiming( bool start /*=true*/ )
 {
+    if ( !active_ )
+        return;
     if ( !start )
         loggingFlags_ &= ~LOG_TIMING;
     else
     {
-        struct timeval t;
-        gettimeofday( &t, nullptr );
-        starttime_ = t.tv_sec + (double)t.tv_usec/1000.0;
+        startTicks_ = Timing::now();
         loggingFlags_ |= LOG_TIMING;
     }
 }
 
+// Execution time of timed sentry
+//=====================
+uint64_t SentryLogger::getElapsedNs() const
+{
+    if ( !active_ || !( loggingFlags_ & LOG_TIMING ) )
+        return 0;
+    return Timing::toNs( Timing::now() - startTicks_ );
+}
+
 
 // Auxilary function
 // Check for EOL symbol in the stream and flush it using vwriteImpl
+// ( lines are cut in place: each byte is scanned once by memchr )
 //=================================================================
 void SentryLogger::processStream( bool enforceFlush )
 {
-    std::string s = stream.str();
+    SentryStream& stream = *stream_;
+    size_t start = 0;
+    size_t pos = stream.scanned_;
 
-    std::size_t found;
-    bool foundFlag = false;
-    while ( (found = s.find("\n") ) != std::string::npos )
+    const char* eol;
+    while ( pos < stream.size_ && ( eol = static_cast<const char*>( memchr( stream.data_ + pos, '\n', stream.size_ - pos ) ) ) )
     {
-        foundFlag = true;
-        if ( found )
+        size_t end = eol - stream.data_;
+        if ( end > start )
         {
-            std::string pre = s.substr( 0, found );
-            vwrite( "%s", pre.c_str() );
+            stream.data_[end] = '\0';
+            vwrite( "%s", stream.data_ + start );
         }
-
-        s = s.substr( found+1 );
+        start = pos = end + 1;
     }
 
-    if ( enforceFlush )
+    if ( enforceFlush && start < stream.size_ )
     {
-       if ( s.length() )
-       {
-         vwrite( "%s", s.c_str() );
-         stream.str("");
-       }
+        vwrite( "%s", stream.data_ + start );
+        start = stream.size_;
     }
-    else if ( foundFlag )
+
+    if ( start )
+        stream.erase( start );
+    stream.scanned_ = stream.size_;
+}
+
+//=================================================================
+//      Formatters of SentryStream ( the same text as ostream gives )
+//=================================================================
+
+void SentryStream::grow( size_t need )
+{
+    size_t capacity = std::max( need, capacity_ * 2 );
+    char* data = new char[capacity + 1];
+    memcpy( data, data_, size_ + 1 );
+    if ( data_ != small_ )
+        delete[] data_;
+    data_ = data;
+    capacity_ = capacity;
+}
+
+void SentryStream::erase( size_t len )
+{
+    size_ -= len;
+    memmove( data_, data_ + len, size_ );
+    data_[size_] = 0;
+}
+
+void SentryStream::putSigned( long long val )
+{
+    char buf[24];
+    write( buf, snprintf( buf, sizeof(buf), "%lld", val ) );
+}
+
+void SentryStream::putUnsigned( unsigned long long val )
+{
+    char buf[24];
+    write( buf, snprintf( buf, sizeof(buf), "%llu", val ) );
+}
+
+void SentryStream::putFloat( double val )
+{
+    char buf[32];
+    write( buf, snprintf( buf, sizeof(buf), "%g", val ) );
+}
+
+void SentryStream::putFloat( long double val )
+{
+    char buf[48];
+    write( buf, snprintf( buf, sizeof(buf), "%Lg", val ) );
+}
+
+void SentryStream::putString( const char* val )
+{
+    // ostream prints nothing for nullptr
+    if ( val )
+        write( val, strlen( val ) );
+}
+
+void SentryStream::putPointer( const void* val )
+{
+    if ( !val )
     {
-        stream.str( s );
+        write( '0' );
+        return;
     }
+    char buf[24];
+    write( buf, snprintf( buf, sizeof(buf), "%p", val ) );
 }
 
 // Print to log (if pass log_state_ condition)
@@ -190,48 +444,117 @@ void SentryLogger::processStream( bool enforceFlush )
 void SentryLogger::vwrite( const char* format, ... )
 {
     va_list args;
-    SentryLogger* self = last_s;
+    va_start( args, format );
+    vwriteArgs( format, FormatArgs( &args ) );
+    va_end( args );
+}
 
-    // If no any sentry was allocated,
-    // treat as printing event with nestedLevel=0
-    if ( !self )
+void SentryLogger::vwriteTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args )
+{
+    vwriteArgs( format, FormatArgs( args.begin(), args.size() ) );
+}
+
+// Line is made as TOSTR_ARGS() does, fields go along with it
+void SentryLogger::vwriteFieldsImpl( std::initializer_list<LogField> fields )
+{
+    std::string text;
+    const char* prevName = nullptr;
+    for ( const LogField& field : fields )
+    {
+        if ( prevName )
+            text += ( prevName[0] != '"' ) ? ", " : " ";
+        if ( !field.isLiteral() )
+            text.append( field.name_, field.nameLen_ ).append( " = " );
+        text += field.repr_;
+        prevName = field.name_;
+    }
+    ::tsv::util::tostr::FormatArg arg( text );
+    vwriteArgs( "%s", FormatArgs( &arg, 1, fields.begin(), fields.size() ) );
+}
+
+void SentryLogger::vwriteArgs( const char* format, const FormatArgs& args )
+{
+    int level = getEventLevel();
+    if ( !level )
     {
-        va_start( args, format );
-        int level = LOG_EVENTS | ( logStdoutFlag_s ? LOG_STDOUT : 0 );
-        vwriteImplVA( level, "", isNestedLevelMode_s, "", format, &args );
-        va_end( args );
+        if ( LoggerMetrics::isActive() )
+            LoggerMetrics::onFiltered();
+        resetEventState();
         return;
     }
 
+    // If no any sentry was allocated,
+    // treat as printing event with nestedLevel=0
+    SentryLogger* self = last_s;
+    vwriteImpl( level,
+                ( self && SentryLogger_contextname_vwrite ) ? self->name_ : "",
+                isNestedLevelMode_s,
+                "",
+                format,
+                args );
+
+    if ( self )
+        self->log_state_ = self->state_;
+}
+
+// Kind of event set by LoggerEvent is for one event only, even if that event is filtered
+void SentryLogger::resetEventState()
+{
+    if ( last_s )
+        last_s->log_state_ = last_s->state_;
+}
+
+int SentryLogger::getEventLevel()
+{
+    SentryLogger* self = last_s;
+    if ( !self )
+        return LOG_EVENTS | ( logStdoutFlag_s ? LOG_STDOUT : 0 );
+
     // If not enforce and not enabled by flags, skip it
     if ( !(self->loggingFlags_ & LOG_ENFORCE) )
     {
         if ( !( self->loggingFlags_ & self->log_state_ ) )
-            return;
+            return 0;
     }
+    return ( self->log_state_ & LOG_ALL ) | ( self->loggingFlags_ & LOG_STDOUT );
+}
 
-    static std::string empty_str;
-    va_start( args, format );
-    int level = ( self->log_state_ & LOG_ALL ) | ( self->loggingFlags_ & LOG_STDOUT );
-    vwriteImplVA( level,
-                 SentryLogger_contextname_vwrite ? self->name_ : empty_str,
-                 isNestedLevelMode_s,
-                 "",
-                 format,
-                 &args );
-    va_end( args );
+namespace
+{
+  // Would any output take event of "level" ( the same checks as vwriteImpl does )
+  bool isOutputWanted( int level )
+  {
+    return BinaryLog::isActive()
+           || ( ChromeTrace::isActive() && ( level & LOG_ALL ) == LOG_EVENTS )
+           || LogSinks::isWanted( level );
+  }
+}
 
-    self->log_state_ = self->state_;
+bool SentryLogger::isEventWanted()
+{
+    int level = getEventLevel();
+    if ( level && isOutputWanted( level ) )
+        return true;
+    if ( LoggerMetrics::isActive() )
+        LoggerMetrics::onFiltered();
+    resetEventState();
+    return false;
+}
+
+bool SentryLogger::isEnterWanted() const
+{
+    if ( !active_ )
+        return false;
+    if ( !(loggingFlags_ & LOG_ENFORCE) && !( loggingFlags_ & LOG_ENTER ) )
+        return false;
+    return isOutputWanted( LOG_ENTER | ( loggingFlags_ & LOG_STDOUT ) );
 }
 
 // Internal function to print log
 // (actually prepare string and call handlers)
 //=================================================================
-void SentryLogger::vwriteImplVA( int level, const std::string& fn_name, bool isNested, const char* prefix, const char* format, void* args )
+void SentryLogger::vwriteImpl( int level, const char* fn_name, bool isNested, const char* prefix, const char* format, const FormatArgs& args )
 {
-    static size_t sizeStr = 0;
-    static std::unique_ptr<char[]> formatNew;
-
     // Check arguments
     if ( !prefix )
         prefix = "";
@@ -243,56 +566,117 @@ void SentryLogger::vwriteImplVA( int level, const std::string& fn_name, bool isN
             return;
     }
 
-    // Check that handler_s exists or stdout is active
-    if ( !LoggerHandler::handler_s &&
-         !(level & LOG_STDOUT) )
+    // Self-metrics: 0 if they are off
+    uint64_t startTicks = LoggerMetrics::isActive() ? Timing::now() : 0;
+
+    // Event belongs to the innermost sentry ( or to entered context if there is no own sentry )
+    SpanContext span = captureContext();
+    uint64_t parentSpanId = ( last_s && last_s != contextBase_s ) ? last_s->parentSpanId_ : 0;
+
+    // Binary mode: store raw event, text will be produced by decoder
+    if ( BinaryLog::isActive() )
+    {
+        if ( args.va_ )
+            BinaryLog::write( level, curLevel_s, fn_name, isNested, span, parentSpanId, prefix, format, args.va_ );
+        else
+            BinaryLog::write( level, curLevel_s, fn_name, isNested, span, parentSpanId, prefix, format, args.typed_, args.count_ );
+        if ( startTicks )
+            LoggerMetrics::onEmitted( 0, startTicks, startTicks );
+        return;
+    }
+
+    // Check that some sink takes it ( or event goes to trace ).
+    // The same scope covers dispatch(), so thread is marked as reader once
+    LogSinks::ReadScope sinksScope;
+    bool isTraced = ChromeTrace::isActive() && ( level & LOG_ALL ) == LOG_EVENTS;
+    bool isWanted = LogSinks::isWanted( level );
+    if ( !isWanted && !isTraced )
+    {
+        if ( startTicks )
+            LoggerMetrics::onFiltered();
         return;
+    }
 
-    // Resize format buffer if needed
-    size_t sizeNew = strlen( format ) +
-                     fn_name.length() +
-                     curLevel_s +
-                     15;        // "[DBG]%02d{f} \0"
-    if ( sizeStr < sizeNew )
+    // Whole line is rendered in single pass into per-thread buffer
+    // ( no lock is needed and after first lines no allocation happens )
+    // and then the same text goes to all outputs
+    static thread_local std::string line;
+    line.assign( "[DBG]", 5 );
+
+    if ( isThreadIdMode_s )
     {
-        sizeStr = sizeNew + 150;        // extra to minimize reallocation
-        formatNew.reset( new char[ sizeStr ] );
+        line += 'T';
+        appendDecimal( line, getThreadId(), 1 );
+        line += ' ';
     }
 
-    std::string nested;
-    static char buflevel[10];
-    if ( !isNested )
+    if ( isSpanIdMode_s )
     {
-        buflevel[0] = 0;
+        appendHex64( line, span.traceId_ );
+        line += ':';
+        appendHex64( line, span.spanId_ );
+        line += ' ';
     }
-    else
+    if ( isNested )
     {
-        sprintf( buflevel, "%02d", curLevel_s );
+        appendDecimal( line, curLevel_s, 2 );
         switch ( level & LOG_ALL )
         {
-        case LOG_ENTER: nested = std::string( curLevel_s, '>' ); break;
-        case LOG_EVENTS:nested = std::string( curLevel_s, ' ' ); break;
-        case LOG_LEAVE: nested = std::string( curLevel_s, '<' ); break;
+        case LOG_ENTER: appendIndent( line, indentEnter, curLevel_s ); break;
+        case LOG_EVENTS:appendIndent( line, indentEvents, curLevel_s ); break;
+        case LOG_LEAVE: appendIndent( line, indentLeave, curLevel_s ); break;
         }
     }
 
-    if ( fn_name.length() )
-        sprintf( &formatNew[0], "[DBG]%s%s{%s} %s%s", buflevel, nested.c_str(), fn_name.c_str(), prefix, format );
+    if ( fn_name[0] )
+    {
+        line += '{';
+        line += fn_name;
+        line += '}';
+    }
+    line += ' ';
+    size_t messageStart = line.size();
+    line += prefix;
+
+    if ( args.va_ )
+        appendVA( line, format, args.va_ );
     else
-        sprintf( &formatNew[0], "[DBG]%s%s %s%s", buflevel, nested.c_str(), prefix, format );
+        ::tsv::util::tostr::formatArgs( line, format, args.typed_, args.count_ );
 
-    if ( LoggerHandler::handler_s )
-            LoggerHandler::handler_s( &formatNew[0], args );
-    if ( level & LOG_STDOUT )
+    // Enter/leave are "B"/"E" of sentry itself, so only events are instant ones
+    if ( isTraced )
+        ChromeTrace::instant( fn_name, line.c_str() + messageStart );
+    uint64_t sinkStartTicks = startTicks ? Timing::now() : 0;
+    if ( isWanted )
     {
-        vprintf( formatNew.get()+5, *reinterpret_cast<va_list*>(args) );
-        printf("\n");
+        LogRecord rec{ level, curLevel_s, getThreadId(), fn_name, getCurrentCallSite(), line.c_str(), line.size(),
+                       line.c_str() + messageStart, args.fields_, args.fieldCount_,
+                       span.traceId_, span.spanId_, parentSpanId };
+        LogSinks::dispatch( rec );
     }
+    if ( startTicks )
+        LoggerMetrics::onEmitted( line.size(), startTicks, sinkStartTicks );
 }
 
 // Enforced print "Enter scope" message
 void SentryLogger::print_enter( const char* format /*=""*/ , ... )
 {
+    va_list args;
+    va_start( args, format );
+    print_enterArgs( format, FormatArgs( &args ) );
+    va_end( args );
+}
+
+void SentryLogger::print_enterTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args )
+{
+    print_enterArgs( format, FormatArgs( args.begin(), args.size() ) );
+}
+
+void SentryLogger::print_enterArgs( const char* format, const FormatArgs& args )
+{
+    if ( !active_ )
+        return;
+
     // format==nullptr means no logging by sentry
     if ( !format )
     {
@@ -308,17 +692,13 @@ void SentryLogger::print_enter( const char* format /*=""*/ , ... )
     }
 
     // Do print
-    va_list args;
-    va_start( args, format );
-
     int level = LOG_ENTER | ( loggingFlags_ & LOG_STDOUT );
     if ( !format[0] )
         format = "scope";
     if ( isNestedLevelMode_s )
-        vwriteImplVA( level, name_, true, ">> Enter ", format, &args );
+        vwriteImpl( level, name_, true, ">> Enter ", format, args );
     else
-        vwriteImplVA( level, name_, false, "Enter ", format, &args );
-    va_end( args );
+        vwriteImpl( level, name_, false, "Enter ", format, args );
 
     log_state_ = state_;
 }
@@ -331,16 +711,25 @@ void SentryLogger::print_event( const char* format, ... )
     va_start( args, format );
 
     int level = LOG_EVENTS | ( logStdoutFlag_s ? LOG_STDOUT : 0 );
-    vwriteImplVA( level, "", isNestedLevelMode_s, "", format, &args );
+    vwriteImpl( level, "", isNestedLevelMode_s, "", format, FormatArgs( &args ) );
     va_end( args );
 }
 
+void SentryLogger::print_eventTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args )
+{
+    int level = LOG_EVENTS | ( logStdoutFlag_s ? LOG_STDOUT : 0 );
+    vwriteImpl( level, "", isNestedLevelMode_s, "", format, FormatArgs( args.begin(), args.size() ) );
+}
+
 // Specialization of stream operator
 //=============================
 template<>
 SentryLogger& SentryLogger::operator<< ( const LoggerEvent& val )
 {
-    processStream( true );
+    if ( !active_ )
+        return *this;
+    if ( stream_ )
+        processStream( true );
     log_state_ = (val.type_ & LOG_ALL);
     return *this;
 }
@@ -352,6 +741,11 @@ SentryLogger& SentryLogger::operator<< ( const LoggerEvent& val )
 //===================================================
 void SentryLogger::printBackTrace( int depth /*=-1*/, int skip /*=0*/, bool enforce /*=false*/ )
 {
+    // Could be turned off or rate-limited by rules for "printBackTrace"
+    static CallSite callsite( __func__, __FILE__, __LINE__ );
+    if ( !enforce && !callsite.isEnabled() )
+        return;
+
     // ask for backtrace (and ignore this function)
     auto array = ::tsv::debug::getBackTrace( depth, skip+1, enforce );
     for ( auto& s : array )
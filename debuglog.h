@@ -11,7 +11,13 @@
 
 #include <sstream>
 #include <string>
+#include <cstdarg>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include "debugcallsite.h"
 #include "debugresolve.h"
+#include "debugtiming.h"
 #include "tostr.h"
 
 /****************************************************************************
@@ -28,10 +34,17 @@
     SENTRY_ALT_FNSTREAM(FLAG1|FLAG2)() << your; - like SENTRY_FNSTREAM, but include extra tuning sentry with flags
 
 
+    SENTRY_FUNC_SAMPLED( policy, ... )  - like SENTRY_FUNC, but only sampled calls are logged
+                                          ( policy = everyN(n) | firstN(n) | perSecond(n), see debugcallsite.h )
+
     SAY_STACKTRACE( [ depth=-1[, skip=0[, enforce=false]]] ) - print stacktrace to current
     SAY_DBG( std::string | printf-like ) - print to log in scope of current sentry
     SAY_ARGS( var1, var2,.. )            - print variables names and values
 	SAY_EXPR( ... )				         - similar to above but useful to expressions
+    SAY_DBG_SAMPLED( policy, ... )       - like SAY_DBG, but only sampled calls are logged
+    SAY_STACKTRACE_SAMPLED( policy, ... ) - rate-limited SAY_STACKTRACE
+    SENTRY_CAPTURE_CONTEXT()             - get trace context of current sentry ( to hand off task to other thread )
+    SENTRY_ENTER_CONTEXT( context )      - continue captured trace context till the end of scope
     EXECUTE_IF_DEBUGLOG( line of code ) -- if logging is enabled, instantiate code inside, otherwise skip it
                                            Actually quick one-line version of #if DEBUG_LOGGING\nline of code\n#endif
 
@@ -44,6 +57,28 @@ NOTES:
     4. SentryLogger class could be used without macros to make specific scenario
     5. Giving nullptr as first value of SENTRY_* macro turn off its output
         ( make easy runtime conditional output )
+    6. Sentry chain and nesting level are per-thread, so logging from several
+       threads needs no extra lock. Thread id is shown in prefix as "T<id>"
+       ( could be turned off by SentryLogger::setThreadIdMode(false) )
+    7. Arguments of SAY_DBG/SENTRY_FUNC/SENTRY_CONTEXT are checked against format
+       at compile time (-Wformat) and are passed as typed values ( not via va_list ).
+       So each one is printed according to its real type and wrong argument could not crash.
+       Non-trivial values (std::string, your classes) are printed via toStr(),
+       but -Wformat wants .c_str() for std::string passed to %s.
+    8. Each macro expansion has static CallSite record, which could be turned off
+       at runtime by function name or file ( see debugcallsite.h ).
+       Disabled callsite costs one load and branch: sentry is not linked into
+       chain, arguments are not evaluated. SAY_* macros are statements.
+       Callsite could also log only sampled calls ( *_SAMPLED macros or CallSite::sampleByName() ).
+       SAY_* and SENTRY_FUNC_W_ARGS also check that flags of current sentry and outputs accept
+       event before any argument is evaluated, so filtered event costs the same whatever its arguments are.
+    9. Stream interface ( sentry << value ) has no std::ostream inside: values are printed
+       as ostream does by default, but manipulators (std::hex, std::setw) have no effect.
+   10. SAY_ARGS passes each value as typed field ( name, type, value ) in addition to
+       text line, so structured sinks ( JsonSink ) need not parse text.
+   11. Each active sentry has 64-bit span id, parent span id and trace id. Events carry
+       ids of their sentry ( see LogRecord, JsonSink ), so timeline of request which
+       hops between threads is joined by ids. See SpanContext below.
 
 ****************************************************************************/
 
@@ -55,18 +90,32 @@ NOTES:
 
 #if DEBUG_LOGGING
 
-#define SENTRY_SILENT        using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( __func__, "", LOG_EVENTS );               ::tsv::debug::SentryLoggerEmpty::empty_func
-#define SENTRY_FUNC          using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( __func__, "", LOG_ALL|LOG_NO_AUTOENTER);  sentry.print_enter
-#define SENTRY_FUNC_W_ARGS(...)  SENTRY_FUNC( TOSTR_ARGS( __VA_ARGS__ ) )
-#define SENTRY_ALT_FUNC(val)     using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( __func__, "", val | LOG_NO_AUTOENTER );   sentry.print_enter
-#define SENTRY_FNSTREAM()        using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( __func__, "", LOG_ALL|LOG_NO_AUTOENTER ); sentry<<::tsv::debug::LoggerEvent(LOG_ENTER)<<"Enter "
-#define SENTRY_ALT_FNSTREAM(val) using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( __func__, "", val|LOG_NO_AUTOENTER );     sentry<<::tsv::debug::LoggerEvent(LOG_ENTER)<<"Enter "
-#define SENTRY_CONTEXT( contextname,...)  using namespace ::tsv::debug::SentryLoggerFlags; ::tsv::debug::SentryLogger sentry( contextname, "", LOG_ALL|LOG_NO_AUTOENTER ); sentry.print_enter( __VA_ARGS__ )
-
-#define SAY_STACKTRACE  ::tsv::debug::SentryLogger::printBackTrace
-#define SAY_DBG         ::tsv::debug::SentryLogger::vwrite
-#define SAY_ARGS(...)   ::tsv::debug::SentryLogger::vwrite( TOSTR_ARGS(__VA_ARGS__) )
-#define SAY_EXPR(...)   ::tsv::debug::SentryLogger::vwrite( TOSTR_EXPR(__VA_ARGS__) )
+// Compile-time check of printf-like arguments (unevaluated, so no code is produced)
+#define SENTRY_CHECK_FORMAT(...) (void)sizeof( ::tsv::debug::FormatCheck::check( __VA_ARGS__ ) )
+
+// Static record of macro expansion ( constant-initialized )
+#define SENTRY_CALLSITE(var)     static ::tsv::debug::CallSite var( __func__, __FILE__, __LINE__ )
+#define SENTRY_CALLSITE_SAMPLED(var,policy)  static ::tsv::debug::CallSite var( __func__, __FILE__, __LINE__, ::tsv::debug::SamplePolicy::policy )
+
+#define SENTRY_SILENT        using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", LOG_EVENTS );               ::tsv::debug::SentryLoggerEmpty::empty_func
+#define SENTRY_FUNC(...)     using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", LOG_ALL|LOG_NO_AUTOENTER);  SENTRY_CHECK_FORMAT( __VA_ARGS__ ); if ( sentry.isActive() ) sentry.print_enter( __VA_ARGS__ )
+#define SENTRY_FUNC_W_ARGS(...)  using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", LOG_ALL|LOG_NO_AUTOENTER );  if ( sentry.isEnterWanted() ) sentry.print_enter( TOSTR_ARGS( __VA_ARGS__ ) )
+#define SENTRY_ALT_FUNC(val)     using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", val | LOG_NO_AUTOENTER );   if ( sentry.isActive() ) sentry.print_enter
+#define SENTRY_FNSTREAM()        using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", LOG_ALL|LOG_NO_AUTOENTER ); if ( sentry.isActive() ) sentry<<::tsv::debug::LoggerEvent(LOG_ENTER)<<"Enter "
+#define SENTRY_ALT_FNSTREAM(val) using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", val|LOG_NO_AUTOENTER );     if ( sentry.isActive() ) sentry<<::tsv::debug::LoggerEvent(LOG_ENTER)<<"Enter "
+#define SENTRY_FUNC_SAMPLED(policy,...)  using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE_SAMPLED( sentry_callsite, policy ); ::tsv::debug::SentryLogger sentry( sentry_callsite, __func__, "", LOG_ALL|LOG_NO_AUTOENTER);  SENTRY_CHECK_FORMAT( __VA_ARGS__ ); if ( sentry.isActive() ) sentry.print_enter( __VA_ARGS__ )
+#define SENTRY_CONTEXT( contextname,...)  using namespace ::tsv::debug::SentryLoggerFlags; SENTRY_CALLSITE( sentry_callsite ); ::tsv::debug::SentryLogger sentry( sentry_callsite, contextname, "", LOG_ALL|LOG_NO_AUTOENTER ); SENTRY_CHECK_FORMAT( __VA_ARGS__ ); if ( sentry.isActive() ) sentry.print_enter( __VA_ARGS__ )
+
+// Arguments of SAY_* are not evaluated if callsite is disabled
+#define SAY_STACKTRACE(...) do { SENTRY_CALLSITE( say_callsite ); if ( say_callsite.isEnabled() ) ::tsv::debug::SentryLogger::printBackTrace( __VA_ARGS__ ); } while ( 0 )
+#define SAY_DBG(...)    do { SENTRY_CHECK_FORMAT( __VA_ARGS__ ); SENTRY_CALLSITE( say_callsite ); if ( say_callsite.isEnabled() && ::tsv::debug::SentryLogger::isEventWanted() ) ::tsv::debug::SentryLogger::vwrite( __VA_ARGS__ ); } while ( 0 )
+#define SAY_DBG_SAMPLED(policy,...)        do { SENTRY_CHECK_FORMAT( __VA_ARGS__ ); SENTRY_CALLSITE_SAMPLED( say_callsite, policy ); if ( say_callsite.isEnabled() && ::tsv::debug::SentryLogger::isEventWanted() ) ::tsv::debug::SentryLogger::vwrite( __VA_ARGS__ ); } while ( 0 )
+#define SAY_STACKTRACE_SAMPLED(policy,...) do { SENTRY_CALLSITE_SAMPLED( say_callsite, policy ); if ( say_callsite.isEnabled() ) ::tsv::debug::SentryLogger::printBackTrace( __VA_ARGS__ ); } while ( 0 )
+#define SAY_ARGS(...)   do { SENTRY_CALLSITE( say_callsite ); if ( say_callsite.isEnabled() && ::tsv::debug::SentryLogger::isEventWanted() ) ::tsv::debug::SentryLogger::vwriteFields( #__VA_ARGS__, __VA_ARGS__ ); } while ( 0 )
+#define SAY_EXPR(...)   do { SENTRY_CALLSITE( say_callsite ); if ( say_callsite.isEnabled() && ::tsv::debug::SentryLogger::isEventWanted() ) ::tsv::debug::SentryLogger::vwrite( TOSTR_EXPR(__VA_ARGS__) ); } while ( 0 )
+
+#define SENTRY_CAPTURE_CONTEXT()        ::tsv::debug::SentryLogger::captureContext()
+#define SENTRY_ENTER_CONTEXT(context)   ::tsv::debug::SpanScope sentry_span_scope( context )
 
 #define EXECUTE_IF_DEBUGLOG(...) __VA_ARGS__
 
@@ -79,10 +128,16 @@ NOTES:
 #define SENTRY_ALT_FUNC(val)      SENTRY_SILENT
 #define SENTRY_ALT_FNSTREAM(val)  SENTRY_SILENT
 
+#define SENTRY_FUNC_SAMPLED(...)  SENTRY_FUNC()
+
 #define SAY_DBG(...)             ;
+#define SAY_DBG_SAMPLED(...)     ;
 #define SAY_STACKTRACE(...)      ;
+#define SAY_STACKTRACE_SAMPLED(...) ;
 #define SAY_ARGS(...)            ;
 #define SAY_EXPR(...)            ;
+#define SENTRY_CAPTURE_CONTEXT()        ::tsv::debug::SpanContext()
+#define SENTRY_ENTER_CONTEXT(context)   ;
 #define EXECUTE_IF_DEBUGLOG(...) ;
 
 #endif
@@ -94,9 +149,12 @@ NOTES:
 namespace tsv {
 namespace debug {
 
+struct ProfileNode;
+
 // PURPOSE: Output adaptor
 // Assign to handler_s function which will handle output of loggers
 // Also could add static member, which needed to control its behavior
+// ( handler_s is one of output sinks - LogSinks::SINK_HANDLER, see debugsink.h )
 //=========================
 struct LoggerHandler
 {
@@ -105,6 +163,179 @@ struct LoggerHandler
     typedef void (*handle_t)( const char* fmt, void* args );
 
     static handle_t handler_s;              // output handler
+
+    // Pass already prepared line to handler_s ( and to stdout if level has LOG_STDOUT )
+    static void output( int level, const char* line, size_t len );
+
+    // timing handler gets duration of each timed sentry ( LOG_TIMING )
+    // "name" = name of sentry, "ns" = execution time in nanoseconds
+    typedef void (*timing_handle_t)( const char* name, uint64_t ns );
+
+    static timing_handle_t timing_handler_s;    // nullptr = no handler
+};
+
+
+// PURPOSE: Named typed value of structured event ( SAY_ARGS )
+// Sinks get value with its type, "repr_" is how it looks in text line
+//=========================
+struct LogField
+{
+    enum Type { FIELD_INT, FIELD_UINT, FIELD_BOOL, FIELD_DOUBLE, FIELD_STR, FIELD_PTR,
+                FIELD_LITERAL };        // string literal argument: not a field, just text of line
+
+    const char* name_;                  // text of expression ( "obj.size()" ), not zero terminated
+    size_t      nameLen_;
+    Type type_;
+    union
+    {
+        long long          int_;
+        unsigned long long uint_;
+        double             double_;
+        const void*        ptr_;
+    };
+    std::string str_;                   // value of FIELD_STR ( toStr() for non-scalar types )
+    std::string repr_;                  // text of value in line
+
+    // "names" is cursor in list of names ( moved to next one )
+    template<typename T>
+    LogField( ::tsv::util::tostr::ArgNames& names, const T& value )
+        : nameLen_( names.next( name_ ) ), type_( FIELD_LITERAL ), uint_( 0 ),
+          repr_( ::tsv::util::tostr::toStr( value, isLiteral() ? ::tsv::util::tostr::ENUM_TOSTR_DEFAULT
+                                                                 : ::tsv::util::tostr::ENUM_TOSTR_REPR ) )
+    {
+        if ( !isLiteral() )
+            assign( value );
+    }
+
+    bool isLiteral() const { return name_[0] == '"'; }
+
+private:
+    void assign( bool v )                 { type_ = FIELD_BOOL; int_ = v; }
+    void assign( std::nullptr_t )         { type_ = FIELD_PTR; ptr_ = nullptr; }
+    void assign( const std::string& v )   { type_ = FIELD_STR; str_ = v; }
+    void assign( const char* v )
+    {
+        if ( v )
+            type_ = FIELD_STR, str_ = v;
+        else
+            type_ = FIELD_PTR, ptr_ = nullptr;
+    }
+    template<typename T>
+    typename std::enable_if< !std::is_same< typename std::remove_cv<T>::type, char >::value >::type
+    assign( T* v )                        { type_ = FIELD_PTR; ptr_ = v; }
+    template<typename T>
+    typename std::enable_if< ( std::is_integral<T>::value && std::is_signed<T>::value ) || std::is_enum<T>::value >::type
+    assign( const T& v )                  { type_ = FIELD_INT; int_ = static_cast<long long>( v ); }
+    template<typename T>
+    typename std::enable_if< std::is_integral<T>::value && std::is_unsigned<T>::value >::type
+    assign( const T& v )                  { type_ = FIELD_UINT; uint_ = v; }
+    template<typename T>
+    typename std::enable_if< std::is_floating_point<T>::value >::type
+    assign( const T& v )                  { type_ = FIELD_DOUBLE; double_ = static_cast<double>( v ); }
+    template<typename T>
+    typename std::enable_if< !std::is_arithmetic<T>::value && !std::is_enum<T>::value &&
+                             !std::is_pointer<T>::value && !std::is_array<T>::value >::type
+    assign( const T& v )                  { type_ = FIELD_STR; str_ = ::tsv::util::tostr::toStr( v ); }
+};
+
+
+// PURPOSE: Compile-time check of format and arguments of SENTRY_*, SAY_* macros
+// (used inside of sizeof() only, so functions are never defined)
+//=========================
+struct FormatCheck
+{
+    static int check();
+    static int check( const std::string& content );
+    static int check( const char* format, ... ) __attribute__(( format( printf, 1, 2 ) ));
+};
+
+
+// PURPOSE: Content of SentryLogger::operator<<
+// Lightweight replacement of std::ostringstream: values are appended
+// directly in the same text form as ostream gives by default
+// ( no locale, no stream state; types without own formatter go through ostringstream ).
+// Text is kept in inline buffer, so stream is a single allocation unless line is long
+//=========================
+struct SentryStream
+{
+    enum { SMALL_SIZE = 120 };
+    enum Kind { KIND_OTHER, KIND_CHAR, KIND_SIGNED, KIND_UNSIGNED, KIND_FLOAT, KIND_CSTR, KIND_STRING, KIND_POINTER };
+
+    // ostream prints pointer to any kind of char as string
+    template<class T>
+    struct IsByteString : std::integral_constant< bool,
+            std::is_same< typename std::decay<T>::type, signed char* >::value || std::is_same< typename std::decay<T>::type, const signed char* >::value ||
+            std::is_same< typename std::decay<T>::type, unsigned char* >::value || std::is_same< typename std::decay<T>::type, const unsigned char* >::value > {};
+
+    template<class T>
+    struct KindOf : std::integral_constant< int,
+            ( std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value ) ? KIND_CHAR :
+            std::is_integral<T>::value ? ( std::is_signed<T>::value ? KIND_SIGNED : KIND_UNSIGNED ) :
+            std::is_floating_point<T>::value ? KIND_FLOAT :
+            ( std::is_convertible<const T&, const char*>::value || IsByteString<T>::value ) ? KIND_CSTR :
+            std::is_same<T, std::string>::value ? KIND_STRING :
+            ( std::is_pointer<T>::value && !std::is_function< typename std::remove_pointer<T>::type >::value ) ? KIND_POINTER :
+            KIND_OTHER > {};
+
+    char*  data_;               // small_ or heap block for long text ( zero terminated )
+    size_t size_;
+    size_t capacity_;           // without terminating zero
+    size_t scanned_;            // head of data_ which is known to have no EOL
+    char   small_[SMALL_SIZE + 1];
+
+    SentryStream() : data_( small_ ), size_( 0 ), capacity_( SMALL_SIZE ), scanned_( 0 ) { small_[0] = 0; }
+    ~SentryStream() { if ( data_ != small_ ) delete[] data_; }
+
+    void write( const char* text, size_t len )
+    {
+        if ( size_ + len > capacity_ )
+            grow( size_ + len );
+        memcpy( data_ + size_, text, len );
+        size_ += len;
+        data_[size_] = 0;
+    }
+    void write( char c ) { write( &c, 1 ); }
+
+    // Remove first "len" chars
+    void erase( size_t len );
+
+    template<class T>
+    void append( const T& val )
+    {
+        put( val, std::integral_constant< int, KindOf<T>::value >() );
+    }
+
+    void putSigned( long long val );
+    void putUnsigned( unsigned long long val );
+    void putFloat( double val );
+    void putFloat( long double val );
+    void putString( const char* val );
+    void putPointer( const void* val );
+
+    private:
+        SentryStream( const SentryStream& );
+        SentryStream& operator=( const SentryStream& );
+
+        void grow( size_t need );
+
+        static const char* cstr( const char* val )          { return val; }
+        static const char* cstr( const signed char* val )   { return reinterpret_cast<const char*>( val ); }
+        static const char* cstr( const unsigned char* val ) { return reinterpret_cast<const char*>( val ); }
+
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_CHAR> )     { write( static_cast<char>( val ) ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_SIGNED> )   { putSigned( val ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_UNSIGNED> ) { putUnsigned( val ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_FLOAT> )    { putFloat( val ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_CSTR> )     { putString( cstr( val ) ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_STRING> )   { write( val.data(), val.size() ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_POINTER> )  { putPointer( val ); }
+        template<class T> void put( const T& val, std::integral_constant<int, KIND_OTHER> )
+        {
+            std::ostringstream os;
+            os << val;
+            const std::string& text = os.str();
+            write( text.data(), text.size() );
+        }
 };
 
 
@@ -120,6 +351,7 @@ namespace SentryLoggerFlags
 /************************************************************
 //      Use this class to log enter/leave func or scope
 //
+//  Name is not copied ( __func__ or literal is expected ).
 //  To conditional logging use nullptr or empty string:
 //      - nullptr mean no enter/leave logging + no vwrite log
 //  example:
@@ -128,35 +360,138 @@ namespace SentryLoggerFlags
 ************************************************************/
 class SentryLogger;
 
+/************************************************************
+//      Trace context: token to continue sentry chain on other thread
+//
+//  Span id of the root sentry is id of the whole trace. Sentry created
+//  after SpanScope is child of captured span and belongs to its trace.
+//      SpanContext ctx = SENTRY_CAPTURE_CONTEXT();
+//      pool.post( [ctx]() {
+//          SENTRY_ENTER_CONTEXT( ctx );
+//          SENTRY_FUNC();          // parent is sentry which captured ctx
+//          ... } );
+************************************************************/
+struct SpanContext
+{
+    uint64_t traceId_;
+    uint64_t spanId_;           // 0 = no context
+
+    SpanContext( uint64_t traceId = 0, uint64_t spanId = 0 ) : traceId_( traceId ), spanId_( spanId ) {}
+    bool isValid() const { return spanId_ != 0; }
+};
+
+// Make "context" current for this thread till the end of scope
+class SpanScope
+{
+    public:
+        explicit SpanScope( const SpanContext& context );
+        ~SpanScope();
+
+    private:
+        SpanContext         prevContext_;
+        const SentryLogger* prevBase_;
+
+        SpanScope( const SpanScope& );
+        SpanScope& operator=( const SpanScope& );
+};
+
 class SentryLogger
 {
     public:
 
-        SentryLogger( const char* name="", const char* args="", int logFlags = SentryLoggerFlags::LOG_ALL );
-        ~SentryLogger();
+        SentryLogger( const char* name="", const char* args="", int logFlags = SentryLoggerFlags::LOG_ALL ) : active_( true )
+        {
+            init( nullptr, name, args, logFlags );
+        }
+
+        // Sentry of macro: do nothing if "callsite" is disabled
+        SentryLogger( CallSite& callsite, const char* name, const char* args, int logFlags ) : active_( callsite.isEnabled() )
+        {
+            if ( active_ )
+                init( &callsite, name, args, logFlags );
+        }
+
+        ~SentryLogger()
+        {
+            if ( active_ )
+                finish();
+        }
+
+        // false if sentry was created by disabled callsite ( then it does nothing )
+        bool isActive() const { return active_; }
+
+        // Name of sentry and its source location ( nullptr if sentry is not created by macro )
+        const char* getName() const { return active_ ? name_ : ""; }
+        const CallSite* getCallSite() const { return active_ ? callsite_ : nullptr; }
+
+        // Callsite of the innermost sentry of this thread ( for handlers which want source location )
+        static const CallSite* getCurrentCallSite() { return last_s ? last_s->callsite_ : nullptr; }
+
+        // Ids of span ( 0 if sentry is not active )
+        uint64_t getTraceId() const      { return active_ ? traceId_ : 0; }
+        uint64_t getSpanId() const       { return active_ ? spanId_ : 0; }
+        uint64_t getParentSpanId() const { return active_ ? parentSpanId_ : 0; }
+
+        // Context of the innermost sentry of this thread ( or one entered by SpanScope )
+        static SpanContext captureContext();
+
+        // Cheap checks before arguments are evaluated: would event of current sentry
+        // ( or "enter" of this one ) pass flags and go to some output
+        static bool isEventWanted();
+        bool isEnterWanted() const;
 
         static void setLogStdoutSystemFlag( bool flag ) { logStdoutFlag_s = flag; }
         static void setNestedLevelMode( bool flag ) { isNestedLevelMode_s = flag; }
+        static void setThreadIdMode( bool flag ) { isThreadIdMode_s = flag; }
+        static void setSpanIdMode( bool flag ) { isSpanIdMode_s = flag; }
+        static bool isSpanIdMode() { return isSpanIdMode_s; }
 
-        int  getLoggingFlags() { return loggingFlags_; }
+        // Small sequential id of the calling thread (1 - first logged thread)
+        static int getThreadId();
+
+        int  getLoggingFlags() { return active_ ? loggingFlags_ : SentryLoggerFlags::LOG_OFF; }
         void setLoggingFlags( int flags )
         {
-             loggingFlags_ = ( loggingFlags_ & ~SentryLoggerFlags::LOG_ALL ) | ( flags & SentryLoggerFlags::LOG_ALL );
+             if ( active_ )
+                 loggingFlags_ = ( loggingFlags_ & ~SentryLoggerFlags::LOG_ALL ) | ( flags & SentryLoggerFlags::LOG_ALL );
         }
 
         // turn on or turn off timing
         void startTiming( bool value = true );
 
+        // nanoseconds since startTiming() ( 0 if timing is off )
+        uint64_t getElapsedNs() const;
+
         // printf-style debug log inside of sentried scope
         // to make conditional output use ( cond ? "FMT" : "" )
         static void vwrite( const char* format, ... );
         static void vwrite( const std::string& content ) { vwrite( "%s", content.c_str() ); }
 
+        // Typed version: arguments are not passed through va_list
+        template<typename... Args>
+        static void vwrite( const char* format, const Args&... args )
+        {
+            vwriteTyped( format, { ::tsv::util::tostr::FormatArg( ::tsv::util::tostr::passArg( args ) )... } );
+        }
+
+        // Structured version ( SAY_ARGS ): "names" are texts of arguments
+        // Line looks as TOSTR_ARGS() gives, and values go to sinks as typed fields
+        template<typename... Args>
+        static void vwriteFields( const char* names, const Args&... args )
+        {
+            ::tsv::util::tostr::ArgNames cursor( names );
+            vwriteFieldsImpl( { LogField( cursor, args )... } );
+        }
+
         // Stream interface
         template<class T>
         SentryLogger& operator<< ( const T& val )
         {
-                stream<<val;
+                if ( !active_ )
+                    return *this;
+                if ( !stream_ )
+                    stream_ = new SentryStream();
+                stream_->append( val );
                 processStream( false );
                 return *this;
         }
@@ -172,38 +507,102 @@ class SentryLogger
         // Safe versions of functions (ignore '%' chars if that is just a string )
         void print_enter( const std::string& content )        { print_enter( "%s", content.c_str() ); }
 
+        // Typed version of print_enter
+        template<typename... Args>
+        void print_enter( const char* format, const Args&... args )
+        {
+            print_enterTyped( format, { ::tsv::util::tostr::FormatArg( ::tsv::util::tostr::passArg( args ) )... } );
+        }
+
         // logging of enforced "events"
         // to make conditional output use ( cond ? "FMT" : "" )
         static void print_event( const char* format, ... );
         static void print_event( const std::string& content ) { print_event( "%s", content.c_str() ); }
 
+        // Typed version of print_event
+        template<typename... Args>
+        static void print_event( const char* format, const Args&... args )
+        {
+            print_eventTyped( format, { ::tsv::util::tostr::FormatArg( ::tsv::util::tostr::passArg( args ) )... } );
+        }
+
+        // Arguments of printf-like call: either C variadic ones or typed ones
+        struct FormatArgs
+        {
+            va_list* va_;
+            const ::tsv::util::tostr::FormatArg* typed_;
+            size_t count_;
+            const LogField* fields_;    // structured values of event ( SAY_ARGS )
+            size_t fieldCount_;
+
+            explicit FormatArgs( va_list* va )
+                : va_( va ), typed_( nullptr ), count_( 0 ), fields_( nullptr ), fieldCount_( 0 ) {}
+            FormatArgs( const ::tsv::util::tostr::FormatArg* typed, size_t count, const LogField* fields = nullptr, size_t fieldCount = 0 )
+                : va_( nullptr ), typed_( typed ), count_( count ), fields_( fields ), fieldCount_( fieldCount ) {}
+        };
+
     protected:
-        std::string name_;              // name of sentry
+        bool active_;                   // false = created by disabled callsite, other members are not initialized
+        const char* name_;              // name of sentry ( not copied, so have to live while sentry exists )
+        const CallSite* callsite_;      // static descriptor of macro ( nullptr if created directly )
         int loggingFlags_;              // set of LOG_* flags
         int state_;                     // current state of sentry
         int log_state_;                 // current state of sentry (as thought by processStream)
-        std::ostringstream stream;      // content of <<
-        double starttime_;              // timestamp of start sentry timer
-
-
-        static int  curLevel_s;             // current level (depth)
-
-        static SentryLogger* last_s;     // head of stack (nullptr means no sentry was allocated)
+        SentryStream* stream_;          // content of << ( allocated on first use )
+        uint64_t startTicks_;           // timestamp of start sentry timer ( Timing::now() )
+        ProfileNode* profNode_;         // node of calling context tree ( nullptr if not profiled )
+        uint64_t profStartTicks_;       // timestamp of enter for profiler
+        bool traced_;                   // true if "B" event was written to ChromeTrace
+        uint64_t traceId_;              // span id of root sentry of trace
+        uint64_t spanId_;
+        uint64_t parentSpanId_;         // 0 = root of trace
+
+
+        // Sentry chain is per-thread, so nested levels and {context}
+        // of concurrent threads are never mixed up and no lock is needed
+        static thread_local int  curLevel_s;        // current level (depth) of this thread
+        static thread_local int  threadId_s;        // id of this thread (0 = not assigned yet)
+
+        static thread_local SentryLogger* last_s;   // head of this thread stack (nullptr means no sentry was allocated)
         SentryLogger* prev_sentry_;      // uni-direction backward linked list of sentries
 
+        // Context entered by SpanScope. It is parent while last_s is the same as at entering
+        static thread_local SpanContext context_s;
+        static thread_local const SentryLogger* contextBase_s;
+        friend class SpanScope;
+
     protected:
         // System settings
         static bool logStdoutFlag_s;        // true to enforce LOG_STDOUT
         static bool isNestedLevelMode_s;    // true to log in format  >>>>> value
+        static bool isThreadIdMode_s;       // true to include thread id into prefix
+        static bool isSpanIdMode_s;         // true to include "trace:span" ids into prefix
 
     protected:
         SentryLogger( const SentryLogger& );
         SentryLogger& operator=( const SentryLogger& );
 
+        // real ctor/dtor of active sentry
+        void init( const CallSite* callsite, const char* name, const char* args, int logFlags );
+        void finish();
+
         void processStream( bool enforce );
 
-        // real string processor ("args" actually is va_list* )
-        static void vwriteImplVA( int level, const std::string& fn_name, bool isNested, const char* prefix, const char* format, void* args );
+        static void vwriteTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args );
+        void print_enterTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args );
+        static void print_eventTyped( const char* format, std::initializer_list< ::tsv::util::tostr::FormatArg > args );
+        static void vwriteFieldsImpl( std::initializer_list<LogField> fields );
+
+        // common part of vwrite/print_enter/print_event
+        static void vwriteArgs( const char* format, const FormatArgs& args );
+
+        // Level of vwrite() event of current sentry ( 0 = rejected by its flags )
+        static int getEventLevel();
+        static void resetEventState();
+        void print_enterArgs( const char* format, const FormatArgs& args );
+
+        // real string processor
+        static void vwriteImpl( int level, const char* fn_name, bool isNested, const char* prefix, const char* format, const FormatArgs& args );
 };
 
 struct LoggerEvent;
@@ -0,0 +1,308 @@
+/*********************************************************************
+  Purpose: Self-instrumentation of logger ( how much it costs )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <chrono>
+#include <algorithm>        // find_if
+#include <condition_variable>
+#include <cstdio>           // snprintf
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "debuglog.h"
+#include "debugasync.h"
+#include "debugcallsite.h"
+#include "debugfilesink.h"
+#include "debugmetrics.h"
+#include "debugresolve.h"
+#include "debugtiming.h"
+#include "objlog.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> LoggerMetrics::active_s( false );
+
+namespace {
+
+// Counters of one thread. When thread finishes, they are added to MetricsState::retired_
+struct ThreadCounters
+{
+    std::atomic<uint64_t> emitted_;         // updated by owner thread only
+    std::atomic<uint64_t> filtered_;
+    std::atomic<uint64_t> bytes_;
+    std::atomic<uint64_t> loggerTicks_;
+    std::atomic<uint64_t> sinkTicks_;
+
+    // Values at last reset(). Counters are never zeroed, because owner thread
+    // could write back its increment over zero. Guarded by MetricsState::mutex_
+    uint64_t emittedBase_, filteredBase_, bytesBase_, loggerTicksBase_, sinkTicksBase_;
+
+    ThreadCounters() : emitted_( 0 ), filtered_( 0 ), bytes_( 0 ), loggerTicks_( 0 ), sinkTicks_( 0 ),
+                       emittedBase_( 0 ), filteredBase_( 0 ), bytesBase_( 0 ), loggerTicksBase_( 0 ), sinkTicksBase_( 0 ) {}
+
+    // Add counters of finished thread ( both values and bases, so its delta since reset() is kept )
+    void retire( const ThreadCounters& from )
+    {
+        emitted_.store( emitted_.load( std::memory_order_relaxed ) + from.emitted_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        filtered_.store( filtered_.load( std::memory_order_relaxed ) + from.filtered_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        bytes_.store( bytes_.load( std::memory_order_relaxed ) + from.bytes_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        loggerTicks_.store( loggerTicks_.load( std::memory_order_relaxed ) + from.loggerTicks_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        sinkTicks_.store( sinkTicks_.load( std::memory_order_relaxed ) + from.sinkTicks_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        emittedBase_     += from.emittedBase_;
+        filteredBase_    += from.filteredBase_;
+        bytesBase_       += from.bytesBase_;
+        loggerTicksBase_ += from.loggerTicksBase_;
+        sinkTicksBase_   += from.sinkTicksBase_;
+    }
+
+    // Remember current values as zero point. MetricsState::mutex_ have to be locked
+    void rebase()
+    {
+        emittedBase_     = emitted_.load( std::memory_order_relaxed );
+        filteredBase_    = filtered_.load( std::memory_order_relaxed );
+        bytesBase_       = bytes_.load( std::memory_order_relaxed );
+        loggerTicksBase_ = loggerTicks_.load( std::memory_order_relaxed );
+        sinkTicksBase_   = sinkTicks_.load( std::memory_order_relaxed );
+    }
+};
+
+struct MetricsState
+{
+    std::mutex               mutex_;
+    std::vector< std::unique_ptr<ThreadCounters> > threads_;    // of live threads
+    ThreadCounters           retired_;      // sum of finished threads
+    uint64_t                 startNs_;      // of start() or reset()
+    uint64_t                 droppedBase_;  // dropped at start() or reset() ( their counters are not ours )
+
+    std::thread              thread_;       // summary
+    std::condition_variable  cond_;
+    bool                     stop_;
+    int                      intervalMs_;
+
+    MetricsState() : startNs_( 0 ), droppedBase_( 0 ), stop_( false ), intervalMs_( 0 ) {}
+};
+
+MetricsState& state()
+{
+    // Leaked intentionally: events of static objects could be logged after us
+    static MetricsState* state = new MetricsState();
+    return *state;
+}
+
+// Move counters of finished thread to retired_ and free them
+struct ThreadCountersHolder
+{
+    ThreadCounters* counters_;
+    ThreadCountersHolder() : counters_( nullptr ) {}
+    ~ThreadCountersHolder()
+    {
+        if ( !counters_ )
+            return;
+        MetricsState& st = state();
+        std::lock_guard<std::mutex> lock( st.mutex_ );
+        st.retired_.retire( *counters_ );
+        st.threads_.erase( std::find_if( st.threads_.begin(), st.threads_.end(),
+                                         [this]( const std::unique_ptr<ThreadCounters>& p ) { return p.get() == counters_; } ) );
+        counters_ = nullptr;
+    }
+};
+
+ThreadCounters& threadCounters()
+{
+    static thread_local ThreadCountersHolder holder;
+    if ( !holder.counters_ )
+    {
+        ThreadCounters* counters = new ThreadCounters();
+        std::lock_guard<std::mutex> lock( state().mutex_ );
+        state().threads_.emplace_back( counters );
+        holder.counters_ = counters;
+    }
+    return *holder.counters_;
+}
+
+// Increment of counter which is changed by owner thread only ( no lock prefix needed )
+inline void addRelaxed( std::atomic<uint64_t>& counter, uint64_t value )
+{
+    counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+uint64_t droppedTotal()
+{
+    return AsyncLogger::getDroppedNewest() + AsyncLogger::getDroppedOldest() + CallSite::getSuppressedTotal()
+         + FileSink::getDropped();
+}
+
+// Sum counters. state().mutex_ have to be locked
+LoggerStats collectLocked()
+{
+    MetricsState& st = state();
+    LoggerStats stats = LoggerStats();
+    uint64_t loggerTicks = 0, sinkTicks = 0;
+    auto add = [&]( const ThreadCounters& counters )
+    {
+        stats.eventsEmitted_  += counters.emitted_.load( std::memory_order_relaxed ) - counters.emittedBase_;
+        stats.eventsFiltered_ += counters.filtered_.load( std::memory_order_relaxed ) - counters.filteredBase_;
+        stats.bytesFormatted_ += counters.bytes_.load( std::memory_order_relaxed ) - counters.bytesBase_;
+        loggerTicks           += counters.loggerTicks_.load( std::memory_order_relaxed ) - counters.loggerTicksBase_;
+        sinkTicks             += counters.sinkTicks_.load( std::memory_order_relaxed ) - counters.sinkTicksBase_;
+    };
+    for ( auto& counters : st.threads_ )
+        add( *counters );
+    add( st.retired_ );
+    stats.loggerNs_  = Timing::toNs( loggerTicks );
+    stats.sinkNs_    = Timing::toNs( sinkTicks );
+    stats.threads_   = st.threads_.size();
+    stats.elapsedNs_ = st.startNs_ ? Timing::nowNs() - st.startNs_ : 0;
+    stats.eventsDropped_ = droppedTotal() - st.droppedBase_;
+
+    stats.addrCacheSize_       = getAddrCacheSize();
+    stats.stackTraceCacheSize_ = getStackTraceCacheSize();
+    stats.trackedObjects_      = ObjLogger::getTrackedCount();
+    stats.callSites_           = CallSite::getRegisteredCount();
+    return stats;
+}
+
+/**********************************************************************************
+   PURPOSE:   Background thread: log summary of each interval
+**********************************************************************************/
+void summaryLoop()
+{
+    MetricsState& st = state();
+    std::unique_lock<std::mutex> lock( st.mutex_ );
+    LoggerStats prev = collectLocked();
+    while ( !st.stop_ )
+    {
+        st.cond_.wait_for( lock, std::chrono::milliseconds( st.intervalMs_ ) );
+        if ( st.stop_ )
+            break;
+        LoggerStats stats = collectLocked();
+        std::string line = "[metrics] " + stats.since( prev ).toString();
+        prev = stats;
+
+        // event comes back to us through onEmitted()
+        lock.unlock();
+        SentryLogger::print_event( "%s", line.c_str() );
+        lock.lock();
+    }
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Difference of counters
+**********************************************************************************/
+LoggerStats LoggerStats::since( const LoggerStats& prev ) const
+{
+    LoggerStats diff = *this;
+    diff.eventsEmitted_  -= prev.eventsEmitted_;
+    diff.eventsFiltered_ -= prev.eventsFiltered_;
+    diff.eventsDropped_  -= prev.eventsDropped_;
+    diff.bytesFormatted_ -= prev.bytesFormatted_;
+    diff.loggerNs_       -= prev.loggerNs_;
+    diff.sinkNs_         -= prev.sinkNs_;
+    diff.elapsedNs_      -= prev.elapsedNs_;
+    return diff;
+}
+
+std::string LoggerStats::toString() const
+{
+    char buf[320];
+    snprintf( buf, sizeof(buf), "events=%llu filtered=%llu dropped=%llu bytes=%llu logger=%lluus (%.2f%%) sinks=%lluus threads=%u"
+                                " caches: addr=%u stacktraces=%u objects=%u callsites=%u",
+              static_cast<unsigned long long>( eventsEmitted_ ), static_cast<unsigned long long>( eventsFiltered_ ),
+              static_cast<unsigned long long>( eventsDropped_ ), static_cast<unsigned long long>( bytesFormatted_ ),
+              static_cast<unsigned long long>( loggerNs_ / 1000 ), getShare() * 100,
+              static_cast<unsigned long long>( sinkNs_ / 1000 ), static_cast<unsigned>( threads_ ),
+              static_cast<unsigned>( addrCacheSize_ ), static_cast<unsigned>( stackTraceCacheSize_ ),
+              static_cast<unsigned>( trackedObjects_ ), static_cast<unsigned>( callSites_ ) );
+    return buf;
+}
+
+/**********************************************************************************
+   PURPOSE:   Start counting ( and summary thread )
+**********************************************************************************/
+void LoggerMetrics::start( int summaryIntervalMs /*=0*/ )
+{
+    stop();
+    reset();
+    MetricsState& st = state();
+    std::lock_guard<std::mutex> lock( st.mutex_ );
+    st.intervalMs_ = summaryIntervalMs;
+    st.stop_ = false;
+    if ( summaryIntervalMs > 0 )
+        st.thread_ = std::thread( summaryLoop );
+    active_s.store( true );
+}
+
+void LoggerMetrics::stop()
+{
+    MetricsState& st = state();
+    {
+        std::lock_guard<std::mutex> lock( st.mutex_ );
+        active_s.store( false );
+        st.stop_ = true;
+        st.cond_.notify_one();
+    }
+    if ( st.thread_.joinable() )
+        st.thread_.join();
+}
+
+void LoggerMetrics::reset()
+{
+    MetricsState& st = state();
+    std::lock_guard<std::mutex> lock( st.mutex_ );
+    for ( auto& counters : st.threads_ )
+        counters->rebase();
+    st.retired_.rebase();
+    st.startNs_ = Timing::nowNs();
+    st.droppedBase_ = droppedTotal();
+}
+
+LoggerStats LoggerMetrics::collect()
+{
+    std::lock_guard<std::mutex> lock( state().mutex_ );
+    return collectLocked();
+}
+
+void LoggerMetrics::report( std::ostream& out )
+{
+    LoggerStats stats = collect();
+    out << "Logger metrics for " << stats.elapsedNs_ / 1000000 << " ms, " << stats.threads_ << " threads\n"
+        << "  events emitted:       " << stats.eventsEmitted_ << '\n'
+        << "  events filtered:      " << stats.eventsFiltered_ << '\n'
+        << "  events dropped:       " << stats.eventsDropped_ << '\n'
+        << "  bytes formatted:      " << stats.bytesFormatted_ << '\n'
+        << "  time in logger:       " << stats.loggerNs_ / 1000 << " us (" << stats.getShare() * 100 << "% of one CPU)\n"
+        << "  time in sinks:        " << stats.sinkNs_ / 1000 << " us\n"
+        << "  cached addresses:     " << stats.addrCacheSize_ << '\n'
+        << "  cached stacktraces:   " << stats.stackTraceCacheSize_ << '\n'
+        << "  tracked objects:      " << stats.trackedObjects_ << '\n'
+        << "  registered callsites: " << stats.callSites_ << '\n';
+}
+
+/**********************************************************************************
+   PURPOSE:   Hooks of SentryLogger
+**********************************************************************************/
+void LoggerMetrics::onFiltered()
+{
+    addRelaxed( threadCounters().filtered_, 1 );
+}
+
+void LoggerMetrics::onEmitted( size_t bytes, uint64_t startTicks, uint64_t sinkStartTicks )
+{
+    uint64_t now = Timing::now();
+    ThreadCounters& counters = threadCounters();
+    addRelaxed( counters.emitted_, 1 );
+    addRelaxed( counters.bytes_, bytes );
+    addRelaxed( counters.loggerTicks_, now - startTicks );
+    addRelaxed( counters.sinkTicks_, now - sinkStartTicks );
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,99 @@
+#ifndef DEBUGMETRICS_H_
+#define DEBUGMETRICS_H_ 1
+
+/*********************************************************************
+  Purpose: Self-instrumentation of logger ( how much it costs )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Logger metrics
+
+  HOWTO USE:
+     LoggerMetrics::start();             // or start( 10000 ) - summary event each 10 sec
+     ...
+     LoggerStats stats = LoggerMetrics::collect();
+     if ( stats.getShare() > 0.02 )      // logger takes more than 2% of one CPU
+         ...
+     LoggerMetrics::report( std::cout );
+     LoggerMetrics::stop();
+
+  NOTES:
+    1. Each thread has own counters, so counting takes no lock.
+       Counters of all threads are summed on demand. Counters of finished thread
+       are added to common totals and freed, so they are kept without growing memory.
+    2. Time is measured from entering formatting of event until all sinks got it.
+       Event which was rejected by flags or which no sink wants is "filtered".
+       "Dropped" are lines lost by full AsyncLogger queue or by FileSink which could
+       not create new file, and calls skipped by sampling of callsites. Disabled callsite costs one load, so it is not counted.
+    3. Summary is printed as usual event ( so it goes to all sinks ) from background thread.
+       Share in summary is of last interval.
+******************************************************************************/
+
+struct LoggerStats
+{
+    uint64_t eventsEmitted_;        // formatted and passed to sinks ( or binary log )
+    uint64_t eventsFiltered_;       // rejected by flags or not wanted by any sink
+    uint64_t eventsDropped_;        // AsyncLogger queue overflow + FileSink errors + sampled out callsite calls
+    uint64_t bytesFormatted_;
+    uint64_t loggerNs_;             // time inside of logger ( formatting + sinks )
+    uint64_t sinkNs_;               // part of loggerNs_ spent in handler and sinks
+    uint64_t elapsedNs_;            // wall time since start() or reset()
+    size_t   threads_;              // live threads which logged something
+
+    // Sizes of internal caches
+    size_t   addrCacheSize_;        // resolved addresses
+    size_t   stackTraceCacheSize_;  // remembered stacktraces
+    size_t   trackedObjects_;       // objects of ObjLogger
+    size_t   callSites_;            // registered callsites
+
+    // Logger time as share of wall time of one CPU
+    double getShare() const { return elapsedNs_ ? static_cast<double>( loggerNs_ ) / elapsedNs_ : 0; }
+
+    // Counters which are grown since "prev" ( cache sizes are current )
+    LoggerStats since( const LoggerStats& prev ) const;
+
+    // One line: "events=... filtered=... dropped=... bytes=... logger=...us (...%) sinks=...us caches: ..."
+    std::string toString() const;
+};
+
+class LoggerMetrics
+{
+    public:
+        // Start counting. If summaryIntervalMs > 0, then summary event is logged each interval
+        static void start( int summaryIntervalMs = 0 );
+        static void stop();
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Zero all counters
+        static void reset();
+
+        // Sum counters of all threads
+        static LoggerStats collect();
+
+        // Print collected statistic
+        static void report( std::ostream& out );
+
+        // Hooks of SentryLogger ( ticks are Timing::now() when formatting and output started )
+        static void onFiltered();
+        static void onEmitted( size_t bytes, uint64_t startTicks, uint64_t sinkStartTicks );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,225 @@
+/*********************************************************************
+  Purpose: Calling context tree profiler built from SentryLogger scopes
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <mutex>
+#include <map>
+#include <memory>           // unique_ptr
+#include <algorithm>        // sort
+#include <cstdio>           // snprintf
+
+#include "debugprofile.h"
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> Profiler::active_s( false );
+
+namespace {
+
+// Calling context tree of one thread. Never freed, so profile of finished thread is kept
+struct ThreadTree
+{
+    ProfileNode  root_;
+    ProfileNode* current_;                  // node of innermost active sentry
+
+    ThreadTree() : root_( "", nullptr ), current_( &root_ ) {}
+};
+
+struct ProfileState
+{
+    std::mutex mutex_;
+    std::vector< std::unique_ptr<ThreadTree> > trees_;
+};
+
+ProfileState& state()
+{
+    // Leaked intentionally: sentries of static objects could be destroyed after us
+    static ProfileState* state = new ProfileState();
+    return *state;
+}
+
+ThreadTree* threadTree()
+{
+    static thread_local ThreadTree* tree = nullptr;
+    if ( !tree )
+    {
+        tree = new ThreadTree();
+        std::lock_guard<std::mutex> lock( state().mutex_ );
+        state().trees_.emplace_back( tree );
+    }
+    return tree;
+}
+
+// Increment of counter which is changed by owner thread only ( no lock prefix needed )
+inline void addRelaxed( std::atomic<uint64_t>& counter, uint64_t value )
+{
+    counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+// Merged node
+struct MergedNode
+{
+    uint64_t calls_;
+    uint64_t ticks_;
+    std::map<std::string, MergedNode> children_;
+
+    MergedNode() : calls_( 0 ), ticks_( 0 ) {}
+};
+
+void mergeTree( const ProfileNode* node, MergedNode& merged )
+{
+    for ( const ProfileNode* child = node->firstChild_.load( std::memory_order_acquire ); child;
+          child = child->nextSibling_.load( std::memory_order_acquire ) )
+    {
+        MergedNode& dst = merged.children_[ child->name_ ];
+        dst.calls_ += child->calls_.load( std::memory_order_relaxed );
+        dst.ticks_ += child->ticks_.load( std::memory_order_relaxed );
+        mergeTree( child, dst );
+    }
+}
+
+void flatten( const MergedNode& node, const std::string& path, int depth, std::vector<ProfileEntry>& out )
+{
+    std::vector< std::pair<const std::string*, const MergedNode*> > children;
+    for ( auto& child : node.children_ )
+        children.push_back( std::make_pair( &child.first, &child.second ) );
+    std::sort( children.begin(), children.end(),
+               []( const std::pair<const std::string*, const MergedNode*>& a, const std::pair<const std::string*, const MergedNode*>& b )
+               { return a.second->ticks_ > b.second->ticks_; } );
+
+    for ( auto& child : children )
+    {
+        const MergedNode& n = *child.second;
+        uint64_t childTicks = 0;
+        for ( auto& grandChild : n.children_ )
+            childTicks += grandChild.second.ticks_;
+
+        ProfileEntry entry;
+        entry.path_ = path.empty() ? *child.first : path + ";" + *child.first;
+        entry.depth_ = depth;
+        entry.calls_ = n.calls_;
+        entry.inclusiveNs_ = Timing::toNs( n.ticks_ );
+        entry.exclusiveNs_ = Timing::toNs( n.ticks_ > childTicks ? n.ticks_ - childTicks : 0 );
+        out.push_back( entry );
+        flatten( n, entry.path_, depth + 1, out );
+    }
+}
+
+void resetTree( ProfileNode* node )
+{
+    for ( ProfileNode* child = node->firstChild_.load(); child; child = child->nextSibling_.load() )
+    {
+        child->calls_.store( 0 );
+        child->ticks_.store( 0 );
+        resetTree( child );
+    }
+}
+
+}   // anonymous namespace
+
+void Profiler::start()
+{
+    Timing::init();
+    active_s.store( true );
+}
+
+void Profiler::stop()
+{
+    active_s.store( false );
+}
+
+/**********************************************************************************
+   PURPOSE:   Zero all counters
+   NOTE:      Events which are counted at the same moment by other threads could survive
+**********************************************************************************/
+void Profiler::reset()
+{
+    std::lock_guard<std::mutex> lock( state().mutex_ );
+    for ( auto& tree : state().trees_ )
+        resetTree( &tree->root_ );
+}
+
+/**********************************************************************************
+   PURPOSE:   Sentry enters scope "name"
+   RETURN:    node which have to be given to leave()
+**********************************************************************************/
+ProfileNode* Profiler::enter( const char* name )
+{
+    ThreadTree* tree = threadTree();
+    ProfileNode* parent = tree->current_;
+
+    ProfileNode* node = parent->firstChild_.load( std::memory_order_relaxed );
+    for ( ; node; node = node->nextSibling_.load( std::memory_order_relaxed ) )
+        if ( node->name_ == name )
+            break;
+
+    if ( !node )
+    {
+        // Only owner adds children, so just publish fully constructed node
+        node = new ProfileNode( name, parent );
+        node->nextSibling_.store( parent->firstChild_.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+        parent->firstChild_.store( node, std::memory_order_release );
+    }
+
+    tree->current_ = node;
+    return node;
+}
+
+/**********************************************************************************
+   PURPOSE:   Sentry leaves scope of "node"
+**********************************************************************************/
+void Profiler::leave( ProfileNode* node, uint64_t startTicks )
+{
+    addRelaxed( node->calls_, 1 );
+    addRelaxed( node->ticks_, Timing::now() - startTicks );
+    threadTree()->current_ = node->parent_;
+}
+
+/**********************************************************************************
+   PURPOSE:   Merge trees of all threads
+**********************************************************************************/
+std::vector<ProfileEntry> Profiler::collect()
+{
+    MergedNode root;
+    {
+        std::lock_guard<std::mutex> lock( state().mutex_ );
+        for ( auto& tree : state().trees_ )
+            mergeTree( &tree->root_, root );
+    }
+
+    std::vector<ProfileEntry> entries;
+    flatten( root, "", 0, entries );
+    return entries;
+}
+
+void Profiler::report( std::ostream& out )
+{
+    char buf[128];
+    snprintf( buf, sizeof(buf), "%16s %16s %10s  %s\n", "inclusive ns", "exclusive ns", "calls", "scope" );
+    out << buf;
+    for ( auto& entry : collect() )
+    {
+        snprintf( buf, sizeof(buf), "%16llu %16llu %10llu  ",
+                  static_cast<unsigned long long>( entry.inclusiveNs_ ),
+                  static_cast<unsigned long long>( entry.exclusiveNs_ ),
+                  static_cast<unsigned long long>( entry.calls_ ) );
+        size_t nameStart = entry.path_.rfind( ';' );
+        nameStart = ( nameStart == std::string::npos ) ? 0 : nameStart + 1;
+        out << buf << std::string( entry.depth_ * 2, ' ' ) << entry.path_.substr( nameStart ) << "\n";
+    }
+}
+
+void Profiler::writeFolded( std::ostream& out )
+{
+    for ( auto& entry : collect() )
+        if ( entry.exclusiveNs_ )
+            out << entry.path_ << " " << entry.exclusiveNs_ << "\n";
+}
+
+}   // namespace debug
+}   // namespace tsv
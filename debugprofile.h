@@ -0,0 +1,93 @@
+#ifndef DEBUGPROFILE_H_
+#define DEBUGPROFILE_H_ 1
+
+/*********************************************************************
+  Purpose: Calling context tree profiler built from SentryLogger scopes
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Profiling mode
+
+  HOWTO USE:
+     Profiler::start();          // from now each sentry (even silent one) is counted
+     ... SENTRY_* as usual ...
+     Profiler::stop();
+     Profiler::report( std::cout );          // tree sorted by inclusive time
+     Profiler::writeFolded( file );          // input for flamegraph.pl
+
+  NOTES:
+    1. Each thread has own calling context tree, so sentry enter/leave takes no lock.
+       Trees of all threads ( including finished ones ) are merged on demand.
+    2. Node of tree keeps number of calls and inclusive time.
+       Exclusive time = inclusive - inclusive of children.
+    3. Works regardless of logging flags: SENTRY_SILENT or sentry with output off are counted too.
+******************************************************************************/
+
+// Node of calling context tree of one thread
+struct ProfileNode
+{
+    std::string  name_;
+    ProfileNode* parent_;
+    std::atomic<ProfileNode*> firstChild_;     // published by owner thread, read by merge
+    std::atomic<ProfileNode*> nextSibling_;
+    std::atomic<uint64_t> calls_;              // updated by owner thread only
+    std::atomic<uint64_t> ticks_;              // inclusive time in Timing ticks
+
+    ProfileNode( const std::string& name, ProfileNode* parent )
+        : name_( name ), parent_( parent ), firstChild_( nullptr ), nextSibling_( nullptr ), calls_( 0 ), ticks_( 0 ) {}
+};
+
+// Merged statistic of one calling context
+struct ProfileEntry
+{
+    std::string path_;          // names from root joined by ';'
+    int         depth_;         // 0 = top-level scope
+    uint64_t    calls_;
+    uint64_t    inclusiveNs_;
+    uint64_t    exclusiveNs_;
+};
+
+class Profiler
+{
+    public:
+        static void start();
+        static void stop();
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Zero all counters
+        static void reset();
+
+        // Merge trees of all threads. Entries are in depth-first order,
+        // children of each node are sorted by inclusive time
+        static std::vector<ProfileEntry> collect();
+
+        // Print merged tree: inclusive, exclusive time, calls and name
+        static void report( std::ostream& out );
+
+        // Print folded stacks ( "a;b;c exclusive_ns" ) for flamegraph
+        static void writeFolded( std::ostream& out );
+
+        // Hooks of SentryLogger
+        static ProfileNode* enter( const char* name );
+        static void leave( ProfileNode* node, uint64_t startTicks );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
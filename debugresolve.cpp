@@ -14,6 +14,7 @@
 #include "debugresolve.h"
 #include "debuglog.h"
 #include "tostr.h"
+#include <atomic>
 #include <string>
 #include <cstdlib>
 #include <cstring>      //strlen
@@ -151,7 +152,7 @@ std::string squeezePath( const std::string& path )
 class Addr2LineResolver
 {
    public:
-        Addr2LineResolver()
+        Addr2LineResolver() : cacheSize_( 0 )
         {
            child_pid_ = 0;
            // cleanup other session
@@ -183,11 +184,15 @@ class Addr2LineResolver
 
         CacheEntry request( void* addr );
 
+        // Could be called from any thread ( container itself is changed without lock )
+        size_t getCacheSize() const { return cacheSize_.load( std::memory_order_relaxed ); }
+
         static bool isStopWord( const std::string& funcname )
             { return ::tsv::debug::settings::isStopWord( funcname ); }
 
    private:
         std::unordered_map< void*, CacheEntry > addrCache_;
+        std::atomic<size_t> cacheSize_;
         char  buf_[512];
         pid_t child_pid_;       // 0=do not exists yet, <0=failed
         int   pipefd_[2];       // [0]=to say child, [1]=listen child
@@ -248,6 +253,7 @@ Addr2LineResolver::CacheEntry Addr2LineResolver::request( void* addr )
     CacheEntry entry { funcName, path };
 
     addrCache_[ addr ] = entry;
+    cacheSize_.store( addrCache_.size(), std::memory_order_relaxed );
     return entry;
 }
 
@@ -348,6 +354,10 @@ static Addr2LineResolver a2l_resolver;
        so collision are unlike but possible
 ***************************************************************************/
 
+// cachedStackTrace[ calltrace_hash ] = { short_notation_str, callstack_id_int }
+static std::unordered_map< uint64_t, std::pair< std::string, int > > cachedStackTrace;
+static std::atomic<size_t> cachedStackTraceSize( 0 );     // size of cachedStackTrace for other threads
+
 // AUX: Simple quick hash
 uint64_t FNV1aHash ( const unsigned char *buf, uint64_t len )
 {
@@ -429,6 +439,7 @@ std::vector<std::string> getBackTrace( int depth /*=-1*/, int skip /*=0*/, bool
         return return_value;
 #if !BACKTRACE_AVAILABLE
     return_value.push_back( "Backtrace feature is not available" );
+    return return_value;
 #else
 
     // Prepare values
@@ -446,9 +457,7 @@ std::vector<std::string> getBackTrace( int depth /*=-1*/, int skip /*=0*/, bool
     // Remember printed backtraces and later use its id only
     if ( ::tsv::debug::settings::btShortList || ::tsv::debug::settings::btShortListOnly )
     {
-        // cachedStackTrace[ calltrace_hash ] = { short_notation_str, callstack_id_int }
-        static std::unordered_map< uint64_t, std::pair< std::string, int > > cachedStackTrace;
-
+        auto& cachedStackTrace = symbol_resolve::cachedStackTrace;
         uint64_t key = symbol_resolve::makeKey( array, size );
         auto it = cachedStackTrace.find( key );
         if ( it != cachedStackTrace.end() )
@@ -478,6 +487,7 @@ std::vector<std::string> getBackTrace( int depth /*=-1*/, int skip /*=0*/, bool
             std::string shortName( symbol_resolve::collapseNames( tracedNames ) );
             int stackTraceId = cachedStackTrace.size()+1;
             cachedStackTrace[ key ] = std::make_pair( shortName, stackTraceId );
+            symbol_resolve::cachedStackTraceSize.store( cachedStackTrace.size(), std::memory_order_relaxed );
 
             return_value.push_back( ::tsv::util::tostr::strfmt( " .. StackTrace#%d : %s", stackTraceId, shortName.c_str() ) );
         }
@@ -505,6 +515,24 @@ std::vector<std::string> getBackTrace( int depth /*=-1*/, int skip /*=0*/, bool
 #endif
 }
 
+size_t getAddrCacheSize()
+{
+#if ADDR2LINE_AVAILABLE
+    return symbol_resolve::a2l_resolver.getCacheSize();
+#else
+    return 0;
+#endif
+}
+
+size_t getStackTraceCacheSize()
+{
+#if BACKTRACE_AVAILABLE
+    return symbol_resolve::cachedStackTraceSize.load( std::memory_order_relaxed );
+#else
+    return 0;
+#endif
+}
+
 
 }   // namespace debug
 }   // namespace tsv
@@ -30,6 +30,10 @@ namespace debug {
     // Get backtrace
     std::vector<std::string> getBackTrace( int depth = -1, int skip = 0, bool enforce = false );
 
+    // Sizes of internal caches: resolved addresses and remembered stacktraces
+    size_t getAddrCacheSize();
+    size_t getStackTraceCacheSize();
+
     // List of system-wide area of visibility settings
     // ( rest of settings are in debug.c )
     namespace settings
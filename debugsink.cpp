@@ -0,0 +1,315 @@
+/*********************************************************************
+  Purpose: Registry of output sinks with per-sink filters
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "debuglog.h"
+#include "debugasync.h"
+#include "debugcompress.h"
+#include "debugfilesink.h"
+#include "debugflight.h"
+#include "debugjsonsink.h"
+#include "debugsink.h"
+
+namespace tsv {
+namespace debug {
+
+using namespace SentryLoggerFlags;
+
+bool SinkFilter::pass( const LogRecord& rec ) const
+{
+    return ( rec.level_ & levelMask_ )
+           && ( !threadId_ || threadId_ == rec.threadId_ )
+           && ( context_.empty() || CallSite::matchPattern( context_.c_str(), rec.context_ ) );
+}
+
+namespace {
+
+//=================================================================
+//  Built-in sinks
+//=================================================================
+
+// handler_s and LOG_STDOUT copy ( could be done in background thread )
+struct HandlerSink : LogSink
+{
+    bool isActive( int level ) const override
+    {
+        return LoggerHandler::handler_s || ( level & LOG_STDOUT );
+    }
+    void write( const LogRecord& rec ) override
+    {
+        // async mode could be stopped right now - then output it by ourselves
+        if ( AsyncLogger::isActive() && AsyncLogger::push( rec.level_, rec.line_, rec.len_ ) )
+            return;
+        LoggerHandler::output( rec.level_, rec.line_, rec.len_ );
+    }
+};
+
+// File gets line as is or as part of compressed block
+struct FileSinkAdapter : LogSink
+{
+    bool isActive( int ) const override
+    {
+        return FileSink::isActive() || LogCompressor::isActive();
+    }
+    void write( const LogRecord& rec ) override
+    {
+        if ( LogCompressor::isActive() )
+            LogCompressor::write( rec.line_, rec.len_ );
+        else
+            FileSink::write( rec.line_, rec.len_ );
+    }
+};
+
+struct FlightSinkAdapter : LogSink
+{
+    bool isActive( int ) const override { return FlightRecorder::isActive(); }
+    void write( const LogRecord& rec ) override
+    {
+        FlightRecorder::record( rec.level_, rec.line_, rec.len_ );
+    }
+};
+
+struct JsonSinkAdapter : LogSink
+{
+    bool isActive( int ) const override { return JsonSink::isActive(); }
+    void write( const LogRecord& rec ) override
+    {
+        JsonSink::write( rec );
+    }
+};
+
+struct SinkEntry
+{
+    int        id_;
+    LogSink*   sink_;
+    SinkFilter filter_;
+};
+
+typedef std::vector<SinkEntry> SinkList;
+
+}   // anonymous namespace
+
+/***************************************************************************
+    Reader mark of one thread
+
+  seq_ is odd while thread walks over list of sinks. It is changed by owner
+  only, so marking costs no contended cache line. Slot is never freed ( writer
+  could read slot of thread which exits ), but it is reused by new threads.
+***************************************************************************/
+struct SinkReaderSlot
+{
+    std::atomic<uint64_t> seq_;
+    int                   depth_;       // nested scopes of owner
+    bool                  free_;        // guarded by Registry::slotsMutex_
+    char                  pad_[64];     // do not share cache line with slot of other thread
+
+    SinkReaderSlot() : seq_( 0 ), depth_( 0 ), free_( false ) {}
+};
+
+namespace {
+
+/***************************************************************************
+    Registry
+
+  Writers read current list without lock, but are marked in their slots.
+  Change makes new list, publishes it and waits until each thread which was
+  inside of walk ( odd seq_ ) leaves it, so sink which was removed is not called
+  anymore, then frees old list. Constant logging could not starve the wait:
+  any change of seq_ means that the old walk is over.
+***************************************************************************/
+struct Registry
+{
+    std::mutex                mutex_;
+    std::atomic<SinkList*>    current_;
+    int                       nextId_;
+
+    std::mutex                slotsMutex_;
+    std::vector< std::unique_ptr<SinkReaderSlot> > slots_;
+
+    HandlerSink               handlerSink_;
+    FileSinkAdapter           fileSink_;
+    FlightSinkAdapter         flightSink_;
+    JsonSinkAdapter           jsonSink_;
+
+    Registry() : current_( nullptr ), nextId_( LogSinks::SINK_JSON + 1 )
+    {
+        current_.store( new SinkList{ { LogSinks::SINK_HANDLER, &handlerSink_, SinkFilter() },
+                                      { LogSinks::SINK_FILE,    &fileSink_,    SinkFilter() },
+                                      { LogSinks::SINK_FLIGHT,  &flightSink_,  SinkFilter() },
+                                      { LogSinks::SINK_JSON,    &jsonSink_,    SinkFilter() } } );
+    }
+
+    // Publish changed copy of list, wait for readers of old one and free it. mutex_ have to be locked
+    void publish( SinkList* list )
+    {
+        SinkList* old = current_.exchange( list );
+        std::vector<SinkReaderSlot*> slots;
+        {
+            std::lock_guard<std::mutex> lock( slotsMutex_ );
+            for ( auto& slot : slots_ )
+                slots.push_back( slot.get() );
+        }
+        for ( SinkReaderSlot* slot : slots )
+        {
+            uint64_t seq = slot->seq_.load();
+            if ( seq & 1 )
+                while ( slot->seq_.load() == seq )
+                    std::this_thread::yield();
+        }
+        delete old;
+    }
+
+    SinkReaderSlot* acquireSlot()
+    {
+        std::lock_guard<std::mutex> lock( slotsMutex_ );
+        for ( auto& slot : slots_ )
+        {
+            if ( slot->free_ )
+            {
+                slot->free_ = false;
+                return slot.get();
+            }
+        }
+        slots_.emplace_back( new SinkReaderSlot() );
+        return slots_.back().get();
+    }
+
+    void releaseSlot( SinkReaderSlot* slot )
+    {
+        std::lock_guard<std::mutex> lock( slotsMutex_ );
+        slot->free_ = true;
+    }
+};
+
+// Created on first use ( logging could start from static constructors )
+// and never destroyed ( or end at static destructors )
+Registry& registry()
+{
+    static Registry* registry = new Registry();
+    return *registry;
+}
+
+// Owner of slot of thread. Return it to registry on thread exit
+struct SlotHolder
+{
+    SinkReaderSlot* slot_;
+    SlotHolder() : slot_( nullptr ) {}
+    ~SlotHolder()
+    {
+        if ( slot_ )
+            registry().releaseSlot( slot_ );
+        slot_ = nullptr;
+    }
+};
+
+SinkReaderSlot& readerSlot()
+{
+    static thread_local SlotHolder holder;
+    if ( !holder.slot_ )
+        holder.slot_ = registry().acquireSlot();
+    return *holder.slot_;
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Mark current thread as reader of list of sinks
+**********************************************************************************/
+LogSinks::ReadScope::ReadScope() : slot_( readerSlot() )
+{
+    // seq_cst store: either this thread sees new list, or publish() sees it inside
+    if ( !slot_.depth_++ )
+        slot_.seq_.store( slot_.seq_.load( std::memory_order_relaxed ) + 1 );
+}
+
+LogSinks::ReadScope::~ReadScope()
+{
+    if ( !--slot_.depth_ )
+        slot_.seq_.store( slot_.seq_.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+}
+
+/**********************************************************************************
+   PURPOSE:   Register sink
+**********************************************************************************/
+int LogSinks::add( LogSink* sink, const SinkFilter& filter /*=SinkFilter()*/ )
+{
+    if ( !sink )
+        return 0;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    SinkList* list = new SinkList( *reg.current_.load() );
+    list->push_back( SinkEntry{ reg.nextId_, sink, filter } );
+    reg.publish( list );
+    return reg.nextId_++;
+}
+
+bool LogSinks::remove( int id )
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    SinkList* list = new SinkList( *reg.current_.load() );
+    for ( auto it = list->begin(); it != list->end(); ++it )
+    {
+        if ( it->id_ == id )
+        {
+            list->erase( it );
+            reg.publish( list );
+            return true;
+        }
+    }
+    delete list;
+    return false;
+}
+
+bool LogSinks::setFilter( int id, const SinkFilter& filter )
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock( reg.mutex_ );
+    SinkList* list = new SinkList( *reg.current_.load() );
+    for ( SinkEntry& entry : *list )
+    {
+        if ( entry.id_ == id )
+        {
+            entry.filter_ = filter;
+            reg.publish( list );
+            return true;
+        }
+    }
+    delete list;
+    return false;
+}
+
+/**********************************************************************************
+   PURPOSE:   True if any sink could take event of "level"
+**********************************************************************************/
+bool LogSinks::isWanted( int level )
+{
+    ReadScope scope;
+    for ( const SinkEntry& entry : *registry().current_.load() )
+        if ( ( level & entry.filter_.levelMask_ ) && entry.sink_->isActive( level ) )
+            return true;
+    return false;
+}
+
+/**********************************************************************************
+   PURPOSE:   Pass record to each sink which filter passes it
+**********************************************************************************/
+void LogSinks::dispatch( const LogRecord& rec )
+{
+    ReadScope scope;
+    for ( const SinkEntry& entry : *registry().current_.load() )
+        if ( entry.filter_.pass( rec ) && entry.sink_->isActive( rec.level_ ) )
+            entry.sink_->write( rec );
+}
+
+}   // namespace debug
+}   // namespace tsv
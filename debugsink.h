@@ -0,0 +1,135 @@
+#ifndef DEBUGSINK_H_
+#define DEBUGSINK_H_ 1
+
+/*********************************************************************
+  Purpose: Registry of output sinks with per-sink filters
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tsv {
+namespace debug {
+
+struct LogField;
+class CallSite;
+struct SinkReaderSlot;
+
+/******************************************************************************
+  Output sinks
+
+  Event is formatted once, then the same record goes to each registered sink
+  which filter passes it.
+
+  Built-in sinks ( registered from start, all pass everything ):
+     SINK_HANDLER   LoggerHandler::handler_s ( and LOG_STDOUT copy, AsyncLogger )
+     SINK_FILE      FileSink ( or LogCompressor in front of it )
+     SINK_FLIGHT    FlightRecorder
+     SINK_JSON      JsonSink
+  Built-in sink does nothing while its module is not opened.
+
+  HOWTO USE:
+     // handler ( stdout by default ) gets only events, file gets everything
+     LogSinks::setFilter( LogSinks::SINK_HANDLER, SinkFilter( SentryLoggerFlags::LOG_EVENTS ) );
+     FileSink::open( "app.log" );
+
+     // own sink: only "net*" contexts of thread 2
+     struct MySink : LogSink { void write( const LogRecord& rec ) override { ... } } mySink;
+     int id = LogSinks::add( &mySink, SinkFilter( SentryLoggerFlags::LOG_ALL, "net*", 2 ) );
+     ...
+     LogSinks::remove( id );
+
+  NOTES:
+    1. Sinks are called in the logging thread ( only SINK_HANDLER goes through AsyncLogger ).
+       Sink is called concurrently by several threads, so it has to be thread-safe.
+    2. List of sinks is read without lock ( and without shared counter: each thread marks
+       itself as reader in its own slot ). remove() and setFilter() wait until threads which
+       are inside of write() right now leave it, so sink could be destroyed right after remove().
+       Do not call add()/remove()/setFilter() from write() of sink ( it would wait for itself ).
+******************************************************************************/
+
+// One formatted event
+struct LogRecord
+{
+    int             level_;         // LOG_ENTER/LOG_LEAVE/LOG_EVENTS ( + LOG_STDOUT )
+    int             depth_;         // nesting level in thread
+    int             threadId_;      // SentryLogger::getThreadId()
+    const char*     context_;       // name of sentry ( "" if none )
+    const CallSite* callsite_;      // macro of innermost sentry ( nullptr if none or sentry is not from macro )
+    const char*     line_;          // whole line ( "[DBG]T1 01 {func} text" )
+    size_t          len_;
+    const char*     message_;       // text of event inside of line_ ( after prefix )
+    const LogField* fields_;        // typed values of SAY_ARGS ( nullptr for others )
+    size_t          fieldCount_;
+    uint64_t        traceId_;       // ids of sentry of event ( 0 if there is no sentry )
+    uint64_t        spanId_;
+    uint64_t        parentSpanId_;
+};
+
+// Which records go to sink
+struct SinkFilter
+{
+    int         levelMask_;         // set of LOG_ENTER|LOG_LEAVE|LOG_EVENTS
+    std::string context_;           // glob of context name ( "" = any, see CallSite::matchPattern )
+    int         threadId_;          // only this thread ( 0 = any )
+
+    SinkFilter( int levelMask = 7 /* LOG_ALL */, const std::string& context = "", int threadId = 0 )
+        : levelMask_( levelMask ), context_( context ), threadId_( threadId ) {}
+
+    bool pass( const LogRecord& rec ) const;
+};
+
+class LogSink
+{
+    public:
+        virtual ~LogSink() {}
+
+        // False if sink has nowhere to write event of "level" now ( then line is not even formatted )
+        virtual bool isActive( int /*level*/ ) const { return true; }
+
+        virtual void write( const LogRecord& rec ) = 0;
+};
+
+class LogSinks
+{
+    public:
+        enum BuiltIn { SINK_HANDLER = 1, SINK_FILE, SINK_FLIGHT, SINK_JSON };
+
+        // Register sink ( not owned ). Return its id
+        static int add( LogSink* sink, const SinkFilter& filter = SinkFilter() );
+
+        // Return false if there is no such sink
+        static bool remove( int id );
+        static bool setFilter( int id, const SinkFilter& filter );
+
+        // True if any sink could take event of "level"
+        static bool isWanted( int level );
+
+        // Pass record to each sink which filter passes it
+        static void dispatch( const LogRecord& rec );
+
+        // Sinks seen by current thread are not freed until end of scope.
+        // isWanted() and dispatch() open it by themselves, but nested scope costs
+        // nothing, so one scope around both of them marks thread as reader once per event.
+        class ReadScope
+        {
+            public:
+                ReadScope();
+                ~ReadScope();
+
+            private:
+                ReadScope( const ReadScope& );
+                ReadScope& operator=( const ReadScope& );
+
+                SinkReaderSlot& slot_;
+        };
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*********************************************************************
+  Purpose: High-resolution monotonic timestamps
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <mutex>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+// Both are constant-initialized, so timing works even from static constructors
+std::atomic<int> Timing::source_s( Timing::SOURCE_UNKNOWN );
+double Timing::nsPerTick_s = 1.0;
+
+namespace {
+
+// Check that CPU has invariant TSC ( CPUID.80000007H:EDX[8] )
+bool isInvariantTsc()
+{
+#if DEBUGTIMING_TSC_AVAILABLE
+    unsigned eax, ebx, ecx, edx;
+    if ( !__get_cpuid( 0x80000000, &eax, &ebx, &ecx, &edx ) || eax < 0x80000007 )
+        return false;
+    if ( !__get_cpuid( 0x80000007, &eax, &ebx, &ecx, &edx ) )
+        return false;
+    return ( edx & ( 1 << 8 ) ) != 0;
+#else
+    return false;
+#endif
+}
+
+// Measure TSC rate against CLOCK_MONOTONIC. Return 0 if failed
+double calibrateTsc()
+{
+#if DEBUGTIMING_TSC_AVAILABLE
+    const uint64_t CALIBRATION_NS = 10000000;       // 10ms
+    uint64_t ns0 = Timing::monotonicNs();
+    uint64_t tsc0 = Timing::readTsc();
+    uint64_t ns1, tsc1;
+    do
+    {
+        ns1 = Timing::monotonicNs();
+        tsc1 = Timing::readTsc();
+    } while ( ns1 - ns0 < CALIBRATION_NS );
+
+    if ( tsc1 <= tsc0 )
+        return 0.0;
+    return static_cast<double>( ns1 - ns0 ) / static_cast<double>( tsc1 - tsc0 );
+#else
+    return 0.0;
+#endif
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Choose source of ticks
+**********************************************************************************/
+Timing::Source Timing::init()
+{
+    static std::mutex initMutex;
+    std::lock_guard<std::mutex> lock( initMutex );
+
+    int source = source_s.load();
+    if ( source != SOURCE_UNKNOWN )
+        return static_cast<Source>( source );
+
+    source = SOURCE_MONOTONIC;
+    if ( isInvariantTsc() )
+    {
+        double nsPerTick = calibrateTsc();
+        if ( nsPerTick > 0.0 )
+        {
+            nsPerTick_s = nsPerTick;
+            source = SOURCE_TSC;
+        }
+    }
+    source_s.store( source );
+    return static_cast<Source>( source );
+}
+
+Timing::Source Timing::getSource()
+{
+    int source = source_s.load();
+    return ( source == SOURCE_UNKNOWN ) ? init() : static_cast<Source>( source );
+}
+
+double Timing::getTicksPerSecond()
+{
+    if ( getSource() != SOURCE_TSC )
+        return 1e9;
+    return 1e9 / nsPerTick_s;
+}
+
+}   // namespace debug
+}   // namespace tsv
@@ -0,0 +1,104 @@
+#ifndef DEBUGTIMING_H_
+#define DEBUGTIMING_H_ 1
+
+/*********************************************************************
+  Purpose: High-resolution monotonic timestamps
+           ( calibrated TSC if it is invariant, CLOCK_MONOTONIC otherwise )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <cstdint>
+#include <atomic>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEBUGTIMING_TSC_AVAILABLE 1
+#else
+#define DEBUGTIMING_TSC_AVAILABLE 0
+#endif
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Timing engine
+
+  HOWTO USE:
+     uint64_t start = Timing::now();                     // raw ticks - cheap
+     ...
+     uint64_t ns = Timing::toNs( Timing::now() - start ); // duration in nanoseconds
+
+  NOTES:
+    1. TSC is used only if CPU reports invariant TSC (constant rate, not stopped
+       in sleep states). It is calibrated against CLOCK_MONOTONIC by init() (~10ms).
+       First now() waits for init(), so call Timing::init() at startup to pay it there.
+    2. Otherwise ticks are nanoseconds of CLOCK_MONOTONIC.
+    3. Ticks are comparable between threads, but make sense only inside of process.
+******************************************************************************/
+
+class Timing
+{
+    public:
+        enum Source { SOURCE_UNKNOWN = 0, SOURCE_TSC, SOURCE_MONOTONIC };
+
+        // Current timestamp in ticks
+        static inline uint64_t now()
+        {
+#if DEBUGTIMING_TSC_AVAILABLE
+            int source = source_s.load( std::memory_order_relaxed );
+            if ( source == SOURCE_TSC )
+                return readTsc();
+            if ( source == SOURCE_UNKNOWN && init() == SOURCE_TSC )
+                return readTsc();
+#endif
+            return monotonicNs();
+        }
+
+        // Convert duration in ticks to nanoseconds
+        static inline uint64_t toNs( uint64_t ticks )
+        {
+            if ( source_s.load( std::memory_order_acquire ) != SOURCE_TSC )
+                return ticks;
+            return static_cast<uint64_t>( ticks * nsPerTick_s );
+        }
+
+        // Current monotonic time in nanoseconds
+        static inline uint64_t nowNs() { return toNs( now() ); }
+
+        // What source of ticks is used
+        static Source getSource();
+
+        // How many ticks are in one second
+        static double getTicksPerSecond();
+
+        // Choose source of ticks and calibrate TSC. Called automatically on first now()
+        static Source init();
+
+        static inline uint64_t monotonicNs()
+        {
+            struct timespec ts;
+            clock_gettime( CLOCK_MONOTONIC, &ts );
+            return static_cast<uint64_t>( ts.tv_sec ) * 1000000000ULL + ts.tv_nsec;
+        }
+
+        // Raw TSC value ( compiler builtin, so <x86intrin.h> is not needed )
+        static inline uint64_t readTsc()
+        {
+#if DEBUGTIMING_TSC_AVAILABLE
+            return __builtin_ia32_rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+    protected:
+        static std::atomic<int> source_s;   // Source
+        static double nsPerTick_s;          // valid only for SOURCE_TSC
+};
+
+}
+}
+
+#endif
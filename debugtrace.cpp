@@ -0,0 +1,243 @@
+/*********************************************************************
+  Purpose: Export of sentries as Chrome Trace Event JSON
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <mutex>
+#include <vector>
+#include <algorithm>        // find
+#include <cstdio>
+#include <cstring>          // strlen
+#include <unistd.h>         // getpid
+
+#include "debugtrace.h"
+#include "debuglog.h"
+#include "debugtiming.h"
+
+namespace tsv {
+namespace debug {
+
+std::atomic<bool> ChromeTrace::active_s( false );
+
+namespace {
+
+const size_t BUFFER_FLUSH_SIZE = 64 * 1024;     // flush thread buffer if it is bigger
+
+// Per-thread buffer of JSON events
+struct TraceBuffer
+{
+    std::mutex  mutex_;             // owner and close() only, so it is never contended for long
+    int         threadId_;
+    uint32_t    gen_;               // generation of file which buffer belongs to
+    std::string data_;
+};
+
+/***************************************************************************
+    Global state of trace
+
+ Lock order: registryMutex_ -> TraceBuffer::mutex_ -> fileMutex_
+***************************************************************************/
+struct TraceState
+{
+    std::atomic<uint32_t> gen_;     // generation of currently opened file
+    uint64_t     epoch_;            // time of open() ( Timing::now() ticks )
+    int          pid_;
+
+    std::mutex   fileMutex_;
+    FILE*        file_;
+
+    std::mutex   registryMutex_;
+    std::vector<TraceBuffer*> buffers_;
+
+    TraceState() : gen_( 0 ), epoch_( 0 ), pid_( 0 ), file_( nullptr ) {}
+    ~TraceState() { ChromeTrace::close(); }
+};
+
+TraceState state_s;
+
+// Write content of buffer to file. Buffer lock have to be taken
+void flushBuffer( TraceBuffer* tb )
+{
+    if ( tb->data_.empty() )
+        return;
+    {
+        std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+        if ( state_s.file_ && tb->gen_ == state_s.gen_.load() )
+            fwrite( tb->data_.data(), 1, tb->data_.size(), state_s.file_ );
+    }
+    tb->data_.clear();
+}
+
+// Owner of per-thread buffer. Flush and unregister it on thread exit
+struct TraceBufferHolder
+{
+    TraceBuffer* tb_;
+    TraceBufferHolder() : tb_( nullptr ) {}
+    ~TraceBufferHolder()
+    {
+        if ( !tb_ )
+            return;
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        {
+            std::lock_guard<std::mutex> bufLock( tb_->mutex_ );
+            flushBuffer( tb_ );
+        }
+        state_s.buffers_.erase( std::find( state_s.buffers_.begin(), state_s.buffers_.end(), tb_ ) );
+        delete tb_;
+    }
+};
+
+TraceBuffer* traceBuffer()
+{
+    static thread_local TraceBufferHolder holder;
+    if ( !holder.tb_ )
+    {
+        holder.tb_ = new TraceBuffer();
+        holder.tb_->threadId_ = SentryLogger::getThreadId();
+        holder.tb_->gen_ = 0;
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        state_s.buffers_.push_back( holder.tb_ );
+    }
+    return holder.tb_;
+}
+
+// Append JSON string literal
+void appendJsonString( std::string& out, const char* str, size_t len )
+{
+    out += '"';
+    for ( size_t i = 0; i < len; i++ )
+    {
+        unsigned char c = static_cast<unsigned char>( str[i] );
+        if ( c == '"' || c == '\\' )
+        {
+            out += '\\';
+            out += c;
+        }
+        else if ( c == '\n' )
+            out += "\\n";
+        else if ( c == '\t' )
+            out += "\\t";
+        else if ( c < 0x20 )
+        {
+            char buf[8];
+            snprintf( buf, sizeof(buf), "\\u%04x", c );
+            out += buf;
+        }
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+// Append one event ( "ph" = phase ) to buffer of current thread
+void addEvent( char phase, const char* name, size_t nameLen, const char* message )
+{
+    TraceBuffer* tb = traceBuffer();
+    uint64_t ns = Timing::toNs( Timing::now() - state_s.epoch_ );
+
+    std::lock_guard<std::mutex> lock( tb->mutex_ );
+    uint32_t gen = state_s.gen_.load( std::memory_order_relaxed );
+    std::string& out = tb->data_;
+    if ( tb->gen_ != gen )
+    {
+        // buffer has data of previous file (if any) - drop it and name the thread
+        tb->gen_ = gen;
+        out.clear();
+        char buf[128];
+        snprintf( buf, sizeof(buf), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"T%d\"}},\n",
+                  state_s.pid_, tb->threadId_, tb->threadId_ );
+        out += buf;
+    }
+
+    out += "{\"name\":";
+    appendJsonString( out, name, nameLen );
+    char buf[128];
+    snprintf( buf, sizeof(buf), ",\"cat\":\"sentry\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d",
+              phase, static_cast<unsigned long long>( ns / 1000 ), static_cast<unsigned>( ns % 1000 ),
+              state_s.pid_, tb->threadId_ );
+    out += buf;
+    if ( message )
+    {
+        out += ",\"s\":\"t\",\"args\":{\"msg\":";
+        appendJsonString( out, message, strlen( message ) );
+        out += '}';
+    }
+    out += "},\n";
+
+    if ( out.size() >= BUFFER_FLUSH_SIZE )
+        flushBuffer( tb );
+}
+
+}   // anonymous namespace
+
+/**********************************************************************************
+   PURPOSE:   Open trace file
+**********************************************************************************/
+bool ChromeTrace::open( const char* path )
+{
+    close();
+
+    FILE* file = fopen( path, "w" );
+    if ( !file )
+        return false;
+    fputs( "[\n", file );
+
+    std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+    state_s.file_ = file;
+    state_s.pid_ = getpid();
+    state_s.epoch_ = Timing::now();
+    state_s.gen_.fetch_add( 1 );
+    active_s.store( true );
+    return true;
+}
+
+/**********************************************************************************
+   PURPOSE:   Flush buffers of all threads and finish JSON array
+**********************************************************************************/
+void ChromeTrace::close()
+{
+    if ( !active_s.exchange( false ) )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( state_s.registryMutex_ );
+        for ( auto tb : state_s.buffers_ )
+        {
+            std::lock_guard<std::mutex> bufLock( tb->mutex_ );
+            flushBuffer( tb );
+        }
+    }
+
+    std::lock_guard<std::mutex> lock( state_s.fileMutex_ );
+    if ( state_s.file_ )
+    {
+        // Last event has no trailing comma
+        fprintf( state_s.file_, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"debug_logger\"}}\n]\n", state_s.pid_ );
+        fclose( state_s.file_ );
+    }
+    state_s.file_ = nullptr;
+}
+
+void ChromeTrace::begin( const char* name )
+{
+    addEvent( 'B', name, strlen( name ), nullptr );
+}
+
+void ChromeTrace::end( const char* name )
+{
+    addEvent( 'E', name, strlen( name ), nullptr );
+}
+
+void ChromeTrace::instant( const char* name, const char* message )
+{
+    // event outside of any sentry has no context name
+    if ( !name[0] )
+        addEvent( 'i', "event", 5, message );
+    else
+        addEvent( 'i', name, strlen( name ), message );
+}
+
+}   // namespace debug
+}   // namespace tsv
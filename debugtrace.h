@@ -0,0 +1,60 @@
+#ifndef DEBUGTRACE_H_
+#define DEBUGTRACE_H_ 1
+
+/*********************************************************************
+  Purpose: Export of sentries as Chrome Trace Event JSON
+           ( timeline view in chrome://tracing or ui.perfetto.dev )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <atomic>
+#include <string>
+
+namespace tsv {
+namespace debug {
+
+/******************************************************************************
+  Trace export
+
+  HOWTO USE:
+     ChromeTrace::open( "/tmp/app.trace.json" );
+     ... SENTRY_*, SAY_* as usual ...
+     ChromeTrace::close();           // flush buffers of all threads and finish JSON
+
+     Then load file into chrome://tracing or ui.perfetto.dev
+
+  NOTES:
+    1. Each named sentry gives "B"/"E" duration events ( even if its text output is off ),
+       SAY_DBG and other events inside of scope give "i" instant event with text in args.msg
+    2. tid is the same thread id as "T<id>" of text output. Timestamps are in microseconds
+       since open() with nanoseconds as fraction.
+    3. Events are collected into per-thread buffers and written to file by big chunks.
+       Text output is not affected.
+******************************************************************************/
+
+class ChromeTrace
+{
+    public:
+        // Start writing trace into file "path". Return false if failed
+        static bool open( const char* path );
+
+        // Flush buffers of all threads and finish file
+        static void close();
+
+        static bool isActive() { return active_s.load( std::memory_order_relaxed ); }
+
+        // Hooks of SentryLogger
+        static void begin( const char* name );
+        static void end( const char* name );
+        static void instant( const char* name, const char* message );
+
+    protected:
+        static std::atomic<bool> active_s;
+};
+
+}
+}
+
+#endif
@@ -11,9 +11,9 @@
 
 #include "objlog.h"
 #include "debuglog.h"
+#include <atomic>
 #include <unordered_map>
 #include <map>
-#include <cstdio>   //sprintf
 
 using namespace ::tsv::debug;
 
@@ -27,6 +27,13 @@ namespace
     // Auxiliary containers, which store info about object allocations
     std::map<std::string, UnordMapPtrInt_t > allObjectsMap;    // ["className"][object_ptr] = counter
     std::map<std::string, int> objectsCounter;                 // ["className"] = counter_s
+    std::atomic<size_t> trackedCount( 0 );                     // pointers in allObjectsMap ( read by other threads )
+
+    void registerPtr( const std::string& className, const void* ptr )
+    {
+        if ( ++allObjectsMap[className][ptr] == 1 )
+            trackedCount.fetch_add( 1, std::memory_order_relaxed );
+    }
 }
 //bool ObjLogger::useNested_s = true;
 
@@ -46,6 +53,15 @@ namespace
             handler =  SentryLogger::vwrite;
         return handler;
     }
+
+    // Pointer as "0x..." to print by %s ( %x truncates 64-bit pointer )
+    struct AddrStr
+    {
+        char buf_[::tsv::util::tostr::ADDR_BUF_SIZE];
+
+        explicit AddrStr( const void* ptr ) { ::tsv::util::tostr::formatAddr( buf_, ptr ); }
+        const char* c_str() const { return buf_; }
+    };
 }
 
 ObjLogger::ObjLogger( void* ptr, const char* className, int depth, const char* comment /*=""*/)
@@ -53,9 +69,9 @@ ObjLogger::ObjLogger( void* ptr, const char* className, int depth, const char* c
 {
     if ( ptr != nullptr )
     {
-        allObjectsMap[className_][ptr]++;
+        registerPtr( className_, ptr );
         objectsCounter[className_]++;
-        (*getFunc())( "[obj:%s:%d] create %x %s", className, objectsCounter[className], ptr, comment?comment:"");
+        (*getFunc())( "[obj:%s:%d] create %s %s", className, objectsCounter[className], AddrStr( ptr ).c_str(), comment?comment:"");
         if ( depth_ )
             SentryLogger::printBackTrace( depth_, 1 );
     }
@@ -66,9 +82,9 @@ ObjLogger::ObjLogger( void* ptr, void* copied_from, const char* className, int d
 {
     if ( ptr != nullptr )
     {
-        allObjectsMap[className_][ptr]++;
+        registerPtr( className_, ptr );
         objectsCounter[className_]++;
-        (*getFunc())( "[obj:%s:%d] %x copy_ctor(%x) %s", className, objectsCounter[className_], ptr, copied_from, comment?comment:"");
+        (*getFunc())( "[obj:%s:%d] %s copy_ctor(%s) %s", className, objectsCounter[className_], AddrStr( ptr ).c_str(), AddrStr( copied_from ).c_str(), comment?comment:"");
         if ( depth_ )
             SentryLogger::printBackTrace( depth_, 1 );
     }
@@ -82,9 +98,9 @@ ObjLogger::ObjLogger( const ObjLogger& obj ) :
         const void* ptr = reinterpret_cast<const char*>(this) - offs_;
         const void* copied_from = reinterpret_cast<const char*>(&obj) - offs_;
 
-        allObjectsMap[className_][ptr]++;
+        registerPtr( className_, ptr );
         objectsCounter[className_]++;
-        (*getFunc())( "[obj:%s:%d] %x copy_ctor_dflt(%x)", className_.c_str(), objectsCounter[className_], ptr, copied_from );
+        (*getFunc())( "[obj:%s:%d] %s copy_ctor_dflt(%s)", className_.c_str(), objectsCounter[className_], AddrStr( ptr ).c_str(), AddrStr( copied_from ).c_str() );
         if ( depth_ )
             SentryLogger::printBackTrace( depth_, 1 );
     }
@@ -98,11 +114,11 @@ ObjLogger::ObjLogger( const ObjLogger&& obj ) :
         const void* ptr = reinterpret_cast<const char*>(this) - offs_;
         const void* copied_from = reinterpret_cast<const char*>(&obj) - offs_;
 
-        allObjectsMap[className_][ptr]++;
+        registerPtr( className_, ptr );
         objectsCounter[className_]++;
         auto pprint = getFunc();
-        (*pprint)( "[obj:%s:%d] %x copy_ctor_move(%x)", className_.c_str(), objectsCounter[className_], ptr, copied_from );
-        (*pprint)( "[obj:%s:%d] %x become unitialized", className_.c_str(), objectsCounter[className_], copied_from );
+        (*pprint)( "[obj:%s:%d] %s copy_ctor_move(%s)", className_.c_str(), objectsCounter[className_], AddrStr( ptr ).c_str(), AddrStr( copied_from ).c_str() );
+        (*pprint)( "[obj:%s:%d] %s become unitialized", className_.c_str(), objectsCounter[className_], AddrStr( copied_from ).c_str() );
         if ( depth_ )
             SentryLogger::printBackTrace( depth_, 1 );
     }
@@ -122,7 +138,7 @@ ObjLogger& ObjLogger::operator=( const ObjLogger& obj )
     }
     else
     {
-      (*getFunc())( "[obj:%s:%d] %x operator=(%x)", className_.data(), objectsCounter[className_], ptr, copied_from );
+      (*getFunc())( "[obj:%s:%d] %s operator=(%s)", className_.data(), objectsCounter[className_], AddrStr( ptr ).c_str(), AddrStr( copied_from ).c_str() );
       // depth could be different
       depth_ = obj.depth_;
     }
@@ -147,15 +163,18 @@ ObjLogger::~ObjLogger()
         int& classCntr = objectsCounter[className_];
 
         if ( objCntr == obj.end() )
-            (*getFunc())( "[obj:%s:%d] destroy %x. ERROR: not registered pointer", className_.c_str(), classCntr, objPtr );
+            (*getFunc())( "[obj:%s:%d] destroy %s. ERROR: not registered pointer", className_.c_str(), classCntr, AddrStr( objPtr ).c_str() );
         else
         {
             classCntr--;
-            (*getFunc())( "[obj:%s:%d] destroy %x", className_.c_str(), classCntr, objPtr );
+            (*getFunc())( "[obj:%s:%d] destroy %s", className_.c_str(), classCntr, AddrStr( objPtr ).c_str() );
             if ( objCntr->second > 1 )
                 objCntr->second--;
             else
+            {
                 obj.erase( objCntr );
+                trackedCount.fetch_sub( 1, std::memory_order_relaxed );
+            }
         }
 
         if ( depth_ )
@@ -163,9 +182,16 @@ ObjLogger::~ObjLogger()
     }
 }
 
+// Count of tracked pointers ( safe to call from any thread )
+size_t ObjLogger::getTrackedCount()
+{
+    return trackedCount.load( std::memory_order_relaxed );
+}
+
 // Print all or exact class pointers
 //      className    = if nullptr print all tracked pointers
 //                     otherwise only tracked pointers of given class
+
 void ObjLogger::printTrackedPtr( const char* className /*= nullptr */ )
 {
     if ( !className )
@@ -188,14 +214,18 @@ void ObjLogger::printTrackedPtr( const char* className /*= nullptr */ )
     auto& ptrMap = it->second;
     for ( const auto& ptr : ptrMap )
     {
-        static char buf[40];
+        char buf[::tsv::util::tostr::ADDR_BUF_SIZE];
         if ( !ptr.second )
           continue;
-        if ( ptr.second==1 )
-            sprintf( buf, "%s%p", cntr?",":"", ptr.first );
-        else
-            sprintf( buf, "%s%p(%d)", cntr?",":"", ptr.first, ptr.second );
-        output += buf;
+        if ( cntr )
+            output += ',';
+        output.append( buf, ::tsv::util::tostr::formatAddr( buf, ptr.first ) );
+        if ( ptr.second != 1 )
+        {
+            output += '(';
+            output.append( buf, ::tsv::util::tostr::formatDecimal( buf, ptr.second ) );
+            output += ')';
+        }
         cntr++;
     }
 
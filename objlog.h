@@ -48,6 +48,9 @@ class ObjLogger
 
         static void printTrackedPtr( const char* className = nullptr );
 
+        // How many objects are tracked now ( entries of tracking map )
+        static size_t getTrackedCount();
+
     public:
         // Settings
         //static bool useNested_s;  // true if you would like to align with SentryLogger output
@@ -69,6 +72,7 @@ class ObjLogEmptyClass
         ObjLogEmptyClass ( void* ptr, const char* className, int depth=0, const char* comment="" ) {}
         ObjLogEmptyClass ( void* ptr, void* copied_from, const char* className, int depth, const char* comment ) {}
         static void printTrackedPtr( const char* className = nullptr ) {}
+        static size_t getTrackedCount() { return 0; }
     private:
 };
 
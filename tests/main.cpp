@@ -1,9 +1,36 @@
 #include <iostream>
+#include <atomic>
+#include <cstdlib>      // malloc
+#include <cstring>      // strlen
+#include <string>
+#include <new>
 
 /************** TEST **********/
 
 using namespace std;
 
+// Count heap allocations ( to check that hot paths do not allocate )
+static std::atomic<size_t> allocationCount( 0 );
+
+size_t getAllocationCount()
+{
+    return allocationCount.load();
+}
+
+void* operator new( std::size_t size )
+{
+    allocationCount++;
+    void* ptr = malloc( size ? size : 1 );
+    if ( !ptr )
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+    free( ptr );
+}
+
 bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true )
 {
     std::cout << prefix << val << "\n";
@@ -21,27 +48,109 @@ bool test( bool& isOkTotal, const char* prefix, std::string val, const char* com
     return isOk;
 }
 
+// How many times "what" is found in "text"
+int countOf( const std::string& text, const std::string& what )
+{
+    int count = 0;
+    for ( size_t pos = text.find( what ); pos != std::string::npos; pos = text.find( what, pos + 1 ) )
+        count++;
+    return count;
+}
+
+// Every line of text starts with "linePrefix" and is complete, and there is no zero tail
+bool isWellFormed( const std::string& text, const char* linePrefix )
+{
+    if ( text.empty() || text.back() != '\n' || text.find( '\0' ) != std::string::npos )
+        return false;
+    size_t len = strlen( linePrefix );
+    for ( size_t pos = 0; pos < text.size(); pos = text.find( '\n', pos ) + 1 )
+        if ( text.compare( pos, len, linePrefix ) )
+            return false;
+    return true;
+}
+
 // Declaration from another test_*.cpp
 bool test_tostr();
 bool test_sentry();
 bool test_objlog();
 bool test_watcher();
+bool test_async();
+bool test_binlog();
+bool test_timing();
+bool test_profile();
+bool test_trace();
+bool test_callsite();
+bool test_flight();
+bool test_filesink();
+bool test_batchsink();
+bool test_compress();
+bool test_jsonsink();
+bool test_sink();
+bool test_metrics();
+bool test_span();
+bool test_float();
 
 /**************** MAIN() ***************/
 int main()
 {
+    bool isOk = true;
     std::cout<< "\n *** TOSTR module ***\n";
-    test_tostr();
+    isOk = test_tostr() && isOk;
 
     std::cout<< "\n *** DEBUGLOG module ***\n";
-    test_sentry();
+    isOk = test_sentry() && isOk;
 
     std::cout<< "\n *** OBJLOG module ***\n";
-    test_objlog();
+    isOk = test_objlog() && isOk;
 
     std::cout<< "\n *** DEBUGWATCH module ***\n";
-    test_watcher();
+    isOk = test_watcher() && isOk;
+
+    std::cout<< "\n *** DEBUGASYNC module ***\n";
+    isOk = test_async() && isOk;
+
+    std::cout<< "\n *** DEBUGBINLOG module ***\n";
+    isOk = test_binlog() && isOk;
+
+    std::cout<< "\n *** DEBUGTIMING module ***\n";
+    isOk = test_timing() && isOk;
+
+    std::cout<< "\n *** DEBUGPROFILE module ***\n";
+    isOk = test_profile() && isOk;
+
+    std::cout<< "\n *** DEBUGTRACE module ***\n";
+    isOk = test_trace() && isOk;
+
+    std::cout<< "\n *** DEBUGCALLSITE module ***\n";
+    isOk = test_callsite() && isOk;
+
+    std::cout<< "\n *** DEBUGFLIGHT module ***\n";
+    isOk = test_flight() && isOk;
+
+    std::cout<< "\n *** DEBUGFILESINK module ***\n";
+    isOk = test_filesink() && isOk;
+
+    std::cout<< "\n *** DEBUGBATCHSINK module ***\n";
+    isOk = test_batchsink() && isOk;
+
+    std::cout<< "\n *** DEBUGCOMPRESS module ***\n";
+    isOk = test_compress() && isOk;
+
+    std::cout<< "\n *** DEBUGJSONSINK module ***\n";
+    isOk = test_jsonsink() && isOk;
+
+    std::cout<< "\n *** DEBUGSINK module ***\n";
+    isOk = test_sink() && isOk;
+
+    std::cout<< "\n *** DEBUGMETRICS module ***\n";
+    isOk = test_metrics() && isOk;
+
+    std::cout<< "\n *** SPAN CONTEXT ***\n";
+    isOk = test_span() && isOk;
+    std::cout<< "\n *** FLOAT FORMAT ***\n";
+    isOk = test_float() && isOk;
 
-    return 0;
+    std::cout << ( isOk ? "\nALL TESTS PASSED\n" : "\nSOME TESTS FAILED\n" );
+    return isOk ? 0 : 1;
 }
 
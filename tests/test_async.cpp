@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../debuglog.h"
+#include "../debugasync.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+namespace {
+
+  // Called from background thread only, so no lock needed
+  std::vector<std::string> lines;
+  std::thread::id consumerId;
+  void testLoggerHandlerAsync( const char* fmt, void* args )
+  {
+      lines.push_back( ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) ) );
+      consumerId = std::this_thread::get_id();
+  }
+}
+
+void async_producer( int id, int count )
+{
+    SENTRY_FUNC( "producer %d", id );
+    for ( int i = 0; i < count; i++ )
+        SAY_DBG( "p%d:%d", id, i );
+}
+
+// Run 4 producers and return how many lines were handled
+static size_t async_run( int count )
+{
+    lines.clear();
+    std::vector<std::thread> threads;
+    for ( int id = 0; id < 4; id++ )
+        threads.emplace_back( async_producer, id, count );
+    for ( auto& th : threads )
+        th.join();
+    AsyncLogger::stop();
+    return lines.size();
+}
+
+bool test_async()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerAsync;
+
+    // POLICY_BLOCK: nothing lost, order of each thread is kept
+    AsyncLogger::start( 16, AsyncLogger::POLICY_BLOCK );
+    test( isOkTotal, "Block: all lines handled = ", std::to_string( async_run( 1000 ) ), "4008" );
+
+    bool ordered = true;
+    std::vector<int> lastIdx( 4, -1 );
+    for ( auto& line : lines )
+    {
+        int id, idx;
+        size_t found = line.find( "} p" );
+        if ( found == std::string::npos || sscanf( line.c_str() + found + 3, "%d:%d", &id, &idx ) != 2 )
+            continue;
+        ordered = ordered && ( idx == lastIdx[id] + 1 );
+        lastIdx[id] = idx;
+    }
+    test( isOkTotal, "Block: per-thread order kept = ", std::to_string( ordered ), "1" );
+    test( isOkTotal, "Handler called in background = ", std::to_string( consumerId != std::this_thread::get_id() ), "1" );
+
+    // POLICY_DROP_NEWEST/OLDEST: handled + dropped = produced
+    uint64_t dropped = AsyncLogger::getDroppedNewest();
+    AsyncLogger::start( 16, AsyncLogger::POLICY_DROP_NEWEST );
+    size_t handled = async_run( 1000 );
+    dropped = AsyncLogger::getDroppedNewest() - dropped;
+    test( isOkTotal, "Drop newest: handled+dropped = ", std::to_string( handled + dropped ), "4008" );
+
+    dropped = AsyncLogger::getDroppedOldest();
+    AsyncLogger::start( 16, AsyncLogger::POLICY_DROP_OLDEST );
+    handled = async_run( 1000 );
+    dropped = AsyncLogger::getDroppedOldest() - dropped;
+    test( isOkTotal, "Drop oldest: handled+dropped = ", std::to_string( handled + dropped ), "4008" );
+
+    // After stop() output is synchronous again
+    lines.clear();
+    SAY_DBG( "sync again" );
+    test( isOkTotal, "Sync after stop = ", std::to_string( lines.size() ), "1" );
+
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>         // pipe
+#include "../debuglog.h"
+#include "../debugbatchsink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+int countOf( const std::string& text, const std::string& what );
+bool isWellFormed( const std::string& text, const char* linePrefix );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+// Read everything which is in pipe now
+static std::string readPipe( int fd )
+{
+    std::string text;
+    char buf[4096];
+    for ( ssize_t n; ( n = read( fd, buf, sizeof(buf) ) ) > 0; )
+        text.append( buf, n );
+    return text;
+}
+
+void batch_func( int count )
+{
+    BatchSink::FlushGuard guard;
+    SENTRY_FUNC( "count=%d", count );
+    for ( int i = 0; i < count; i++ )
+        SAY_DBG( "event %d of batch", i );
+}
+
+bool test_batchsink()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = nullptr;         // only LOG_STDOUT copy goes to sink
+    SentryLogger::setLogStdoutSystemFlag( true );
+
+    int fds[2];
+    if ( pipe( fds ) != 0 )
+        return false;
+    fcntl( fds[0], F_SETFL, O_NONBLOCK );
+
+    // Thresholds are not reached: lines wait for flush
+    test( isOkTotal, "Open sink: ", std::to_string( BatchSink::open( fds[1], 1 << 20, 100000 ) ), "1" );
+    SAY_DBG( "batched line" );
+    test( isOkTotal, "Line waits in batch: ", readPipe( fds[0] ), "" );
+    {
+        BatchSink::FlushGuard guard;
+        SAY_DBG( "guarded line" );
+    }
+    std::string text = readPipe( fds[0] );
+    test( isOkTotal, "Flushed at scope exit: ", std::to_string( countOf( text, "batched line\n" ) + countOf( text, "guarded line\n" ) ), "2" );
+
+    // Lines of threads are not mixed
+    std::thread th1( batch_func, 100 ), th2( batch_func, 100 );
+    th1.join();
+    th2.join();
+    text = readPipe( fds[0] );
+    // LOG_STDOUT copy has no "[DBG]", so lines start with "T<thread>"
+    test( isOkTotal, "Threads output whole lines: ", std::to_string( isWellFormed( text, "T" ) ), "1" );
+    test( isOkTotal, "Lines of threads: ", std::to_string( countOf( text, " of batch\n" ) ), "200" );
+
+    // Flush by size
+    BatchSink::open( fds[1], 128, 100000 );
+    for ( int i = 0; i < 10; i++ )
+        SAY_DBG( "event %d of batch", i );
+    text = readPipe( fds[0] );
+    test( isOkTotal, "Flushed by size: ", std::to_string( isWellFormed( text, "T" ) && countOf( text, " of batch\n" ) < 10 ), "1" );
+    BatchSink::close();
+    test( isOkTotal, "Flushed by close: ", std::to_string( countOf( text + readPipe( fds[0] ), " of batch\n" ) ), "10" );
+
+    // Flush by time
+    BatchSink::open( fds[1], 1 << 20, 10 );
+    SAY_DBG( "old line" );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+    test( isOkTotal, "Flushed by time: ", std::to_string( countOf( readPipe( fds[0] ), "old line\n" ) ), "1" );
+    BatchSink::close();
+
+    SAY_DBG( "after close" );                   // to stdout as usual
+    test( isOkTotal, "Nothing after close: ", readPipe( fds[0] ), "" );
+
+    ::close( fds[0] );
+    ::close( fds[1] );
+    SentryLogger::setLogStdoutSystemFlag( false );
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include "../debuglog.h"
+#include "../debugbinlog.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+namespace {
+
+  std::string last_value;
+  void testLoggerHandlerBinlog( const char* fmt, void* args )
+  {
+      last_value += ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) ) + "\n";
+  }
+}
+
+void binlog_func( int x, const char* str )
+{
+    SENTRY_FUNC( "x=%d str=%s", x, str );
+    SAY_DBG( "int %d|%5.2f|%-8s|%x|%lld|%c|%*d|%.3s|%%|%s", -x, x / 3.0, str, 255u, -1234567890123LL, 'Z', 6, x, "abcdef", static_cast<const char*>( nullptr ) );
+    {
+        SENTRY_CONTEXT( "inner" );
+        SAY_ARGS( x, str );
+    }
+}
+
+// Replace "trace:span" ids with "#" ( they are random )
+static std::string maskIds( const std::string& text )
+{
+    std::string out;
+    for ( size_t pos = 0; pos < text.size(); )
+    {
+        bool isId = pos + 33 <= text.size() && text[pos + 16] == ':'
+                    && text.find_first_not_of( "0123456789abcdef:", pos ) >= pos + 33;
+        if ( isId )
+        {
+            out += '#';
+            pos += 33;
+        }
+        else
+            out += text[pos++];
+    }
+    return out;
+}
+
+// Formats which are not literals: the same buffer holds different text
+void binlog_buffer_func( int x )
+{
+    SENTRY_FUNC();
+    char format[32];
+    snprintf( format, sizeof(format), "first %%d" );
+    SentryLogger::vwrite( format, x );
+    snprintf( format, sizeof(format), "second %%*.*f|%%s" );
+    SentryLogger::vwrite( format, 8, 2, x / 4.0, "tail" );
+}
+
+bool test_binlog()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerBinlog;
+
+    // The same sequence in text mode ..
+    last_value.clear();
+    binlog_func( 42, "str" );
+    std::string textOutput = last_value;
+
+    // .. and in binary mode
+    const char* path = "test_binlog.dbglog";
+    last_value.clear();
+    BinaryLog::open( path );
+    binlog_func( 42, "str" );
+    BinaryLog::close();
+    test( isOkTotal, "No text output in binary mode: ", std::to_string( last_value.size() ), "0" );
+
+    std::ostringstream decoded;
+    test( isOkTotal, "Decode: ", std::to_string( BinaryLog::decode( path, decoded ) ), "1" );
+    std::cout << decoded.str();
+    test( isOkTotal, "Decoded equal to text mode: ", std::to_string( decoded.str() == textOutput ), "1" );
+    remove( path );
+
+    // Ids of sentries are kept: the same as text prefix in span id mode ..
+    SentryLogger::setSpanIdMode( true );
+    last_value.clear();
+    binlog_func( 42, "str" );
+    textOutput = last_value;
+    BinaryLog::open( path );
+    binlog_func( 42, "str" );
+    BinaryLog::close();
+    decoded.str( "" );
+    BinaryLog::decode( path, decoded );
+    SentryLogger::setSpanIdMode( false );
+    test( isOkTotal, "Decoded ids equal to text mode: ", std::to_string( maskIds( decoded.str() ) == maskIds( textOutput ) ), "1" );
+
+    // .. and with parent: "inner" context is a child of span of binlog_func
+    decoded.str( "" );
+    BinaryLog::decode( path, decoded, false, true );
+    std::string withIds = decoded.str();
+    std::cout << withIds;
+    size_t funcPos = withIds.find( "{binlog_func}" );
+    size_t innerPos = withIds.find( "{inner}" );
+    bool isChild = funcPos != std::string::npos && innerPos != std::string::npos
+                   && withIds.compare( innerPos - 21, 16, withIds, funcPos - 37, 16 ) == 0;
+    test( isOkTotal, "Parent id of nested context: ", std::to_string( isChild ), "1" );
+    remove( path );
+
+    // Format is taken by its content, not by address
+    last_value.clear();
+    binlog_buffer_func( 7 );
+    textOutput = last_value;
+    BinaryLog::open( path );
+    binlog_buffer_func( 7 );
+    BinaryLog::close();
+    decoded.str( "" );
+    BinaryLog::decode( path, decoded );
+    std::cout << decoded.str();
+    test( isOkTotal, "Format in reused buffer: ", std::to_string( decoded.str() == textOutput ), "1" );
+    remove( path );
+
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../debuglog.h"
+#include "../debugcallsite.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+size_t getAllocationCount();
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+namespace {
+
+  int lines_count = 0;
+  void testLoggerHandlerCount( const char* fmt, void* args )
+  {
+      lines_count++;
+  }
+
+  const CallSite* handler_callsite = nullptr;
+  void testLoggerHandlerCallSite( const char* fmt, void* args )
+  {
+      handler_callsite = SentryLogger::getCurrentCallSite();
+  }
+
+  int evaluated_count = 0;
+  int evaluated()
+  {
+      return ++evaluated_count;
+  }
+}
+
+void callsite_func()
+{
+    SENTRY_FUNC( "arg=%d", evaluated() );
+    SAY_DBG( "event %d", evaluated() );
+}
+
+void callsite_other()
+{
+    SENTRY_SILENT();
+    SAY_DBG( "event" );
+}
+
+int callsite_location()
+{
+    SENTRY_CONTEXT( "location" );
+    SAY_DBG( "where am I" );
+    return __LINE__ - 2;
+}
+
+void sampled_every( int i )
+{
+    SENTRY_FUNC_SAMPLED( everyN( 3 ), "i=%d", evaluated() + i );
+}
+
+void sampled_first( int i )
+{
+    SAY_DBG_SAMPLED( firstN( 2 ), "i=%d", evaluated() + i );
+}
+
+void sampled_rate()
+{
+    SAY_DBG_SAMPLED( perSecond( 5 ), "event" );
+}
+
+// Sentry which logs enter/leave only: its events are filtered by flags
+void lazy_filtered()
+{
+    SENTRY_ALT_FUNC( LOG_ENTER | LOG_LEAVE )();
+    int value = 1;
+    SAY_ARGS( value, evaluated() );
+    SAY_EXPR( value, "+", evaluated() );
+    SAY_DBG( "%d", evaluated() );
+}
+
+void lazy_w_args()
+{
+    SENTRY_FUNC_W_ARGS( evaluated() );
+}
+
+bool test_callsite()
+{
+    isOkTotal = true;
+
+    test( isOkTotal, "Glob match: ", std::to_string( CallSite::matchPattern( "call*_f?nc", "callsite_func" ) ), "1" );
+    test( isOkTotal, "Glob mismatch: ", std::to_string( CallSite::matchPattern( "call*_f?nc", "callsite_other" ) ), "0" );
+
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerCount;
+
+    callsite_func();
+    callsite_other();
+    test( isOkTotal, "Enabled callsites: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "4/2" );
+
+    // Disabled callsite prints nothing, does not evaluate arguments and does not allocate
+    CallSite::enableByName( "callsite_*", false );
+    CallSite::enableByName( "callsite_other", true );
+    lines_count = evaluated_count = 0;
+    size_t allocations = getAllocationCount();
+    callsite_func();
+    test( isOkTotal, "Disabled by name: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "0/0" );
+    test( isOkTotal, "Disabled callsite allocates: ", std::to_string( getAllocationCount() - allocations ), "0" );
+    callsite_other();
+    test( isOkTotal, "Enabled by later rule: ", std::to_string( lines_count ), "1" );
+
+    CallSite::resetRules();
+    CallSite::enableByFile( "*test_callsite.cpp", false );
+    lines_count = 0;
+    callsite_func();
+    callsite_other();
+    test( isOkTotal, "Disabled by file: ", std::to_string( lines_count ), "0" );
+
+    CallSite::resetRules();
+    callsite_func();
+    test( isOkTotal, "Enabled after reset: ", std::to_string( lines_count ), "3" );
+
+    // Sentry keeps pointer to static descriptor of its source location
+    LoggerHandler::handler_s = testLoggerHandlerCallSite;
+    int line = callsite_location();
+    LoggerHandler::handler_s = prevHandler;
+    test( isOkTotal, "Descriptor is available to handler: ", std::to_string( handler_callsite != nullptr ), "1" );
+    if ( handler_callsite )
+    {
+        test( isOkTotal, "Descriptor function: ", handler_callsite->getFunc(), "callsite_location" );
+        test( isOkTotal, "Descriptor line: ", std::to_string( handler_callsite->getLine() ), std::to_string( line ).c_str() );
+        CallSite same( "callsite_location", handler_callsite->getFile(), line );
+        test( isOkTotal, "Descriptor id is hash of location: ", std::to_string( handler_callsite->getId() == same.getId() ), "1" );
+    }
+
+    // Sampling: skipped calls are not logged and arguments are not evaluated
+    LoggerHandler::handler_s = testLoggerHandlerCount;
+    lines_count = evaluated_count = 0;
+    for ( int i = 0; i < 10; i++ )
+        sampled_every( i );
+    test( isOkTotal, "Every 3rd of 10 sentries: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "8/4" );
+
+    lines_count = evaluated_count = 0;
+    for ( int i = 0; i < 10; i++ )
+        sampled_first( i );
+    test( isOkTotal, "First 2 of 10 events: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "2/2" );
+
+    lines_count = 0;
+    for ( int i = 0; i < 1000; i++ )
+        sampled_rate();
+    test( isOkTotal, "Burst of token bucket (5/s): ", std::to_string( lines_count ), "5" );
+
+    // Runtime rule overrides policy of macro
+    CallSite::sampleByName( "sampled_first", SamplePolicy::all() );
+    lines_count = 0;
+    for ( int i = 0; i < 10; i++ )
+        sampled_first( i );
+    test( isOkTotal, "Sampling removed by rule: ", std::to_string( lines_count ), "10" );
+    CallSite::sampleByName( "sampled_*", SamplePolicy::everyN( 5 ) );
+    lines_count = 0;
+    for ( int i = 0; i < 10; i++ )
+        sampled_first( i );
+    test( isOkTotal, "Sampling set by rule: ", std::to_string( lines_count ), "2" );
+    CallSite::resetRules();
+
+    // Arguments of filtered events are not evaluated
+    lines_count = evaluated_count = 0;
+    lazy_filtered();
+    test( isOkTotal, "Filtered by flags: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "2/0" );
+    LoggerHandler::handler_s = nullptr;
+    lazy_filtered();
+    lazy_w_args();
+    test( isOkTotal, "No output wants event: ", std::to_string( evaluated_count ), "0" );
+    LoggerHandler::handler_s = testLoggerHandlerCount;
+    lazy_w_args();
+    test( isOkTotal, "Enter with args: ", std::to_string( lines_count ) + "/" + std::to_string( evaluated_count ), "4/1" );
+    LoggerHandler::handler_s = prevHandler;
+
+    // Suppressed counts are reported per callsite
+    std::ostringstream report;
+    CallSite::reportSuppressed( report );
+    std::cout << report.str();
+    test( isOkTotal, "Report of sampled_every: ", std::to_string( report.str().find( " sampled_every suppressed=6\n" ) != std::string::npos ), "1" );
+    test( isOkTotal, "Report of sampled_first: ", std::to_string( report.str().find( " sampled_first suppressed=16\n" ) != std::string::npos ), "1" );
+    test( isOkTotal, "Report of sampled_rate: ", std::to_string( report.str().find( " sampled_rate suppressed=995\n" ) != std::string::npos ), "1" );
+
+    return isOkTotal;
+}
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdio>           // remove
+#include "../debuglog.h"
+#include "../debugcompress.h"
+#include "../debugfilesink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+int countOf( const std::string& text, const std::string& what );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+static std::string unpackString( const std::string& packed, bool* isComplete = nullptr )
+{
+    std::istringstream in( packed );
+    std::ostringstream out;
+    bool rv = LogCompressor::decompress( in, out );
+    if ( isComplete )
+        *isComplete = rv;
+    return out.str();
+}
+
+static std::string unpackFile( const std::string& path )
+{
+    std::ifstream in( path, std::ios::binary );
+    if ( !in )
+        return "<none>";
+    std::ostringstream out;
+    if ( !LogCompressor::decompress( in, out ) )
+        return "<corrupted>";
+    return out.str();
+}
+
+static bool isFile( const std::string& path )
+{
+    return std::ifstream( path ).good();
+}
+
+void compress_func( int count )
+{
+    SENTRY_FUNC( "count=%d", count );
+    for ( int i = 0; i < count; i++ )
+        SAY_DBG( "event %d", i );
+}
+
+bool test_compress()
+{
+    isOkTotal = true;
+
+    // Codec
+    std::string text;
+    for ( int i = 0; i < 1000; i++ )
+        text += "[DBG]T1 01 {compress_func} event " + std::to_string( i ) + "\n";
+    std::string packed;
+    LogCompressor::compressBlock( text.data(), text.size(), packed, LogCompressor::CODEC_LZ );
+    test( isOkTotal, "LZ round trip: ", std::to_string( unpackString( packed ) == text ), "1" );
+    test( isOkTotal, "LZ ratio > 3: ", std::to_string( packed.size() * 3 < text.size() ), "1" );
+
+    std::string noise;
+    for ( unsigned i = 0, x = 1; i < 1000; i++, x = x * 1103515245 + 12345 )
+        noise += static_cast<char>( x >> 16 );
+    std::string packedNoise;
+    LogCompressor::compressBlock( noise.data(), noise.size(), packedNoise, LogCompressor::CODEC_LZ );
+    test( isOkTotal, "Incompressible round trip: ", std::to_string( unpackString( packedNoise ) == noise ), "1" );
+    test( isOkTotal, "Incompressible is stored: ", std::to_string( packedNoise.size() - noise.size() ), "20" );
+
+    // Truncated stream is decoded up to the last complete block
+    std::string twoBlocks;
+    LogCompressor::compressBlock( "first\n", 6, twoBlocks );
+    LogCompressor::compressBlock( text.data(), text.size(), twoBlocks );
+    bool isComplete = true;
+    test( isOkTotal, "Truncated stream: ", unpackString( twoBlocks.substr( 0, twoBlocks.size() - 10 ), &isComplete ), "first\n" );
+    test( isOkTotal, "Truncation is reported: ", std::to_string( isComplete ), "0" );
+    twoBlocks[30] ^= 1;
+    test( isOkTotal, "Corrupted block: ", unpackString( twoBlocks, &isComplete ), "first\n" );
+
+    // Streaming compression into file sink
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = nullptr;
+    std::string path = "/tmp/test_compress.log";
+    FileSink::open( path.c_str(), 1 << 20, 1 );
+    test( isOkTotal, "Open compressor: ", std::to_string( LogCompressor::open( LogCompressor::CODEC_LZ, 4096, 10 ) ), "1" );
+    std::thread th( compress_func, 300 );
+    compress_func( 300 );
+    th.join();
+    LogCompressor::close();
+    FileSink::close();
+    text = unpackFile( path );
+    test( isOkTotal, "Streamed lines: ", std::to_string( countOf( text, "} event " ) ), "600" );
+    test( isOkTotal, "Lines are complete: ", std::to_string( countOf( text, "\n" ) ), "604" );
+    remove( path.c_str() );
+
+    // Background compression of rotated files
+    FileSink::open( path.c_str(), 4096, 2, FileSink::SYNC_NONE, 10, true );
+    compress_func( 500 );
+    FileSink::close();
+    text = unpackFile( path + ".1.dz" );
+    test( isOkTotal, "Rotated file is compressed: ", std::to_string( isFile( path + ".1" ) ), "0" );
+    test( isOkTotal, "Rotated lines: ", std::to_string( countOf( text, "} event " ) > 50 && text.back() == '\n' ), "1" );
+    test( isOkTotal, "Only 2 rotated files are kept: ", std::to_string( isFile( path + ".3.dz" ) ), "0" );
+    test( isOkTotal, "Current file is plain: ", std::to_string( countOf( unpackFile( path ), "<corrupted>" ) ), "1" );
+    remove( path.c_str() );
+    remove( ( path + ".1.dz" ).c_str() );
+    remove( ( path + ".2.dz" ).c_str() );
+
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>           // remove
+#include <sys/stat.h>       // mkdir
+#include <unistd.h>         // rmdir
+#include "../debuglog.h"
+#include "../debugfilesink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+bool isWellFormed( const std::string& text, const char* linePrefix );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+void filesink_func( int count )
+{
+    SENTRY_FUNC( "count=%d", count );
+    for ( int i = 0; i < count; i++ )
+        SAY_DBG( "event %d", i );
+}
+
+static std::string readFile( const std::string& path )
+{
+    std::ifstream file( path );
+    if ( !file )
+        return "<none>";
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+bool test_filesink()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = nullptr;
+
+    // 4KB files, keep 2 rotated ones
+    std::string path = "/tmp/test_filesink.log";
+    test( isOkTotal, "Open sink: ", std::to_string( FileSink::open( path.c_str(), 4096, 2, FileSink::SYNC_ASYNC, 10 ) ), "1" );
+    std::thread th( filesink_func, 200 );
+    filesink_func( 200 );
+    th.join();
+    SAY_DBG( "last line" );
+    FileSink::close();
+    SAY_DBG( "after close" );
+
+    std::string current = readFile( path );
+    std::string rotated1 = readFile( path + ".1" );
+    std::string rotated2 = readFile( path + ".2" );
+    test( isOkTotal, "Current file is well formed: ", std::to_string( isWellFormed( current, "[DBG]" ) ), "1" );
+    test( isOkTotal, "Rotated files are well formed: ", std::to_string( isWellFormed( rotated1, "[DBG]" ) && isWellFormed( rotated2, "[DBG]" ) ), "1" );
+    test( isOkTotal, "Rotated files are full: ", std::to_string( rotated1.size() > 4000 && rotated1.size() <= 4096 ), "1" );
+    test( isOkTotal, "Only 2 rotated files are kept: ", readFile( path + ".3" ), "<none>" );
+    test( isOkTotal, "Last line is in current file: ", std::to_string( current.find( "last line\n" ) != std::string::npos ), "1" );
+    test( isOkTotal, "Nothing after close: ", std::to_string( current.find( "after close" ) ), std::to_string( std::string::npos ).c_str() );
+
+    remove( path.c_str() );
+    remove( ( path + ".1" ).c_str() );
+    remove( ( path + ".2" ).c_str() );
+
+    // Directory is gone, so no new file could be created: sink stops and counts lost lines
+    std::string dir = "/tmp/test_filesink_dir";
+    mkdir( dir.c_str(), 0755 );
+    test( isOkTotal, "Open sink in dir: ", std::to_string( FileSink::open( ( dir + "/log" ).c_str(), 4096, 2, FileSink::SYNC_NONE, 10 ) ), "1" );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );     // next file is prepared
+    remove( ( dir + "/log" ).c_str() );
+    remove( ( dir + "/log.next" ).c_str() );
+    test( isOkTotal, "Remove dir: ", std::to_string( rmdir( dir.c_str() ) ), "0" );
+    uint64_t droppedBefore = FileSink::getDropped();
+    filesink_func( 400 );
+    test( isOkTotal, "Sink is stopped on error: ", std::to_string( FileSink::isActive() ), "0" );
+    test( isOkTotal, "Lost lines are counted: ", std::to_string( FileSink::getDropped() > droppedBefore ), "1" );
+    FileSink::close();
+
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdio>           // remove
+#include <csignal>
+#include <unistd.h>         // fork
+#include <sys/wait.h>
+#include "../debuglog.h"
+#include "../debugflight.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+int countOf( const std::string& text, const std::string& what );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+void flight_func( int count )
+{
+    SENTRY_FUNC( "count=%d", count );
+    for ( int i = 0; i < count; i++ )
+        SAY_DBG( "event %d", i );
+}
+
+void flight_crash()
+{
+    SENTRY_FUNC();
+    SAY_DBG( "last words" );
+    kill( getpid(), SIGKILL );
+}
+
+static std::string decode( const char* path )
+{
+    std::ostringstream ss;
+    if ( !FlightRecorder::decode( path, ss ) )
+        return "not decoded";
+    return ss.str();
+}
+
+bool test_flight()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = nullptr;         // text output is quiet
+
+    // Ring keeps only last 8 events of each thread
+    const char* path = "/tmp/test_flight.flight";
+    test( isOkTotal, "Open recorder: ", std::to_string( FlightRecorder::open( path, 8, 4, 64 ) ), "1" );
+    flight_func( 20 );
+    std::thread th( flight_func, 3 );
+    th.join();
+    SAY_DBG( "long line which does not fit into slot of 64 bytes, so it is truncated" );
+    FlightRecorder::close();
+    flight_func( 1 );                           // not recorded
+
+    std::string text = decode( path );
+    std::cout << text;
+    test( isOkTotal, "Events of threads: ", std::to_string( countOf( text, "[DBG]T" ) ), "13" );
+    test( isOkTotal, "Oldest events are overwritten: ", std::to_string( countOf( text, "event 12\n" ) + countOf( text, "event 13\n" ) ), "0" );
+    test( isOkTotal, "Last events are kept: ", std::to_string( countOf( text, "event 14\n" ) + countOf( text, "event 19\n" ) ), "2" );
+    test( isOkTotal, "Events of second thread: ", std::to_string( countOf( text, "event 0\n" ) + countOf( text, "event 2\n" ) ), "2" );
+    test( isOkTotal, "Long line is truncated: ", std::to_string( countOf( text, "so it is truncated" ) ), "0" );
+    test( isOkTotal, "Not recorded after close: ", std::to_string( countOf( text, "count=1" ) ), "0" );
+    remove( path );
+
+    // Events survive SIGKILL
+    pid_t pid = fork();
+    if ( !pid )
+    {
+        FlightRecorder::open( path, 16, 2, 128 );
+        flight_crash();
+        _exit( 0 );
+    }
+    int status = 0;
+    waitpid( pid, &status, 0 );
+    test( isOkTotal, "Child is killed: ", std::to_string( WIFSIGNALED( status ) ), "1" );
+    text = decode( path );
+    std::cout << text;
+    test( isOkTotal, "Last event before SIGKILL: ", std::to_string( countOf( text, "{flight_crash} last words\n" ) ), "1" );
+    remove( path );
+
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
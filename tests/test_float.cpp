@@ -0,0 +1,141 @@
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>          // strtod, strtof
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include "../tostr.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::util::tostr;
+
+static bool isOkTotal;
+
+static std::string fmtDouble( double value )
+{
+    char buf[FLOAT_BUF_SIZE];
+    return std::string( buf, formatDouble( buf, value ) );
+}
+
+static std::string fmtFloat( float value )
+{
+    char buf[FLOAT_BUF_SIZE];
+    return std::string( buf, formatFloat( buf, value ) );
+}
+
+// Count of significant digits of shortest %.Ng which reads back ( reference of shortness )
+static int shortestDigits( double value )
+{
+    char buf[64];
+    for ( int prec = 1; prec < 17; prec++ )
+    {
+        snprintf( buf, sizeof(buf), "%.*g", prec, value );
+        if ( strtod( buf, nullptr ) == value )
+            return prec;
+    }
+    return 17;
+}
+
+static int countDigits( const std::string& s )
+{
+    // significant digits: from first non-zero digit up to exponent, without trailing zeros of integer
+    size_t end = s.find( 'e' );
+    std::string mantissa = s.substr( 0, end );
+    std::string digits;
+    for ( char c : mantissa )
+        if ( c >= '0' && c <= '9' )
+            digits += c;
+    size_t first = digits.find_first_not_of( '0' );
+    if ( first == std::string::npos )
+        return 1;
+    size_t last = digits.find_last_not_of( '0' );
+    return static_cast<int>( last - first + 1 );
+}
+
+bool test_float()
+{
+    isOkTotal = true;
+
+    // Corpus: special values, boundaries of notation and of formats, classic rounding cases
+    struct { double value_; const char* text_; } doubles[] =
+    {
+        { 0.0, "0" }, { -0.0, "-0" }, { 1.0, "1" }, { -1.0, "-1" }, { 2.5, "2.5" }, { 100.0, "100" },
+        { 0.1, "0.1" }, { 0.2, "0.2" }, { 0.1 + 0.2, "0.30000000000000004" }, { 1.0 / 3, "0.3333333333333333" },
+        { 2.0 / 3, "0.6666666666666666" }, { 123.456, "123.456" }, { -1.5e-3, "-0.0015" },
+        { 1e-4, "0.0001" }, { 1.5e-5, "1.5e-05" }, { 1e-7, "1e-07" }, { 1e16, "10000000000000000" },
+        { 1e17, "1e+17" }, { 1e21, "1e+21" }, { 1.2345e100, "1.2345e+100" },
+        { 9007199254740992.0, "9007199254740992" }, { 9007199254740994.0, "9007199254740994" },
+        { 4503599627370495.5, "4503599627370495.5" }, { 299792458.0, "299792458" },
+        { 5e-324, "5e-324" }, { 2.2250738585072014e-308, "2.2250738585072014e-308" },
+        { 2.225073858507201e-308, "2.225073858507201e-308" }, { 1.7976931348623157e308, "1.7976931348623157e+308" },
+        { 5e-310, "5e-310" }, { 9.5367431640625e-07, "9.5367431640625e-07" }, { 5.0e-324 * 3, "1.5e-323" },
+        // known cases where Grisu2 is one digit longer than shortest ( but reads back exactly )
+        { 1.0e23, "9.999999999999999e+22" }, { 8.41e21, "8.409999999999999e+21" },
+        { std::numeric_limits<double>::infinity(), "inf" }, { -std::numeric_limits<double>::infinity(), "-inf" },
+        { std::numeric_limits<double>::quiet_NaN(), "nan" },
+    };
+    std::string got, expected;
+    for ( const auto& item : doubles )
+    {
+        got += fmtDouble( item.value_ ) + " ";
+        expected += std::string( item.text_ ) + " ";
+    }
+    test( isOkTotal, "Double corpus: ", got, expected.c_str() );
+
+    struct { float value_; const char* text_; } floats[] =
+    {
+        { 0.0f, "0" }, { 0.1f, "0.1" }, { 1.0f / 3, "0.33333334" }, { 16777216.0f, "16777216" },
+        { 123456789.0f, "123456790" }, { 3.4028235e38f, "3.4028235e+38" }, { 1.17549435e-38f, "1.1754944e-38" },
+        { 1e-45f, "1e-45" }, { -2.5f, "-2.5" }, { 7.038531e-26f, "7.038531e-26" },
+    };
+    got.clear();
+    expected.clear();
+    for ( const auto& item : floats )
+    {
+        got += fmtFloat( item.value_ ) + " ";
+        expected += std::string( item.text_ ) + " ";
+    }
+    test( isOkTotal, "Float corpus: ", got, expected.c_str() );
+
+    // toStr() of any mode
+    double ratio = 1.5;
+    test( isOkTotal, "", TOSTR_ARGS( ratio ), "ratio = 1.5" );
+    test( isOkTotal, "", toStr( 0.25f, ENUM_TOSTR_EXTENDED ), "0.25" );
+    test( isOkTotal, "", toStr( 0.5L ), "0.5" );
+
+    // Random bit patterns: each one reads back, and is as short as shortest %.Ng
+    // ( Grisu2 could be one digit longer in rare cases )
+    std::mt19937_64 rnd( 12345 );
+    int badDouble = 0, longer = 0, badFloat = 0;
+    for ( int i = 0; i < 100000; i++ )
+    {
+        uint64_t bits = rnd();
+        double value;
+        memcpy( &value, &bits, sizeof(value) );
+        if ( value != value || value == std::numeric_limits<double>::infinity() || value == -std::numeric_limits<double>::infinity() )
+            continue;
+        std::string s = fmtDouble( value );
+        if ( strtod( s.c_str(), nullptr ) != value )
+            badDouble++;
+        else if ( i % 10 == 0 && countDigits( s ) > shortestDigits( value ) )
+            longer++;
+
+        uint32_t fbits = static_cast<uint32_t>( bits );
+        float fvalue;
+        memcpy( &fvalue, &fbits, sizeof(fvalue) );
+        if ( fvalue != fvalue || fvalue == std::numeric_limits<float>::infinity() || fvalue == -std::numeric_limits<float>::infinity() )
+            continue;
+        if ( strtof( fmtFloat( fvalue ).c_str(), nullptr ) != fvalue )
+            badFloat++;
+    }
+    test( isOkTotal, "Double round trip errors: ", std::to_string( badDouble ), "0" );
+    test( isOkTotal, "Float round trip errors: ", std::to_string( badFloat ), "0" );
+    test( isOkTotal, "Almost always shortest: ", std::to_string( longer < 100 ), "1" );
+    std::cout << "Longer than shortest: " << longer << " of 10000\n";
+
+    return isOkTotal;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>           // remove
+#include "../debuglog.h"
+#include "../debugjsonsink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+static std::string argsLine, expectedArgs;
+
+static void testLoggerHandlerJson( const char* fmt, void* args )
+{
+    std::string line = ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) );
+    if ( line.find( "count = " ) != std::string::npos )
+        argsLine = line;
+}
+
+// Part of "line" from "key" to the end of value ( without timestamp )
+static std::string jsonFrom( const std::string& line, const char* key )
+{
+    size_t pos = line.find( key );
+    return ( pos == std::string::npos ) ? "<none>" : line.substr( pos );
+}
+
+void json_func()
+{
+    SENTRY_FUNC();
+    int count = -5;
+    unsigned size = 7;
+    std::string name = "a\"b";
+    double ratio = 1.5;
+    bool flag = true;
+    const char* none = nullptr;
+    SAY_ARGS( count, "literal", name, ratio, flag, none, size + 1 );
+    expectedArgs = TOSTR_ARGS( count, "literal", name, ratio, flag, none, size + 1 );
+    SAY_DBG( "plain %d", 3 );
+}
+
+bool test_jsonsink()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerJson;
+
+    const char* path = "/tmp/test_jsonsink.jsonl";
+    test( isOkTotal, "Open sink: ", std::to_string( JsonSink::open( path ) ), "1" );
+    json_func();
+    JsonSink::close();
+    SAY_DBG( "after close" );
+
+    std::ifstream file( path );
+    std::string enter, args, plain, leave, extra;
+    std::getline( file, enter );
+    std::getline( file, args );
+    std::getline( file, plain );
+    std::getline( file, leave );
+    std::getline( file, extra );
+    test( isOkTotal, "Enter: ", jsonFrom( enter, "\"depth\"" ), "\"depth\":1,\"level\":\"enter\",\"context\":\"json_func\",\"msg\":\">> Enter scope\"}" );
+    test( isOkTotal, "Fields: ", jsonFrom( args, "\"fields\"" ),
+          "\"fields\":{\"count\":-5,\"name\":\"a\\\"b\",\"ratio\":1.5,\"flag\":true,\"none\":null,\"size + 1\":8}}" );
+    std::string msg = jsonFrom( args, "\"msg\"" );
+    test( isOkTotal, "Message of fields: ", msg.substr( 0, msg.find( ",\"fields\"" ) ),
+          "\"msg\":\"count = -5, literal name = \\\"a\\\"b\\\", ratio = 1.5, flag = 1, none = nullptr, size + 1 = 8\"" );
+    test( isOkTotal, "Text line is the same: ", jsonFrom( argsLine, "count" ), expectedArgs.c_str() );
+    test( isOkTotal, "Event without fields: ", jsonFrom( plain, "\"level\"" ), "\"level\":\"event\",\"context\":\"json_func\",\"msg\":\"plain 3\"}" );
+    test( isOkTotal, "Leave: ", jsonFrom( leave, "\"level\"" ).substr( 0, 16 ), "\"level\":\"leave\"," );
+    test( isOkTotal, "Nothing after close: ", extra, "" );
+    test( isOkTotal, "Span ids: ", std::to_string( enter.find( "\"trace\":\"" ) != std::string::npos && enter.find( "\"span\":\"" ) != std::string::npos ), "1" );
+    test( isOkTotal, "Timestamp: ", std::to_string( enter.compare( 0, 6, "{\"ts\":" ) == 0 && enter[16] == '.' ), "1" );
+
+    remove( path );
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "../debuglog.h"
+#include "../debugmetrics.h"
+#include "../objlog.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+static std::string summaryLine;
+static std::atomic<bool> hasSummary( false );
+
+static void testLoggerHandlerMetrics( const char* fmt, void* args )
+{
+    std::string line = ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) );
+    if ( line.find( "[metrics] " ) != std::string::npos && !hasSummary )
+    {
+        summaryLine = line;
+        hasSummary = true;
+    }
+}
+
+void metrics_func()
+{
+    SENTRY_FUNC();
+    SAY_DBG( "first" );
+    SAY_DBG( "second" );
+}
+
+void metrics_silent_func()
+{
+    SENTRY_ALT_FUNC( LOG_ENTER | LOG_LEAVE )();
+    SAY_DBG( "filtered by flags" );
+}
+
+void metrics_sampled_func()
+{
+    for ( int i = 0; i < 3; i++ )
+        SAY_DBG_SAMPLED( firstN( 1 ), "i=%d", i );
+}
+
+struct MetricsObject
+{
+    int       value_;
+    ObjLogger debug_sentry_;
+
+    MetricsObject() : value_( 0 ), debug_sentry_( this, "MetricsObject" ) {}
+};
+
+bool test_metrics()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerMetrics;
+
+    LoggerMetrics::start();
+    test( isOkTotal, "Active: ", std::to_string( LoggerMetrics::isActive() ), "1" );
+    metrics_func();
+    LoggerStats stats = LoggerMetrics::collect();
+    test( isOkTotal, "Emitted: ", std::to_string( stats.eventsEmitted_ ), "4" );
+    test( isOkTotal, "Bytes: ", std::to_string( stats.bytesFormatted_ > 4 * 10 ), "1" );
+    test( isOkTotal, "Sinks take part of logger time: ", std::to_string( stats.loggerNs_ >= stats.sinkNs_ ), "1" );
+
+    metrics_silent_func();
+    LoggerHandler::handler_s = nullptr;         // nobody wants event
+    SAY_DBG( "nowhere" );
+    LoggerHandler::handler_s = testLoggerHandlerMetrics;
+    stats = LoggerMetrics::collect();
+    test( isOkTotal, "Filtered: ", std::to_string( stats.eventsFiltered_ ), "2" );
+    test( isOkTotal, "Emitted with enter/leave: ", std::to_string( stats.eventsEmitted_ ), "6" );
+
+    metrics_sampled_func();
+    test( isOkTotal, "Dropped by sampling: ", std::to_string( LoggerMetrics::collect().eventsDropped_ ), "2" );
+
+    // Threads are summed ( finished thread is kept in totals, but not in count of threads )
+    size_t threads = LoggerMetrics::collect().threads_;
+    std::thread th( metrics_func );
+    th.join();
+    stats = LoggerMetrics::collect();
+    test( isOkTotal, "Emitted by all threads: ", std::to_string( stats.eventsEmitted_ ), "11" );
+    test( isOkTotal, "Finished thread is not counted: ", std::to_string( stats.threads_ ), std::to_string( threads ).c_str() );
+
+    size_t tracked = stats.trackedObjects_;
+    {
+        MetricsObject obj;
+        test( isOkTotal, "Tracked objects: ", std::to_string( LoggerMetrics::collect().trackedObjects_ - tracked ), "1" );
+    }
+
+    LoggerMetrics::reset();
+    stats = LoggerMetrics::collect();
+    test( isOkTotal, "Reset: ", std::to_string( stats.eventsEmitted_ + stats.eventsFiltered_ + stats.eventsDropped_ ), "0" );
+    std::ostringstream report;
+    LoggerMetrics::report( report );
+    test( isOkTotal, "Report: ", report.str().substr( report.str().find( "events emitted" ), 24 ), "events emitted:       0\n" );
+    std::thread th2( metrics_func );
+    th2.join();
+    test( isOkTotal, "Finished thread after reset: ", std::to_string( LoggerMetrics::collect().eventsEmitted_ ), "4" );
+    LoggerMetrics::reset();
+
+    // Periodic summary
+    LoggerMetrics::start( 10 );
+    for ( int i = 0; i < 200 && !hasSummary; i++ )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+    LoggerMetrics::stop();
+    test( isOkTotal, "Summary: ", summaryLine.substr( summaryLine.find( "[metrics]" ), 17 ), "[metrics] events=" );
+
+    uint64_t emitted = LoggerMetrics::collect().eventsEmitted_;
+    metrics_func();
+    test( isOkTotal, "Not counted after stop: ", std::to_string( LoggerMetrics::collect().eventsEmitted_ - emitted ), "0" );
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../debuglog.h"
+#include "../debugprofile.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+void prof_leaf()
+{
+    SENTRY_SILENT();
+    volatile int x = 0;
+    for ( int i = 0; i < 1000; i++ )
+        x += i;
+}
+
+void prof_middle( int count )
+{
+    SENTRY_FUNC( nullptr );         // output is off, but scope is profiled anyway
+    for ( int i = 0; i < count; i++ )
+        prof_leaf();
+}
+
+void prof_top()
+{
+    SENTRY_SILENT();
+    prof_middle( 10 );
+    prof_leaf();
+}
+
+// Find merged entry by path
+static const ProfileEntry* findEntry( const std::vector<ProfileEntry>& entries, const char* path )
+{
+    for ( auto& entry : entries )
+        if ( entry.path_ == path )
+            return &entry;
+    return nullptr;
+}
+
+bool test_profile()
+{
+    isOkTotal = true;
+
+    Profiler::reset();
+    Profiler::start();
+    std::thread th( prof_top );
+    prof_top();
+    th.join();
+    Profiler::stop();
+    prof_top();                     // not counted
+
+    Profiler::report( std::cout );
+    std::vector<ProfileEntry> entries = Profiler::collect();
+
+    const ProfileEntry* top = findEntry( entries, "prof_top" );
+    const ProfileEntry* leaf = findEntry( entries, "prof_top;prof_leaf" );
+    const ProfileEntry* deepLeaf = findEntry( entries, "prof_top;prof_middle;prof_leaf" );
+    test( isOkTotal, "Top is merged from 2 threads: ", std::to_string( top ? top->calls_ : 0 ), "2" );
+    test( isOkTotal, "Leaf under top: ", std::to_string( leaf ? leaf->calls_ : 0 ), "2" );
+    test( isOkTotal, "Leaf under middle: ", std::to_string( deepLeaf ? deepLeaf->calls_ : 0 ), "20" );
+    test( isOkTotal, "Scope with output off is counted: ", std::to_string( findEntry( entries, "prof_top;prof_middle" ) != nullptr ), "1" );
+    test( isOkTotal, "Sorted by inclusive time: ", std::to_string( !entries.empty() && entries[0].path_ == "prof_top" ), "1" );
+    test( isOkTotal, "Exclusive <= inclusive: ", std::to_string( top && top->exclusiveNs_ <= top->inclusiveNs_ ), "1" );
+
+    std::ostringstream folded;
+    Profiler::writeFolded( folded );
+    test( isOkTotal, "Folded stacks have deepest path: ",
+          std::to_string( folded.str().find( "prof_top;prof_middle;prof_leaf " ) != std::string::npos ), "1" );
+
+    return isOkTotal;
+}
@@ -1,9 +1,12 @@
 #include <iostream>
 #include <string>
+#include <sstream>
+#include <thread>
 #include "../debuglog.h"
 
 // Declaration from main.cpp
 bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+size_t getAllocationCount();
 
 using namespace ::tsv::debug;
 
@@ -19,6 +22,13 @@ namespace {
       last_value += output;
       std::cout<< output;
   }
+
+  // Handler which does not allocate anything
+  char last_line[256];
+  void testLoggerHandlerNoAlloc( const char* fmt, void* args )
+  {
+      vsnprintf( last_line, sizeof(last_line), fmt, *static_cast<va_list*>(args) );
+  }
 }
 
 
@@ -143,6 +153,121 @@ void func5()
     SAY_DBG("After func6");
 }
 
+void func_thread( int* threadId )
+{
+    // Sentry chain is per-thread: this one starts from level 01
+    // even if created thread was spawned inside of deep nested scope
+    SENTRY_FUNC();
+    *threadId = ::tsv::debug::SentryLogger::getThreadId();
+}
+
+void func8()
+{
+    SENTRY_FUNC();
+    int threadId = 0;
+    std::thread th( func_thread, &threadId );
+    th.join();
+    SAY_DBG( "After thread" );
+
+    std::string expected = ::tsv::util::tostr::strfmt( "[DBG]T%d 01>{func_thread} >> Enter scope\n", threadId );
+    test( isOkTotal, "Thread has own nested level: ", std::to_string( last_value.find( expected ) != std::string::npos ), "1" );
+}
+
+void func9()
+{
+    SENTRY_FUNC( "%d args", 2 );
+    last_value.clear();
+
+    // Typed arguments are printed exactly as printf does
+    std::string str( "std_string" );
+    long long big = -1234567890123LL;
+    SAY_DBG( "%s=%-12s|%08.3f|%lld|%X", "str", str.c_str(), 3.14159, big, 0xBEEFu );
+    std::string expected = ::tsv::util::tostr::strfmt( "[DBG]T%d 01 {func9} str=%-12s|%08.3f|%lld|%X\n",
+                                                       SentryLogger::getThreadId(), str.c_str(), 3.14159, big, 0xBEEFu );
+    test( isOkTotal, "Typed SAY_DBG: ", last_value, expected.c_str() );
+}
+
+void func10_nested( int depth, std::string* eventLine )
+{
+    SENTRY_FUNC( "depth=%d", depth );
+    if ( depth > 1 )
+        func10_nested( depth - 1, eventLine );
+    else
+    {
+        const char* str = "long enough string to be on heap if it would be copied";
+        for ( int i = 0; i < 100; i++ )
+            SAY_DBG( "event %d of %s: %5.2f %c %p", i, str, i / 3.0, 'x', str );
+        if ( eventLine )
+            *eventLine = last_line;
+    }
+}
+
+void func10()
+{
+    // Rendering of line does not allocate ( except growing of per-thread buffer on the first lines )
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerNoAlloc;
+    std::string eventLine;
+    func10_nested( 70, &eventLine );
+
+    size_t allocations = getAllocationCount();
+    func10_nested( 70, nullptr );
+    allocations = getAllocationCount() - allocations;
+    LoggerHandler::handler_s = prevHandler;
+
+    std::string expected = ::tsv::util::tostr::strfmt( "[DBG]T%d 70", SentryLogger::getThreadId() ) + std::string( 70, ' ' ) + "{func10_nested} event 99";
+    test( isOkTotal, "Indentation of deep level: ", eventLine.substr( 0, expected.size() ), expected.c_str() );
+    test( isOkTotal, "Heap allocations per event: ", std::to_string( allocations ), "0" );
+}
+
+void func11()
+{
+    // Stream gives the same text as ostream and splits lines in place
+    SENTRY_SILENT();
+    last_value.clear();
+    const char* cstr = "cstr";
+    std::string str( "std_string" );
+    short sh = -7;
+    unsigned long long ull = 18446744073709551615ULL;
+    const void* ptr = &sh;
+    const unsigned char* ucstr = reinterpret_cast<const unsigned char*>( "ucstr" );
+    const signed char scstr[] = { 's', 'c', 0 };
+    std::string longStr( 300, 'x' );
+    std::ostringstream os;
+    os << 'c' << cstr << "|" << str << "|" << sh << "|" << ull << "|" << true << "|" << 2.5 << "|" << 1e20f << "|" << ptr << "|" << 12.5L
+       << "|" << ucstr << "|" << scstr << "|" << longStr;
+    sentry << 'c' << cstr << "|" << str << "|" << sh << "|" << ull << "|" << true << "|" << 2.5 << "|" << 1e20f << "|" << ptr << "|" << 12.5L
+           << "|" << ucstr << "|" << scstr << "|" << longStr
+           << "\n\nsecond line\nthird";
+    sentry << " line\n";
+    std::string prefix = ::tsv::util::tostr::strfmt( "[DBG]T%d 01 {func11} ", SentryLogger::getThreadId() );
+    std::string expected = prefix + os.str() + "\n" + prefix + "second line\n" + prefix + "third line\n";
+    test( isOkTotal, "Stream output: ", last_value, expected.c_str() );
+}
+
+void func12_stream()
+{
+    SENTRY_SILENT();
+    sentry << "short line " << 42 << "\n";
+}
+
+void func12()
+{
+    // Short stream output costs single allocation ( stream with inline buffer )
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerNoAlloc;
+    func12_stream();
+
+    size_t allocations = getAllocationCount();
+    func12_stream();
+    allocations = getAllocationCount() - allocations;
+    LoggerHandler::handler_s = prevHandler;
+
+    std::string expected = ::tsv::util::tostr::strfmt( "[DBG]T%d 01 {func12_stream} short line 42", SentryLogger::getThreadId() );
+    test( isOkTotal, "Stream line: ", last_line, expected.c_str() );
+    test( isOkTotal, "Heap allocations per stream: ", std::to_string( allocations ), "1" );
+}
+
 bool test_sentry()
 {
     // Prepare sequence
@@ -159,6 +284,11 @@ bool test_sentry()
 
     func1();
     func2( intvalue, "str_" );
+    func8();
+    func9();
+    func10();
+    func11();
+    func12();
 
     return isOkTotal;
 }
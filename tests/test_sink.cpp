@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "../debuglog.h"
+#include "../debugsink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+static std::string handlerOutput;
+
+static void testLoggerHandlerSink( const char* fmt, void* args )
+{
+    std::string line = ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) );
+    handlerOutput += line.substr( line.find( '{' ) ) + "\n";
+}
+
+// Collect "level:context:message" of records
+struct CollectSink : LogSink
+{
+    std::mutex  mutex_;
+    std::string out_;
+    std::string sites_;     // function of callsite of each record
+    size_t      fields_ = 0;
+
+    void write( const LogRecord& rec ) override
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        out_ += std::to_string( rec.level_ & SentryLoggerFlags::LOG_ALL ) + ":" + rec.context_ + ":" + rec.message_ + "\n";
+        fields_ += rec.fieldCount_;
+        sites_ += std::string( rec.callsite_ ? rec.callsite_->getFunc() : "-" ) + " ";
+    }
+};
+
+// Slow sink: says whether write() is running now
+struct SlowSink : LogSink
+{
+    std::atomic<int>  inside_{ 0 };
+    std::atomic<bool> entered_{ false };
+
+    void write( const LogRecord& ) override
+    {
+        inside_++;
+        entered_ = true;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+        inside_--;
+    }
+};
+
+void sink_slow_func()
+{
+    SENTRY_SILENT();
+    SAY_DBG( "slow" );
+}
+
+void sink_ctx_func( int value )
+{
+    SENTRY_FUNC();
+    SAY_ARGS( value );
+}
+
+// Kind of event is set for one event only, even if that event is filtered by sink
+void sink_kind_func()
+{
+    SENTRY_FUNC();
+    sentry << LoggerEvent( SentryLoggerFlags::LOG_LEAVE );
+    SAY_DBG( "as leave" );
+    SAY_DBG( "as event" );
+}
+
+void other_func()
+{
+    SENTRY_FUNC();
+    SAY_DBG( "other" );
+}
+
+bool test_sink()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerSink;
+
+    // Handler gets only events, own sink gets everything of "sink_ctx*" contexts
+    CollectSink all;
+    test( isOkTotal, "Filter of handler: ", std::to_string( LogSinks::setFilter( LogSinks::SINK_HANDLER, SinkFilter( SentryLoggerFlags::LOG_EVENTS ) ) ), "1" );
+    int id = LogSinks::add( &all, SinkFilter( SentryLoggerFlags::LOG_ALL, "sink_ctx*" ) );
+    sink_ctx_func( 5 );
+    other_func();
+    test( isOkTotal, "Handler gets events: ", handlerOutput, "{sink_ctx_func} value = 5\n{other_func} other\n" );
+    handlerOutput.clear();
+    sink_kind_func();
+    test( isOkTotal, "One-shot kind of filtered event: ", handlerOutput, "{sink_kind_func} as event\n" );
+    test( isOkTotal, "Sink gets its context: ", all.out_, "1:sink_ctx_func:>> Enter scope\n4:sink_ctx_func:value = 5\n2:sink_ctx_func:>> Leave scope\n" );
+    test( isOkTotal, "Sink gets typed fields: ", std::to_string( all.fields_ ), "1" );
+    test( isOkTotal, "Sink gets callsite: ", all.sites_, "sink_ctx_func sink_ctx_func sink_ctx_func " );
+
+    // Thread affinity
+    CollectSink mainOnly;
+    int mainId = LogSinks::add( &mainOnly, SinkFilter( SentryLoggerFlags::LOG_EVENTS, "", SentryLogger::getThreadId() ) );
+    std::thread th( other_func );
+    th.join();
+    other_func();
+    test( isOkTotal, "Sink of thread: ", mainOnly.out_, "4:other_func:other\n" );
+
+    test( isOkTotal, "Remove sink: ", std::to_string( LogSinks::remove( id ) && LogSinks::remove( mainId ) ), "1" );
+    test( isOkTotal, "Remove unknown sink: ", std::to_string( LogSinks::remove( id ) ), "0" );
+    all.out_.clear();
+    sink_ctx_func( 6 );
+    test( isOkTotal, "Removed sink gets nothing: ", all.out_, "" );
+
+    // remove() waits until write() which is in progress is finished
+    SlowSink slow;
+    int slowId = LogSinks::add( &slow );
+    std::thread writer( sink_slow_func );
+    while ( !slow.entered_ )
+        std::this_thread::yield();
+    LogSinks::remove( slowId );
+    test( isOkTotal, "No write after remove: ", std::to_string( slow.inside_.load() ), "0" );
+    writer.join();
+
+    LogSinks::setFilter( LogSinks::SINK_HANDLER, SinkFilter() );
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
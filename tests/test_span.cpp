@@ -0,0 +1,128 @@
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "../debuglog.h"
+#include "../debugsink.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+static std::string lastLine;
+
+static void testLoggerHandlerSpan( const char* fmt, void* args )
+{
+    lastLine = ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) );
+}
+
+// Ids of the last event
+struct SpanSink : LogSink
+{
+    std::mutex mutex_;
+    uint64_t   traceId_ = 0, spanId_ = 0, parentSpanId_ = 0;
+
+    void write( const LogRecord& rec ) override
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        traceId_ = rec.traceId_;
+        spanId_ = rec.spanId_;
+        parentSpanId_ = rec.parentSpanId_;
+    }
+};
+
+static SpanSink spanSink;
+static uint64_t workerTrace, workerParent, orphanTrace, orphanSpan, orphanParent;
+
+void span_worker( SpanContext ctx )
+{
+    SENTRY_ENTER_CONTEXT( ctx );
+    SAY_DBG( "no own sentry yet" );
+    SENTRY_FUNC();
+    workerTrace = sentry.getTraceId();
+    workerParent = sentry.getParentSpanId();
+}
+
+void span_orphan()
+{
+    SENTRY_FUNC();
+    orphanTrace = sentry.getTraceId();
+    orphanSpan = sentry.getSpanId();
+    orphanParent = sentry.getParentSpanId();
+}
+
+static std::string isSame( uint64_t a, uint64_t b )
+{
+    return std::to_string( a == b );
+}
+
+bool test_span()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerSpan;
+    int sinkId = LogSinks::add( &spanSink );
+
+    test( isOkTotal, "No context outside of sentry: ", std::to_string( SentryLogger::captureContext().isValid() ), "0" );
+    {
+        SENTRY_CONTEXT( "span_outer" );
+        test( isOkTotal, "Root is trace: ", isSame( sentry.getTraceId(), sentry.getSpanId() ), "1" );
+        test( isOkTotal, "Root has no parent: ", std::to_string( sentry.getParentSpanId() ), "0" );
+        uint64_t outerSpan = sentry.getSpanId();
+        uint64_t outerTrace = sentry.getTraceId();
+        {
+            SENTRY_CONTEXT( "span_inner" );
+            test( isOkTotal, "Nested parent: ", isSame( sentry.getParentSpanId(), outerSpan ), "1" );
+            test( isOkTotal, "Nested trace: ", isSame( sentry.getTraceId(), outerTrace ), "1" );
+            SAY_DBG( "inner event" );
+            test( isOkTotal, "Event carries span: ", isSame( spanSink.spanId_, sentry.getSpanId() ), "1" );
+            test( isOkTotal, "Event carries parent: ", isSame( spanSink.parentSpanId_, outerSpan ), "1" );
+        }
+
+        // Hand off to other thread
+        SpanContext ctx = SENTRY_CAPTURE_CONTEXT();
+        test( isOkTotal, "Captured span: ", isSame( ctx.spanId_, outerSpan ), "1" );
+        std::thread worker( span_worker, ctx );
+        worker.join();
+        test( isOkTotal, "Worker trace: ", isSame( workerTrace, outerTrace ), "1" );
+        test( isOkTotal, "Worker parent: ", isSame( workerParent, outerSpan ), "1" );
+
+        std::thread orphan( span_orphan );
+        orphan.join();
+        test( isOkTotal, "Thread without context is new trace: ", isSame( orphanTrace, orphanSpan ) + std::to_string( orphanParent ), "10" );
+        test( isOkTotal, "Other trace: ", isSame( orphanTrace, outerTrace ), "0" );
+
+        // Enter context inside of own sentry
+        {
+            SENTRY_CONTEXT( "span_loop" );
+            SENTRY_ENTER_CONTEXT( SpanContext( orphanTrace, orphanSpan ) );
+            SAY_DBG( "event of entered context" );
+            test( isOkTotal, "Entered context wins: ", isSame( spanSink.spanId_, orphanSpan ) + isSame( spanSink.traceId_, orphanTrace ), "11" );
+        }
+        test( isOkTotal, "Context is restored: ", isSame( SentryLogger::captureContext().spanId_, outerSpan ), "1" );
+
+        // Prefix of text line
+        SentryLogger::setSpanIdMode( true );
+        SAY_DBG( "with ids" );
+        SentryLogger::setSpanIdMode( false );
+        char ids[40];
+        snprintf( ids, sizeof(ids), "%016llx:%016llx ", static_cast<unsigned long long>( outerTrace ),
+                                                        static_cast<unsigned long long>( outerSpan ) );
+        test( isOkTotal, "Ids in prefix: ", std::to_string( lastLine.find( ids ) != std::string::npos ), "1" );
+    }
+
+    std::set<uint64_t> spans;
+    for ( int i = 0; i < 1000; i++ )
+    {
+        SENTRY_SILENT();
+        spans.insert( sentry.getSpanId() );
+    }
+    test( isOkTotal, "Unique span ids: ", std::to_string( spans.size() ), "1000" );
+
+    LogSinks::remove( sinkId );
+    LoggerHandler::handler_s = prevHandler;
+    return isOkTotal;
+}
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "../debuglog.h"
+#include "../debugtiming.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+namespace {
+
+  std::string last_value;
+  void testLoggerHandlerTiming( const char* fmt, void* args )
+  {
+      last_value = ::tsv::util::tostr::strfmtVA( fmt, static_cast<va_list*>(args) );
+  }
+
+  std::string timed_name;
+  uint64_t timed_ns = 0;
+  void testTimingHandler( const char* name, uint64_t ns )
+  {
+      timed_name = name;
+      timed_ns = ns;
+  }
+}
+
+void timing_func()
+{
+    SENTRY_ALT_FUNC( LOG_ALL | LOG_TIMING )();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+}
+
+bool test_timing()
+{
+    isOkTotal = true;
+
+    std::cout << "Source: " << ( Timing::getSource() == Timing::SOURCE_TSC ? "TSC" : "CLOCK_MONOTONIC" )
+              << ", ticks per second: " << Timing::getTicksPerSecond() << "\n";
+
+    // Ticks are monotonic and converted to real nanoseconds
+    uint64_t start = Timing::now();
+    uint64_t startNs = Timing::monotonicNs();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    uint64_t ns = Timing::toNs( Timing::now() - start );
+    uint64_t realNs = Timing::monotonicNs() - startNs;
+    test( isOkTotal, "Duration in ns: ", std::to_string( ns ) );
+    test( isOkTotal, "Measured duration is within 5% of CLOCK_MONOTONIC: ",
+          std::to_string( ns > realNs * 0.95 && ns < realNs * 1.05 ), "1" );
+
+    // Timed sentry reports nanoseconds to Leave line and to timing handler
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = testLoggerHandlerTiming;
+    LoggerHandler::timing_handler_s = testTimingHandler;
+    timing_func();
+    LoggerHandler::timing_handler_s = nullptr;
+    LoggerHandler::handler_s = prevHandler;
+
+    test( isOkTotal, "Leave line: ", last_value );
+    std::string expected = "exectime=" + std::to_string( timed_ns ) + " ns";
+    test( isOkTotal, "Leave line has duration in ns: ", std::to_string( last_value.find( expected ) != std::string::npos ), "1" );
+    test( isOkTotal, "Timing handler got name: ", timed_name, "timing_func" );
+    test( isOkTotal, "Timing handler got at least 5ms: ", std::to_string( timed_ns >= 5000000 ), "1" );
+
+    return isOkTotal;
+}
@@ -1,4 +1,6 @@
+#include <cstdio>
 #include <iostream>
+#include <limits>
 #include "../tostr.h"
 
 // Declaration from main.cpp
@@ -44,6 +46,33 @@ bool test_tostr()
     test( isOk, "", toStr( nullptr ), "nullptr");
     test( isOk, "", toStr( &ss ) );   // address could differ, so just print not test
 
+    char pbuf[64];
+    snprintf( pbuf, sizeof(pbuf), "%p", static_cast<const void*>( vv ) );
+    test( isOk, "Same as %p: ", vv_addr, pbuf );
+
+    std::cout << "\nNumbers:\n";
+    test( isOk, "", toStr( -15 ), "-15" );
+    test( isOk, "", toStr( 'A' ), "65" );
+    test( isOk, "", toStr( true ), "1" );
+    test( isOk, "", toStr( 0u ), "0" );
+    test( isOk, "", toStr( std::numeric_limits<long long>::min() ), "-9223372036854775808" );
+    test( isOk, "", toStr( std::numeric_limits<unsigned long long>::max() ), "18446744073709551615" );
+    // Each length of number
+    std::string digits, expected;
+    unsigned long long v = 1;
+    for ( int i = 0; i < 20; i++, v *= 10 )
+    {
+        digits += toStr( v - 1 ) + "," + toStr( v ) + ",";
+        snprintf( pbuf, sizeof(pbuf), "%llu,%llu,", v - 1, v );
+        expected += pbuf;
+    }
+    test( isOk, "Each length: ", digits, expected.c_str() );
+    char hbuf[16];
+    test( isOk, "", std::string( hbuf, formatHex( hbuf, 0 ) ), "0" );
+    test( isOk, "", std::string( hbuf, formatHex( hbuf, 0x9a0fULL ) ), "9a0f" );
+    test( isOk, "", std::string( hbuf, formatHex( hbuf, 0xfedcba9876543210ULL ) ), "fedcba9876543210" );
+    test( isOk, "", std::string( hbuf, formatHex( hbuf, 0xabULL, 4 ) ), "00ab" );
+
     std::cout << "\nObjects:\n";
     test( isOk, "", toStr( c ) );    // unknown object - say type. It differ depends on compiler
                                         // so just print not test
@@ -58,6 +87,33 @@ bool test_tostr()
     test( isOk, "", TOSTR_EXPR( res, "=", 3, "+", add(x,13) ),
  			"res{26} = 3 + add(x,13){23} " );
 
+    // Commas inside of calls and literals are not separators, no limit of arguments
+    test( isOk, "", TOSTR_ARGS( add( x, 1 ), "a,(b", ',', x ), "add( x, 1 ) = 11, a,(b ',' = 44, x = 10" );
+    test( isOk, "", TOSTR_EXPR( x , "+", add(1,2) ), "x{10} + add(1,2){3} " );
+    test( isOk, "", TOSTR_JOIN( 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33 ),
+                    "123456789101112131415161718192021222324252627282930313233" );
+    test( isOk, "", TOSTR_ARGS( x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x,x ).substr( 240 ), "x = 10, x = 10" );
+
+    std::cout << "\n\nTyped format:\n";
+    std::string out;
+    short neg = -1;
+    FormatArg args[] = { -7, neg, 2.5, "ab", 'Q', 6, 42u, ss };
+    formatArgs( out, "%d|%x|%5.2f|%-4s|%c|%*u|%s|%%", args, 8 );
+    test( isOk, "", out, strfmt( "%d|%x|%5.2f|%-4s|%c|%*u|%s|%%", -7, neg, 2.5, "ab", 'Q', 6, 42u, ss.c_str() ).c_str() );
+
+    // Mismatched and missed arguments could not crash
+    out.clear();
+    FormatArg wrong[] = { "text", 42 };
+    formatArgs( out, "%d %s %d", wrong, 2 );
+    test( isOk, "", out, "text 42 %d" );
+
+    // Results longer than initial buffer and close to its size are not truncated
+    std::cout << "\n\nLong sprintf:\n";
+    std::string big( 20000, 'z' );
+    test( isOk, "", std::to_string( strfmt( "%s|%d", big.c_str(), 77 ) == big + "|77" ), "1" );
+    std::string edge( 9997, 'e' );
+    test( isOk, "", std::to_string( strfmt( "%s", edge.c_str() ).size() ), "9997" );
+
     std::cout << "\n";
 
     return isOk;
@@ -0,0 +1,60 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdio>       // remove
+#include "../debuglog.h"
+#include "../debugtrace.h"
+
+// Declaration from main.cpp
+bool test( bool& isOkTotal, const char* prefix, std::string val, const char* compare = nullptr, bool equal = true );
+int countOf( const std::string& text, const std::string& what );
+
+using namespace ::tsv::debug;
+
+static bool isOkTotal;
+
+void trace_inner( int id )
+{
+    SENTRY_SILENT();
+    SAY_DBG( "inner \"%d\"", id );
+}
+
+void trace_outer( int id )
+{
+    SENTRY_FUNC( "id=%d", id );
+    trace_inner( id );
+}
+
+bool test_trace()
+{
+    isOkTotal = true;
+    auto prevHandler = LoggerHandler::handler_s;
+    LoggerHandler::handler_s = nullptr;
+
+    const char* path = "/tmp/test_trace.json";
+    test( isOkTotal, "Open trace: ", std::to_string( ChromeTrace::open( path ) ), "1" );
+    trace_outer( 1 );
+    std::thread th( trace_outer, 2 );
+    th.join();
+    ChromeTrace::close();
+    trace_outer( 3 );               // not traced
+    LoggerHandler::handler_s = prevHandler;
+
+    std::ifstream file( path );
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string json = ss.str();
+    std::cout << json;
+    remove( path );
+
+    test( isOkTotal, "JSON array: ", std::to_string( json.size() > 4 && json.compare( 0, 2, "[\n" ) == 0 && json.compare( json.size() - 3, 3, "\n]\n" ) == 0 ), "1" );
+    test( isOkTotal, "Begin events: ", std::to_string( countOf( json, "\"ph\":\"B\"" ) ), "4" );
+    test( isOkTotal, "End events: ", std::to_string( countOf( json, "\"ph\":\"E\"" ) ), "4" );
+    test( isOkTotal, "Instant events with escaped message: ", std::to_string( countOf( json, "\"args\":{\"msg\":\"inner \\\"" ) ), "2" );
+    test( isOkTotal, "Threads are named: ", std::to_string( countOf( json, "\"thread_name\"" ) ), "2" );
+    test( isOkTotal, "Not traced after close: ", std::to_string( countOf( json, "inner \\\"3" ) ), "0" );
+
+    return isOkTotal;
+}
@@ -59,7 +59,7 @@ struct Deriv : public Base
 };
 
 
-int test_watcher()
+bool test_watcher()
 {
     // Prepare sequence
     isOkTotal = true;
@@ -78,4 +78,5 @@ int test_watcher()
     //TODO: Why here operation= wasn't triggered ??
     v = *p;
     delete p;
+    return isOkTotal;
 }
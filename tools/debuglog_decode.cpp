@@ -0,0 +1,44 @@
+/*********************************************************************
+  Purpose: Decoder of binary log ( produced by BinaryLog )
+           Build: g++ -std=c++11 -pthread tools/debuglog_decode.cpp *.cpp -o debuglog_decode
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <iostream>
+#include <cstring>
+#include "../debugbinlog.h"
+
+int main( int argc, char* argv[] )
+{
+    bool withTime = false, withIds = false;
+    int first = 1;
+    for ( ; first < argc && argv[first][0] == '-'; first++ )
+    {
+        if ( !strcmp( argv[first], "-t" ) )
+            withTime = true;
+        else if ( !strcmp( argv[first], "-i" ) )
+            withIds = true;
+        else
+            break;
+    }
+    if ( first >= argc )
+    {
+        std::cerr << "Usage: " << argv[0] << " [-t] [-i] file.dbglog ...\n"
+                  << "   -t   prefix each line with time since start of log (seconds)\n"
+                  << "   -i   show trace:span:parent ids of each line\n";
+        return 2;
+    }
+
+    int rv = 0;
+    for ( int i = first; i < argc; i++ )
+    {
+        if ( !::tsv::debug::BinaryLog::decode( argv[i], std::cout, withTime, withIds ) )
+        {
+            std::cerr << argv[i] << ": not a binary debug log\n";
+            rv = 1;
+        }
+    }
+    return rv;
+}
@@ -0,0 +1,56 @@
+/*********************************************************************
+  Purpose: Cat of compressed log files ( produced by LogCompressor or FileSink )
+           Build: g++ -std=c++11 -pthread tools/dlzcat.cpp *.cpp -o dlzcat
+                  ( add -DDEBUGLOG_ZLIB=1 -lz to read zlib blocks )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include "../debugcompress.h"
+
+// Output one file ( plain text file is copied as is )
+static bool cat( std::istream& in )
+{
+    char magic[4];
+    in.read( magic, sizeof(magic) );
+    size_t n = in.gcount();
+    in.clear();
+    in.seekg( 0 );
+    if ( !::tsv::debug::LogCompressor::isCompressed( magic, n ) )
+    {
+        if ( n )
+            std::cout << in.rdbuf();
+        return true;
+    }
+    return ::tsv::debug::LogCompressor::decompress( in, std::cout );
+}
+
+int main( int argc, char* argv[] )
+{
+    if ( argc < 2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " file ...\n"
+                  << "   output text of compressed log files ( in given order )\n";
+        return 2;
+    }
+
+    int rv = 0;
+    for ( int i = 1; i < argc; i++ )
+    {
+        std::ifstream in( argv[i], std::ios::binary );
+        if ( !in )
+        {
+            std::cerr << argv[i] << ": could not open\n";
+            rv = 1;
+        }
+        else if ( !cat( in ) )
+        {
+            std::cerr << argv[i] << ": truncated or corrupted ( decoded up to the last complete block )\n";
+            rv = 1;
+        }
+    }
+    return rv;
+}
@@ -0,0 +1,39 @@
+/*********************************************************************
+  Purpose: Reader of flight recorder file ( produced by FlightRecorder )
+           Build: g++ -std=c++11 -pthread tools/flight_decode.cpp *.cpp -o flight_decode
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 16-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+
+#include <iostream>
+#include <cstring>
+#include "../debugflight.h"
+
+int main( int argc, char* argv[] )
+{
+    bool withTime = false;
+    int first = 1;
+    if ( argc > 1 && !strcmp( argv[1], "-t" ) )
+    {
+        withTime = true;
+        first++;
+    }
+    if ( first >= argc )
+    {
+        std::cerr << "Usage: " << argv[0] << " [-t] file.flight ...\n"
+                  << "   -t   prefix each line with time since start of recording (seconds)\n";
+        return 2;
+    }
+
+    int rv = 0;
+    for ( int i = first; i < argc; i++ )
+    {
+        if ( !::tsv::debug::FlightRecorder::decode( argv[i], std::cout, withTime ) )
+        {
+            std::cerr << argv[i] << ": not a flight recorder file\n";
+            rv = 1;
+        }
+    }
+    return rv;
+}
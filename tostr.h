@@ -8,7 +8,7 @@
   License: BSD. See License.txt
 **********************************************************************/
 
-#include <vector>
+#include <cstring>      // strlen
 #include "tostr_handler.h"
 
 /******************** MACRO TO USE ***********************************/
@@ -16,25 +16,25 @@
 // Print to string list of arguments with their names
 //   Example:  std::cout << TOSTR_ARGS( str_var, " abc", 3, !func(arg) ) << "\n";
 //   Output:   strvar = "VALUE1" abc, 3 = 3, !func(arg) = VALUE2
-#define TOSTR_ARGS(...) ::tsv::util::tostr::Printer( ::tsv::util::tostr::Printer::ENUM_PRINT_ARGS, { MACRO_TOSTR__EXPAND_EACH_VAL(__VA_ARGS__) } ).do_print( __VA_ARGS__ )
+#define TOSTR_ARGS(...) ::tsv::util::tostr::Printer< ::tsv::util::tostr::ENUM_PRINT_ARGS >::print( #__VA_ARGS__, __VA_ARGS__ )
 
 // The same as TOSTR_ARGS, but use extended representation of value (could be different for user-defined complex class printers)
-#define TOSTR_ARGS_EXTENDED(...) ::tsv::util::tostr::Printer( ::tsv::util::tostr::Printer::ENUM_PRINT_ARGS_EXTENDED, { MACRO_TOSTR__EXPAND_EACH_VAL(__VA_ARGS__) } ).do_print( __VA_ARGS__ )
+#define TOSTR_ARGS_EXTENDED(...) ::tsv::util::tostr::Printer< ::tsv::util::tostr::ENUM_PRINT_ARGS_EXTENDED >::print( #__VA_ARGS__, __VA_ARGS__ )
 
 
 // Print to string converted concatenation of all given values ( implicitly converted to string using toStr() )
 //   Example:  std::cout << TOSTR_JOIN( str_var, " abc", 3, !func(arg) ) << "\n";
 //   Output:   VALUE1 abc3VALUE2
-#define TOSTR_JOIN(...) ::tsv::util::tostr::Printer( ::tsv::util::tostr::Printer::ENUM_PRINT_STR, {} ).do_print( __VA_ARGS__ )
+#define TOSTR_JOIN(...) ::tsv::util::tostr::Printer< ::tsv::util::tostr::ENUM_PRINT_STR >::print( "", __VA_ARGS__ )
 
 // Combination of TOSTR_ARGS() and TOSTR_JOIN() - use literals/arithmetical as is, but name_of_var with its value for vars/calls/..
 // Use it for quickly represent simple formulas
 //   Example:  std::cout << TOSTR_EXPR( res, "=", 3, "+", !func(arg) ) << "\n";
 //   Output:  res{VALUE_RES} = 3 + !func(arg){RETURN_VALUE_OF_CALL}
-#define TOSTR_EXPR(...) ::tsv::util::tostr::Printer( ::tsv::util::tostr::Printer::ENUM_PRINT_EXPR, { MACRO_TOSTR__EXPAND_EACH_VAL(__VA_ARGS__) } ).do_print( __VA_ARGS__ )
+#define TOSTR_EXPR(...) ::tsv::util::tostr::Printer< ::tsv::util::tostr::ENUM_PRINT_EXPR >::print( #__VA_ARGS__, __VA_ARGS__ )
 
 // The same as TOSTR_EXPR, but use extended representation of value (could be different for user-defined complex class printers)
-#define TOSTR_EXPR_EXTENDED(...) ::tsv::util::tostr::Printer( ::tsv::util::tostr::Printer::ENUM_PRINT_EXPR_EXTENDED, { MACRO_TOSTR__EXPAND_EACH_VAL(__VA_ARGS__) } ).do_print( __VA_ARGS__ )
+#define TOSTR_EXPR_EXTENDED(...) ::tsv::util::tostr::Printer< ::tsv::util::tostr::ENUM_PRINT_EXPR_EXTENDED >::print( #__VA_ARGS__, __VA_ARGS__ )
 
 /************************* Implementation ***********************************/
 
@@ -43,144 +43,165 @@ namespace util{
 namespace tostr{
 
 
-class Printer
+/**********************************************
+    Texts of macro arguments
+
+Purpose: Walk one stringized list of arguments ( #__VA_ARGS__ ): "x, \"a,b\", add(x, 13)"
+         It is split at commas as preprocessor does ( inside of parentheses and literals they are not separators ),
+         so there is no limit of arguments count and no per-argument string.
+Usage:
+    ArgNames names( #__VA_ARGS__ );
+    size_t len = names.next( name );    // text of next argument is [ name, name + len )
+************************************************/
+class ArgNames
 {
 public:
-    enum Mode { ENUM_PRINT_ARGS, ENUM_PRINT_ARGS_EXTENDED, ENUM_PRINT_STR, ENUM_PRINT_EXPR, ENUM_PRINT_EXPR_EXTENDED };
+    explicit ArgNames( const char* list ) : next_( list ) {}
+
+    size_t next( const char*& name )
+    {
+        while ( *next_ == ' ' )
+            next_++;
+        name = next_;
+        const char* p = next_;
+        int depth = 0;
+        for ( ; *p && ( depth || *p != ',' ); p++ )
+        {
+            if ( *p == '(' )
+                depth++;
+            else if ( *p == ')' )
+                depth--;
+            else if ( *p == '"' || *p == '\'' )
+            {
+                char quote = *p;
+                for ( p++; *p && *p != quote; p++ )
+                    if ( *p == '\\' && p[1] )
+                        p++;
+                if ( !*p )
+                    break;
+            }
+        }
+        next_ = *p ? p + 1 : p;
+
+        size_t len = p - name;
+        while ( len && name[len - 1] == ' ' )
+            len--;
+        return len;
+    }
+
+private:
+    const char* next_;
+};
+
+
+/**********************************************
+    Append toStr( val ) to out
+
+Purpose: Numbers are formatted right into output ( no temporary string )
+************************************************/
+template<typename T>
+typename std::enable_if< std::is_integral<T>::value >::type
+appendStr( std::string& out, const T& val, int /*mode*/ )
+{
+    char buf[DECIMAL_BUF_SIZE];
+    out.append( buf, formatDecimal( buf, val ) );
+}
+
+inline void appendStr( std::string& out, const double& val, int /*mode*/ )
+{
+    char buf[FLOAT_BUF_SIZE];
+    out.append( buf, formatDouble( buf, val ) );
+}
+
+inline void appendStr( std::string& out, const float& val, int /*mode*/ )
+{
+    char buf[FLOAT_BUF_SIZE];
+    out.append( buf, formatFloat( buf, val ) );
+}
+
+template<typename T>
+typename std::enable_if< !std::is_integral<T>::value && !std::is_same<T, double>::value && !std::is_same<T, float>::value >::type
+appendStr( std::string& out, const T& val, int mode )
+{
+    out += toStr( val, mode );
+}
 
-    std::vector<const char*> names_;    // List of variable names (used for ENUM_PRINT_ARGS, ENUM_PRINT_EXPR)
-    Mode mode_;                         // Printing mode
 
-    int index_;                         // current index of argument
-    std::string acc_str_;               // string which accumulate output of do_print()
+// Printing modes of TOSTR_* macro
+enum PrintMode { ENUM_PRINT_ARGS, ENUM_PRINT_ARGS_EXTENDED, ENUM_PRINT_STR, ENUM_PRINT_EXPR, ENUM_PRINT_EXPR_EXTENDED };
 
-    Printer( Mode mode, std::vector<const char*> names )
-     {
-         mode_ = mode;
-         names_ = names;
-     }
+/**********************************************
+    Printer of TOSTR_* macro
 
-    template<typename... StrTail>
-     std::string do_print( StrTail&&... tail )
+Purpose: Mode is template argument, so each expansion is just a sequence of appends
+         ( checks of mode are resolved by compiler )
+************************************************/
+template<int Mode>
+class Printer
+{
+public:
+    template<typename... Args>
+    static std::string print( const char* names, const Args&... args )
     {
-        index_ = 0;
-        acc_str_ = "";
-        return print( std::forward<StrTail>( tail )... );
+        Printer printer( names );
+        printer.out_.reserve( strlen( names ) + sizeof...(Args) * 16 );
+
+        // braced list keeps order of arguments
+        int expand[] = { 0, ( printer.add( args ), 0 )... };
+        (void)expand;
+        return std::move( printer.out_ );
     }
 
 private:
-    // Final print
-    std::string print()
-    {
-       return std::move( acc_str_ );
-    }
+    static const bool isArgs_ = ( Mode == ENUM_PRINT_ARGS || Mode == ENUM_PRINT_ARGS_EXTENDED );
+    static const bool isExpr_ = ( Mode == ENUM_PRINT_EXPR || Mode == ENUM_PRINT_EXPR_EXTENDED );
+    static const int  modeToStr_ = ( Mode == ENUM_PRINT_ARGS || Mode == ENUM_PRINT_EXPR ) ? ENUM_TOSTR_REPR : ENUM_TOSTR_EXTENDED;
 
-    // Recursive parse templates
-    // Note: use formatters instead of plain branches to make only one instantiation of toStr
-    //   [to minimize error output in case if something goes wrong]
-    template<typename Head, typename... Tail>
-    std::string print( const Head& head, Tail&&... tail )
-    {
-        int modeToStr = ENUM_TOSTR_DEFAULT; // token representation mode
-        int asisFlag = true;                // print as is or not?
-        const char* betweenToken = " = ";   // token inserted between name and value
-        const char* suffix = "";            // token added after value
+    ArgNames    names_;
+    std::string out_;
+    bool        isPrevLiteral_;         // previous argument of TOSTR_ARGS was string literal
+
+    explicit Printer( const char* names ) : names_( names ), isPrevLiteral_( false ) {}
 
-        // 1. Tune output format + print separator if needed
-        if ( mode_ == ENUM_PRINT_ARGS || mode_ == ENUM_PRINT_ARGS_EXTENDED )
+    template<typename T>
+    void add( const T& val )
+    {
+        if ( !isArgs_ && !isExpr_ )
         {
-            // add separator
-            if ( !acc_str_.empty() )
-            {
-                char prev = names_[index_-1][0];
-                acc_str_ += ( (  prev != '"' ) ? ", " : " " );
-            }
+            appendStr( out_, val, ENUM_TOSTR_DEFAULT );
+            return;
+        }
+
+        const char* name;
+        size_t nameLen = names_.next( name );
 
-            // tune format
-            char first = names_[index_][0];     // first symbol of #arg (detect literals and numbers)
-            modeToStr = ( mode_==ENUM_PRINT_ARGS ? ENUM_TOSTR_REPR : ENUM_TOSTR_EXTENDED );
-            asisFlag = ( first == '"' );
-            //betweenToken = " = ";         //use default: " = " between name and value
-            //suffix = "";                  //use default "" after value
+        // literals ( and numbers for TOSTR_EXPR ) are printed as is
+        bool isLiteral = ( name[0] == '"' || ( isExpr_ && name[0] >= '0' && name[0] <= '9' ) );
+        if ( isArgs_ )
+        {
+            if ( !out_.empty() )
+                out_ += isPrevLiteral_ ? " " : ", ";
+            isPrevLiteral_ = isLiteral;
+            if ( !isLiteral )
+                out_.append( name, nameLen ).append( " = " );
+            appendStr( out_, val, isLiteral ? ENUM_TOSTR_DEFAULT : modeToStr_ );
         }
-        else if ( mode_ == ENUM_PRINT_EXPR || mode_ == ENUM_PRINT_EXPR_EXTENDED )
+        else if ( isLiteral )
         {
-            // tune format
-            char first = names_[index_][0];     // first symbol of #arg (detect literals and numbers)
-            modeToStr = ( mode_==ENUM_PRINT_EXPR ? ENUM_TOSTR_REPR : ENUM_TOSTR_EXTENDED );
-            asisFlag = (  first == '"' || ( first >= '0' && first <= '9' ) );
-            if ( !asisFlag )
-            {
-                betweenToken = "{";         //between name and value
-                suffix = "} ";              //after value
-            }
-            else
-            {
-                //betweenToken = "nomatter";
-                suffix = " ";
-            }
+            appendStr( out_, val, ENUM_TOSTR_DEFAULT );
+            out_ += ' ';
         }
         else
         {
-            // tune format
-            //modeToStr = ENUM_TOSTR_DEFAULT;// use default: print values as STR
-            //asisFlag = ASIS;               // use default: always print as is
-            //betweenToken = "no matter";    // use default: because have no matter
-            //suffix = "";                   // use default: because have no matter
+            out_.append( name, nameLen ) += '{';
+            appendStr( out_, val, modeToStr_ );
+            out_ += "} ";
         }
-
-        // 2. Do output
-        if ( !asisFlag )
-            acc_str_ += std::string(names_[index_]) + betweenToken;
-        acc_str_ += toStr( head, asisFlag ? ENUM_TOSTR_DEFAULT : modeToStr ) + suffix;
-
-        index_++;
-        return print( std::forward<Tail>( tail )... );
     }
-
 };
 
 } // end of namespace tostr
 } // end of namespace util
 } // end of namespace tsv
 
-/****************  Auxilarly macros ******************/
-
-#define MACRO_TOSTR__CHOOSE_NTH(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26,a27,a28,a29,a30,a31, num, ...) num
-#define MACRO_TOSTR__GET_ARG_NUM(...) MACRO_TOSTR__CHOOSE_NTH( __VA_ARGS__, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 09, 08, 07, 06, 05, 04, 03, 02, 01, 00 )
-#define MACRO_TOSTR__EXPAND_EACH_00()
-#define MACRO_TOSTR__EXPAND_EACH_01(a01) #a01
-#define MACRO_TOSTR__EXPAND_EACH_02(a01,a02) #a01, #a02
-#define MACRO_TOSTR__EXPAND_EACH_03(a01,a02,a03) #a01, #a02, #a03
-#define MACRO_TOSTR__EXPAND_EACH_04(a01,a02,a03,a04) #a01, #a02, #a03, #a04
-#define MACRO_TOSTR__EXPAND_EACH_05(a01,a02,a03,a04,a05) #a01, #a02, #a03, #a04, #a05
-#define MACRO_TOSTR__EXPAND_EACH_06(a01,a02,a03,a04,a05,a06) #a01, #a02, #a03, #a04, #a05, #a06
-#define MACRO_TOSTR__EXPAND_EACH_07(a01,a02,a03,a04,a05,a06,a07) #a01, #a02, #a03, #a04, #a05, #a06, #a07
-#define MACRO_TOSTR__EXPAND_EACH_08(a01,a02,a03,a04,a05,a06,a07,a08) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08
-#define MACRO_TOSTR__EXPAND_EACH_09(a01,a02,a03,a04,a05,a06,a07,a08,a09) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09
-#define MACRO_TOSTR__EXPAND_EACH_10(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10
-#define MACRO_TOSTR__EXPAND_EACH_11(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11
-#define MACRO_TOSTR__EXPAND_EACH_12(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12
-#define MACRO_TOSTR__EXPAND_EACH_13(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13
-#define MACRO_TOSTR__EXPAND_EACH_14(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14
-#define MACRO_TOSTR__EXPAND_EACH_15(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15
-#define MACRO_TOSTR__EXPAND_EACH_16(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16
-#define MACRO_TOSTR__EXPAND_EACH_17(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17
-#define MACRO_TOSTR__EXPAND_EACH_18(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18
-#define MACRO_TOSTR__EXPAND_EACH_19(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19
-#define MACRO_TOSTR__EXPAND_EACH_20(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20
-#define MACRO_TOSTR__EXPAND_EACH_21(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21
-#define MACRO_TOSTR__EXPAND_EACH_22(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22
-#define MACRO_TOSTR__EXPAND_EACH_23(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23
-#define MACRO_TOSTR__EXPAND_EACH_24(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24
-#define MACRO_TOSTR__EXPAND_EACH_25(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25
-#define MACRO_TOSTR__EXPAND_EACH_26(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25, #a26
-#define MACRO_TOSTR__EXPAND_EACH_27(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26,a27) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25, #a26, #a27
-#define MACRO_TOSTR__EXPAND_EACH_28(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26,a27,a28) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25, #a26, #a27, #a28
-#define MACRO_TOSTR__EXPAND_EACH_29(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26,a27,a28,a29) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25, #a26, #a27, #a28, #a29
-#define MACRO_TOSTR__EXPAND_EACH_30(a01,a02,a03,a04,a05,a06,a07,a08,a09,a10,a11,a12,a13,a14,a15,a16,a17,a18,a19,a20,a21,a22,a23,a24,a25,a26,a27,a28,a29,a30) #a01, #a02, #a03, #a04, #a05, #a06, #a07, #a08, #a09, #a10, #a11, #a12, #a13, #a14, #a15, #a16, #a17, #a18, #a19, #a20, #a21, #a22, #a23, #a24, #a25, #a26, #a27, #a28, #a29, #a30
-#define MACRO_TOSTR__TOKEN_PASTE( x, y ) x ## y
-#define MACRO_TOSTR__TOKEN_PASTE2( x, y ) MACRO_TOSTR__TOKEN_PASTE( x, y )
-#define MACRO_TOSTR__EXPAND_EACH_VAL(...) MACRO_TOSTR__TOKEN_PASTE2( MACRO_TOSTR__EXPAND_EACH_, MACRO_TOSTR__GET_ARG_NUM(__VA_ARGS__))( __VA_ARGS__ )
-
 #endif
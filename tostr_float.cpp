@@ -0,0 +1,332 @@
+/*********************************************************************
+  Purpose: Shortest round-trip formatting of float and double
+           ( Grisu2 of Florian Loitsch, "Printing Floating-Point
+             Numbers Quickly and Accurately with Integers", 2010 )
+  Author: Taranenko Sergey (tsvstar@gmail.com)
+  Date: 17-Oct-2026
+  License: BSD. See License.txt
+**********************************************************************/
+#include <cmath>        // signbit
+#include <cstdint>
+#include <cstring>      // memcpy, memmove
+#include <limits>
+#include "tostr_handler.h"
+
+namespace tsv {
+namespace util{
+namespace tostr{
+
+namespace
+{
+    // Floating value f * 2^e with 64-bit significand ( "do it yourself floating point" )
+    struct DiyFp
+    {
+        uint64_t f_;
+        int      e_;
+
+        DiyFp( uint64_t f, int e ) : f_( f ), e_( e ) {}
+    };
+
+    // x - y. Exponents are the same and x >= y
+    DiyFp sub( const DiyFp& x, const DiyFp& y )
+    {
+        return DiyFp( x.f_ - y.f_, x.e_ );
+    }
+
+    // x * y rounded to upper 64 bits of product
+    DiyFp mul( const DiyFp& x, const DiyFp& y )
+    {
+        const uint64_t M32 = 0xFFFFFFFFu;
+        uint64_t a = x.f_ >> 32, b = x.f_ & M32;
+        uint64_t c = y.f_ >> 32, d = y.f_ & M32;
+        uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        uint64_t mid = ( bd >> 32 ) + ( ad & M32 ) + ( bc & M32 ) + ( 1u << 31 );
+        return DiyFp( ac + ( ad >> 32 ) + ( bc >> 32 ) + ( mid >> 32 ), x.e_ + y.e_ + 64 );
+    }
+
+    DiyFp normalize( DiyFp x )
+    {
+        while ( !( x.f_ >> 63 ) )
+        {
+            x.f_ <<= 1;
+            x.e_--;
+        }
+        return x;
+    }
+
+    // Value and its rounding interval [ minus, plus ]. plus is normalized, minus has the same exponent
+    struct Boundaries
+    {
+        DiyFp w_, minus_, plus_;
+    };
+
+    // Decompose positive finite value. "precision" is count of significand bits ( with hidden one )
+    Boundaries computeBoundaries( uint64_t bits, int precision, int exponentBias )
+    {
+        const uint64_t hiddenBit = 1ull << ( precision - 1 );
+        const int      bias = exponentBias + precision - 1;
+        uint64_t fraction = bits & ( hiddenBit - 1 );
+        int      biasedE = static_cast<int>( bits >> ( precision - 1 ) );
+
+        DiyFp v = biasedE ? DiyFp( fraction + hiddenBit, biasedE - bias )
+                          : DiyFp( fraction, 1 - bias );        // denormal
+
+        // Interval is asymmetric when value is a power of two: lower neighbour is closer
+        bool isLowerCloser = ( fraction == 0 && biasedE > 1 );
+        DiyFp plus = normalize( DiyFp( 2 * v.f_ + 1, v.e_ - 1 ) );
+        DiyFp minus = isLowerCloser ? DiyFp( 4 * v.f_ - 1, v.e_ - 2 ) : DiyFp( 2 * v.f_ - 1, v.e_ - 1 );
+        minus.f_ <<= minus.e_ - plus.e_;
+        minus.e_ = plus.e_;
+
+        Boundaries rv = { normalize( v ), minus, plus };
+        return rv;
+    }
+
+    // Normalized 10^k ( rounded ) for k = -300, -292, ... 340
+    struct CachedPower
+    {
+        uint64_t f_;
+        int      e_;
+        int      k_;
+    };
+
+    const int CACHED_POWERS_MIN_K = -300;
+    const int CACHED_POWERS_STEP = 8;
+    const CachedPower cachedPowers[] =
+    {
+        { 0xAB70FE17C79AC6CA, -1060, -300 }, { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+        { 0xBE5691EF416BD60C, -1007, -284 }, { 0x8DD01FAD907FFC3C,  -980, -276 },
+        { 0xD3515C2831559A83,  -954, -268 }, { 0x9D71AC8FADA6C9B5,  -927, -260 },
+        { 0xEA9C227723EE8BCB,  -901, -252 }, { 0xAECC49914078536D,  -874, -244 },
+        { 0x823C12795DB6CE57,  -847, -236 }, { 0xC21094364DFB5637,  -821, -228 },
+        { 0x9096EA6F3848984F,  -794, -220 }, { 0xD77485CB25823AC7,  -768, -212 },
+        { 0xA086CFCD97BF97F4,  -741, -204 }, { 0xEF340A98172AACE5,  -715, -196 },
+        { 0xB23867FB2A35B28E,  -688, -188 }, { 0x84C8D4DFD2C63F3B,  -661, -180 },
+        { 0xC5DD44271AD3CDBA,  -635, -172 }, { 0x936B9FCEBB25C996,  -608, -164 },
+        { 0xDBAC6C247D62A584,  -582, -156 }, { 0xA3AB66580D5FDAF6,  -555, -148 },
+        { 0xF3E2F893DEC3F126,  -529, -140 }, { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+        { 0x87625F056C7C4A8B,  -475, -124 }, { 0xC9BCFF6034C13053,  -449, -116 },
+        { 0x964E858C91BA2655,  -422, -108 }, { 0xDFF9772470297EBD,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88F,  -369,  -92 }, { 0xF8A95FCF88747D94,  -343,  -84 },
+        { 0xB94470938FA89BCF,  -316,  -76 }, { 0x8A08F0F8BF0F156B,  -289,  -68 },
+        { 0xCDB02555653131B6,  -263,  -60 }, { 0x993FE2C6D07B7FAC,  -236,  -52 },
+        { 0xE45C10C42A2B3B06,  -210,  -44 }, { 0xAA242499697392D3,  -183,  -36 },
+        { 0xFD87B5F28300CA0E,  -157,  -28 }, { 0xBCE5086492111AEB,  -130,  -20 },
+        { 0x8CBCCC096F5088CC,  -103,  -12 }, { 0xD1B71758E219652C,   -77,   -4 },
+        { 0x9C40000000000000,   -50,    4 }, { 0xE8D4A51000000000,   -24,   12 },
+        { 0xAD78EBC5AC620000,     3,   20 }, { 0x813F3978F8940984,    30,   28 },
+        { 0xC097CE7BC90715B3,    56,   36 }, { 0x8F7E32CE7BEA5C70,    83,   44 },
+        { 0xD5D238A4ABE98068,   109,   52 }, { 0x9F4F2726179A2245,   136,   60 },
+        { 0xED63A231D4C4FB27,   162,   68 }, { 0xB0DE65388CC8ADA8,   189,   76 },
+        { 0x83C7088E1AAB65DB,   216,   84 }, { 0xC45D1DF942711D9A,   242,   92 },
+        { 0x924D692CA61BE758,   269,  100 }, { 0xDA01EE641A708DEA,   295,  108 },
+        { 0xA26DA3999AEF774A,   322,  116 }, { 0xF209787BB47D6B85,   348,  124 },
+        { 0xB454E4A179DD1877,   375,  132 }, { 0x865B86925B9BC5C2,   402,  140 },
+        { 0xC83553C5C8965D3D,   428,  148 }, { 0x952AB45CFA97A0B3,   455,  156 },
+        { 0xDE469FBD99A05FE3,   481,  164 }, { 0xA59BC234DB398C25,   508,  172 },
+        { 0xF6C69A72A3989F5C,   534,  180 }, { 0xB7DCBF5354E9BECE,   561,  188 },
+        { 0x88FCF317F22241E2,   588,  196 }, { 0xCC20CE9BD35C78A5,   614,  204 },
+        { 0x98165AF37B2153DF,   641,  212 }, { 0xE2A0B5DC971F303A,   667,  220 },
+        { 0xA8D9D1535CE3B396,   694,  228 }, { 0xFB9B7CD9A4A7443C,   720,  236 },
+        { 0xBB764C4CA7A44410,   747,  244 }, { 0x8BAB8EEFB6409C1A,   774,  252 },
+        { 0xD01FEF10A657842C,   800,  260 }, { 0x9B10A4E5E9913129,   827,  268 },
+        { 0xE7109BFBA19C0C9D,   853,  276 }, { 0xAC2820D9623BF429,   880,  284 },
+        { 0x80444B5E7AA7CF85,   907,  292 }, { 0xBF21E44003ACDD2D,   933,  300 },
+        { 0x8E679C2F5E44FF8F,   960,  308 }, { 0xD433179D9C8CB841,   986,  316 },
+        { 0x9E19DB92B4E31BA9,  1013,  324 }, { 0xEB96BF6EBADF77D9,  1039,  332 },
+        { 0xAF87023B9BF0EE6B,  1066,  340 },
+    };
+
+    // Target range of binary exponent of scaled value: digits are produced from 32-bit integral part
+    const int ALPHA = -60;
+    const int GAMMA = -32;
+
+    // Cached power c, so that ALPHA <= e + c.e_ + 64 <= GAMMA
+    const CachedPower& getCachedPower( int e )
+    {
+        // k = ceil( ( ALPHA - e - 1 ) * log10(2) )
+        int f = ALPHA - e - 1;
+        int k = ( f * 78913 ) / ( 1 << 18 ) + ( f > 0 );
+        int index = ( -CACHED_POWERS_MIN_K + k + ( CACHED_POWERS_STEP - 1 ) ) / CACHED_POWERS_STEP;
+        return cachedPowers[index];
+    }
+
+    // Largest power of ten which is <= n. Return count of its digits
+    int findLargestPow10( uint32_t n, uint32_t& pow10 )
+    {
+        static const uint32_t pows[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+        int digits = 10;
+        while ( digits > 1 && n < pows[digits - 1] )
+            digits--;
+        pow10 = pows[digits - 1];
+        return digits;
+    }
+
+    // Move last digit closer to exact value while it stays inside of interval
+    void roundWeed( char* buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t tenK )
+    {
+        while ( rest < dist && delta - rest >= tenK
+                && ( rest + tenK < dist || dist - rest > rest + tenK - dist ) )
+        {
+            buf[len - 1]--;
+            rest += tenK;
+        }
+    }
+
+    // Shortest digits of interval ( minus, plus ) which is closest to w. Value is digits * 10^decimalExponent
+    int generateDigits( char* buf, int& decimalExponent, DiyFp minus, DiyFp w, DiyFp plus )
+    {
+        uint64_t delta = sub( plus, minus ).f_;
+        uint64_t dist  = sub( plus, w ).f_;
+
+        // plus = p1 + p2 * 2^e ( integral and fractional parts )
+        const int      shift = -plus.e_;
+        const uint64_t one = 1ull << shift;
+        uint32_t p1 = static_cast<uint32_t>( plus.f_ >> shift );
+        uint64_t p2 = plus.f_ & ( one - 1 );
+
+        int len = 0;
+        uint32_t pow10;
+        int n = findLargestPow10( p1, pow10 );
+        while ( n > 0 )
+        {
+            buf[len++] = static_cast<char>( '0' + p1 / pow10 );
+            p1 %= pow10;
+            n--;
+            uint64_t rest = ( static_cast<uint64_t>( p1 ) << shift ) + p2;
+            if ( rest <= delta )
+            {
+                decimalExponent += n;
+                roundWeed( buf, len, dist, delta, rest, static_cast<uint64_t>( pow10 ) << shift );
+                return len;
+            }
+            pow10 /= 10;
+        }
+
+        int m = 0;
+        while ( true )
+        {
+            p2 *= 10;
+            buf[len++] = static_cast<char>( '0' + ( p2 >> shift ) );
+            p2 &= one - 1;
+            m++;
+            delta *= 10;
+            dist *= 10;
+            if ( p2 <= delta )
+                break;
+        }
+        decimalExponent -= m;
+        roundWeed( buf, len, dist, delta, p2, one );
+        return len;
+    }
+
+    int grisu2( char* buf, int& decimalExponent, const Boundaries& b )
+    {
+        const CachedPower& cached = getCachedPower( b.plus_.e_ );
+        DiyFp c( cached.f_, cached.e_ );
+        DiyFp w = mul( b.w_, c );
+        DiyFp minus = mul( b.minus_, c );
+        DiyFp plus = mul( b.plus_, c );
+
+        // Products are rounded, so shrink interval by one unit to stay inside of exact one
+        minus.f_++;
+        plus.f_--;
+        decimalExponent = -cached.k_;
+        return generateDigits( buf, decimalExponent, minus, w, plus );
+    }
+
+    // Place decimal point: digits * 10^decimalExponent.
+    // Fixed notation is used for 1e-4 <= |value| < 1e17 ( as %.17g does ), otherwise "d.ddde+XX"
+    size_t formatDigits( char* buf, int len, int decimalExponent )
+    {
+        int point = len + decimalExponent;      // position of decimal point relative to first digit
+        if ( len <= point && point <= 17 )
+        {
+            // 1234e5 -> 123400000
+            memset( buf + len, '0', point - len );
+            return point;
+        }
+        if ( 0 < point && point <= 17 )
+        {
+            // 1234e-2 -> 12.34
+            memmove( buf + point + 1, buf + point, len - point );
+            buf[point] = '.';
+            return len + 1;
+        }
+        if ( -4 < point && point <= 0 )
+        {
+            // 1234e-6 -> 0.001234
+            memmove( buf + 2 - point, buf, len );
+            buf[0] = '0';
+            buf[1] = '.';
+            memset( buf + 2, '0', -point );
+            return len + 2 - point;
+        }
+
+        // 1234e30 -> 1.234e+33
+        size_t pos = 1;
+        if ( len > 1 )
+        {
+            memmove( buf + 2, buf + 1, len - 1 );
+            buf[1] = '.';
+            pos = len + 1;
+        }
+        int exp10 = point - 1;
+        buf[pos++] = 'e';
+        buf[pos++] = ( exp10 < 0 ) ? '-' : '+';
+        unsigned absExp = ( exp10 < 0 ) ? -exp10 : exp10;
+        if ( absExp < 10 )
+            buf[pos++] = '0';
+        return pos + formatDecimal( buf + pos, absExp );
+    }
+
+    // Common part. "bits" are without sign, "precision" is count of significand bits ( with hidden one )
+    template<typename T>
+    size_t formatShortest( char* buf, T value, uint64_t bits, int precision, int exponentBias )
+    {
+        size_t pos = 0;
+        if ( value != value )
+        {
+            memcpy( buf, "nan", 3 );
+            return 3;
+        }
+        if ( std::signbit( value ) )
+        {
+            buf[pos++] = '-';
+            value = -value;
+        }
+        if ( value == std::numeric_limits<T>::infinity() )
+        {
+            memcpy( buf + pos, "inf", 3 );
+            return pos + 3;
+        }
+
+        // Fast path: integer which is exact in T is already the shortest form
+        if ( value < static_cast<T>( 1ull << ( precision ) ) && value == static_cast<T>( static_cast<uint64_t>( value ) ) )
+            return pos + formatDecimal( buf + pos, static_cast<unsigned long long>( value ) );
+
+        int decimalExponent;
+        int len = grisu2( buf + pos, decimalExponent, computeBoundaries( bits, precision, exponentBias ) );
+        return pos + formatDigits( buf + pos, len, decimalExponent );
+    }
+}   // anonymous namespace
+
+size_t formatDouble( char* buf, double value )
+{
+    uint64_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    bits &= ~( 1ull << 63 );
+    return formatShortest( buf, value, bits, std::numeric_limits<double>::digits, std::numeric_limits<double>::max_exponent - 1 );
+}
+
+size_t formatFloat( char* buf, float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    bits &= ~( 1u << 31 );
+    return formatShortest( buf, value, bits, std::numeric_limits<float>::digits, std::numeric_limits<float>::max_exponent - 1 );
+}
+
+}   // end of namespace tostr
+}   // end of namespace util
+}   // end of namespace tsv
@@ -5,10 +5,12 @@
   Date: 02-Aug-2017
   License: BSD. See License.txt
 **********************************************************************/
-#include <sstream>
 #include <cstdarg>      // va_list
 #include <cstdio>      // vsprintf
 #include <memory>       // unique_ptr
+#include <cstring>      // strchr, memcpy
+#include <cstdint>      // uintptr_t
+#include <limits>
 #include "tostr_handler.h"
 
 using namespace std;
@@ -46,6 +48,16 @@ std::string toStr( std::nullptr_t value, int )
 namespace impl
 {
 
+// Handler of long double: shortest text if value fits into double, otherwise all significant digits
+ToStringRV __toString( const long double& value, int /*mode*/ )
+{
+    char buf[64];
+    if ( static_cast<long double>( static_cast<double>( value ) ) == value )
+        return { std::string( buf, formatDouble( buf, static_cast<double>( value ) ) ), true };
+    snprintf( buf, sizeof(buf), "%.*Lg", std::numeric_limits<long double>::max_digits10, value );
+    return { buf, true };
+}
+
 // Handler of std::string
 ToStringRV __toString( const std::string& value, int mode )
 {
@@ -63,14 +75,105 @@ ToStringRV __toString( const std::string& value, int mode )
 //Get pointer hex representation
 std::string hex_addr( const void* ptr )
 {
-    if ( !ptr )
-        return "nullptr";
+    char buf[ADDR_BUF_SIZE];
+    return std::string( buf, formatAddr( buf, ptr ) );
+}
+
+/*******************************************
+        Fast number formatting
+*******************************************/
+
+namespace
+{
+    // Two digits of each value 0..99
+    const char digitPairs[] =
+        "00010203040506070809" "10111213141516171819" "20212223242526272829" "30313233343536373839"
+        "40414243444546474849" "50515253545556575859" "60616263646566676869" "70717273747576777879"
+        "80818283848586878889" "90919293949596979899";
+
+    unsigned countDigits( unsigned long long value )
+    {
+        unsigned count = 1;
+        while ( true )
+        {
+            if ( value < 10 )    return count;
+            if ( value < 100 )   return count + 1;
+            if ( value < 1000 )  return count + 2;
+            if ( value < 10000 ) return count + 3;
+            value /= 10000;
+            count += 4;
+        }
+    }
+
+    unsigned countHexDigits( unsigned long long value )
+    {
+#if defined(__GNUC__)
+        return ( 64 - __builtin_clzll( value | 1 ) + 3 ) / 4;
+#else
+        unsigned count = 1;
+        while ( value >>= 4 )
+            count++;
+        return count;
+#endif
+    }
+}
+
+size_t formatDecimal( char* buf, unsigned long long value )
+{
+    unsigned len = countDigits( value );
+    char* p = buf + len;
+    while ( value >= 100 )
+    {
+        const char* pair = digitPairs + ( value % 100 ) * 2;
+        value /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if ( value >= 10 )
+    {
+        *--p = digitPairs[value * 2 + 1];
+        *--p = digitPairs[value * 2];
+    }
     else
+        *--p = static_cast<char>( '0' + value );
+    return len;
+}
+
+size_t formatDecimal( char* buf, long long value )
+{
+    if ( value >= 0 )
+        return formatDecimal( buf, static_cast<unsigned long long>( value ) );
+    *buf = '-';
+    // negate in unsigned, so LLONG_MIN is not overflowed
+    return 1 + formatDecimal( buf + 1, 0ull - static_cast<unsigned long long>( value ) );
+}
+
+size_t formatHex( char* buf, unsigned long long value, unsigned minDigits /*=1*/ )
+{
+    unsigned len = countHexDigits( value );
+    if ( len < minDigits )
+        len = ( minDigits < 16 ) ? minDigits : 16;
+    for ( unsigned i = len; i > 0; i--, value >>= 4 )
+    {
+        // no branch and no table: digits above 9 are shifted to 'a'
+        int nibble = static_cast<int>( value & 15 );
+        buf[i - 1] = static_cast<char>( '0' + nibble + ( ( ( 9 - nibble ) >> 8 ) & ( 'a' - '0' - 10 ) ) );
+    }
+    return len;
+}
+
+size_t formatAddr( char* buf, const void* ptr )
+{
+    if ( !ptr )
     {
-        std::stringstream ss;
-        ss << ptr;
-        return ss.str();
+        memcpy( buf, "nullptr", 8 );
+        return 7;
     }
+    buf[0] = '0';
+    buf[1] = 'x';
+    size_t len = 2 + formatHex( buf + 2, reinterpret_cast<uintptr_t>( ptr ) );
+    buf[len] = 0;
+    return len;
 }
 
 /*******************************************
@@ -80,8 +183,9 @@ std::string hex_addr( const void* ptr )
 // vsprintf-like
 std::string strfmtVA( const std::string& fmt_str, va_list* args )
 {
-    static unsigned int bufsize=10000;
-    std::unique_ptr<char[]> buf( new char[10000] );
+    // NOTE: bufsize is local, so concurrent calls do not share buffer size
+    unsigned int bufsize=10000;
+    std::unique_ptr<char[]> buf( new char[bufsize] );
     //printf("VA %s *%p=%p\n", fmt_str.c_str(), args, *args);
 
     if ( bufsize <= fmt_str.size() )
@@ -93,16 +197,20 @@ std::string strfmtVA( const std::string& fmt_str, va_list* args )
 
     while( true )
     {
-        int final_n = vsnprintf( buf.get(), bufsize-5, fmt_str.c_str(), *args );
+        // each attempt takes own copy: vsnprintf consumes list
+        va_list ap;
+        va_copy( ap, *args );
+        unsigned int len = bufsize - 5;
+        int final_n = vsnprintf( buf.get(), len, fmt_str.c_str(), ap );
+        va_end( ap );
         if ( final_n < 0 )                  // error happens
             return fmt_str;
-        else if ( final_n < static_cast<int>(bufsize) )     // ok
-            return std::string( buf.get() );
+        else if ( final_n < static_cast<int>(len) )         // ok
+            return std::string( buf.get(), final_n );
 
         // need more then current buffer - resize it with extra and try again
         bufsize = final_n+100;
         buf.reset(new char[bufsize]);
-            printf("resize/%d %p\n",bufsize,buf.get());
     }
 }
 
@@ -116,6 +224,226 @@ std::string strfmt( const std::string& fmt_str, ... )
     return s;
 }
 
+/*******************************************
+        Typed printf-like formatting
+*******************************************/
+
+// Parse conversion which starts at fmt[pos]=='%'
+bool parseFormatSpec( const char* fmt, unsigned pos, FormatSpec& spec )
+{
+    if ( fmt[pos] != '%' || fmt[pos+1] == '%' )
+        return false;
+
+    spec.start_ = pos;
+    spec.stars_ = 0;
+    const char* c = fmt + pos + 1;
+    while ( *c && strchr( "-+ #0'", *c ) )
+        c++;
+    for ( ; *c && ( ( *c >= '0' && *c <= '9' ) || *c == '.' || *c == '*' ); c++ )
+        if ( *c == '*' )
+            spec.stars_++;
+
+    spec.modifier_ = c - fmt;
+    int longs = 0;
+    bool isLongDouble = false, isWide64 = false;
+    for ( ; *c && strchr( "hlLqjzZt", *c ); c++ )
+    {
+        if ( *c == 'l' )
+            longs++;
+        else if ( *c == 'L' || *c == 'q' )
+            isLongDouble = isWide64 = true;
+        else if ( *c == 'j' || *c == 'z' || *c == 'Z' || *c == 't' )
+            isWide64 = true;
+    }
+    isWide64 = isWide64 || longs > 0;
+
+    spec.conv_ = *c;
+    switch ( *c )
+    {
+        case 'd': case 'i':
+            spec.kind_ = isWide64 ? FMT_INT64 : FMT_INT; break;
+        case 'o': case 'u': case 'x': case 'X':
+            spec.kind_ = isWide64 ? FMT_UINT64 : FMT_UINT; break;
+        case 'c':
+            spec.kind_ = FMT_UINT; break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec.kind_ = isLongDouble ? FMT_LDOUBLE : FMT_DOUBLE; break;
+        case 's':
+            spec.kind_ = longs ? FMT_WSTR : FMT_STR; break;
+        case 'p':
+            spec.kind_ = FMT_PTR; break;
+        case 'n':
+            spec.kind_ = FMT_NONE; break;       // not supported, but have to skip argument
+        default:
+            return false;                       // invalid conversion is printed as is
+    }
+    spec.end_ = c + 1 - fmt;
+    return true;
+}
+
+namespace
+{
+    // Append to "out" one value printed by single conversion "conv" ( with "stars" width/precision )
+    template<typename T>
+    void appendConversion( std::string& out, const char* conv, const int* stars, int starsCount, T value )
+    {
+        size_t oldSize = out.size();
+        size_t room = 32;
+        while ( true )
+        {
+            out.resize( oldSize + room );
+            int n;
+            if ( starsCount == 0 )
+                n = snprintf( &out[oldSize], room, conv, value );
+            else if ( starsCount == 1 )
+                n = snprintf( &out[oldSize], room, conv, stars[0], value );
+            else
+                n = snprintf( &out[oldSize], room, conv, stars[0], stars[1], value );
+
+            if ( n < 0 )
+                n = 0;
+            if ( static_cast<size_t>( n ) < room )
+            {
+                out.resize( oldSize + n );
+                return;
+            }
+            room = n + 1;
+        }
+    }
+
+    long long argAsInt( const FormatArg& arg )
+    {
+        switch ( arg.type_ )
+        {
+            case FormatArg::ARG_INT:    return arg.int_;
+            case FormatArg::ARG_UINT:   return static_cast<long long>( arg.uint_ );
+            case FormatArg::ARG_DOUBLE: return static_cast<long long>( arg.double_ );
+            default:                    return 0;
+        }
+    }
+}
+
+// Type-safe sprintf. Each conversion is printed according to real type of its argument:
+//  flags, width and precision are taken from format, but length modifier is
+//  replaced by the one which match the argument. If conversion does not fit
+//  the argument at all, then natural conversion of argument is used ( %d for int, %s for string )
+void formatArgs( std::string& out, const char* fmt, const FormatArg* args, size_t count )
+{
+    size_t argIdx = 0;
+    unsigned pos = 0;
+    while ( fmt[pos] )
+    {
+        // literal part
+        unsigned litStart = pos;
+        while ( fmt[pos] && fmt[pos] != '%' )
+            pos++;
+        out.append( fmt + litStart, pos - litStart );
+        if ( !fmt[pos] )
+            break;
+
+        FormatSpec spec;
+        if ( !parseFormatSpec( fmt, pos, spec ) )
+        {
+            // "%%" or invalid conversion
+            out += '%';
+            pos += ( fmt[pos+1] == '%' ) ? 2 : 1;
+            continue;
+        }
+
+        // Not enough arguments, or too long conversion - print it as is
+        char conv[64];
+        size_t flagsLen = spec.modifier_ - spec.start_;
+        if ( argIdx + spec.stars_ >= count || flagsLen + 4 > sizeof(conv) )
+        {
+            out.append( fmt + spec.start_, spec.end_ - spec.start_ );
+            pos = spec.end_;
+            argIdx = count;
+            continue;
+        }
+
+        int stars[2] = { 0, 0 };
+        for ( int i = 0; i < spec.stars_; i++, argIdx++ )
+            if ( i < 2 )
+                stars[i] = static_cast<int>( argAsInt( args[argIdx] ) );
+        const FormatArg& arg = args[argIdx++];
+        pos = spec.end_;
+        if ( spec.kind_ == FMT_NONE )
+            continue;
+
+        // Rebuild conversion with length modifier which match the argument
+        memcpy( conv, fmt + spec.start_, flagsLen );
+        char* c = conv + flagsLen;
+        char convChar = spec.conv_;
+        switch ( arg.type_ )
+        {
+            case FormatArg::ARG_INT:
+            case FormatArg::ARG_UINT:
+                if ( !strchr( "diouxXc", convChar ) )
+                    convChar = ( arg.type_ == FormatArg::ARG_INT ) ? 'd' : 'u';
+                if ( convChar != 'c' )
+                {
+                    *c++ = 'l';
+                    *c++ = 'l';
+                }
+                break;
+            case FormatArg::ARG_DOUBLE:
+                if ( !strchr( "eEfFgGaA", convChar ) )
+                    convChar = 'g';
+                break;
+            case FormatArg::ARG_STR:
+                convChar = 's';
+                break;
+            case FormatArg::ARG_PTR:
+                if ( convChar != 'x' && convChar != 'X' )
+                    convChar = 'p';
+                else
+                {
+                    *c++ = 'l';
+                    *c++ = 'l';
+                }
+                break;
+        }
+        *c++ = convChar;
+        *c = 0;
+
+        int starsCount = ( spec.stars_ < 2 ) ? spec.stars_ : 2;
+        switch ( arg.type_ )
+        {
+            case FormatArg::ARG_INT:
+                if ( convChar == 'c' )
+                    appendConversion( out, conv, stars, starsCount, static_cast<int>( arg.int_ ) );
+                else if ( strchr( "ouxX", convChar ) && arg.len_ < sizeof(long long) )
+                {
+                    // as printf does: negative value is shown in width of its promoted type ( -1 => ffffffff )
+                    size_t bytes = ( arg.len_ < sizeof(int) ) ? sizeof(int) : arg.len_;
+                    unsigned long long mask = ( 1ULL << ( bytes * 8 ) ) - 1;
+                    appendConversion( out, conv, stars, starsCount, static_cast<unsigned long long>( arg.int_ ) & mask );
+                }
+                else
+                    appendConversion( out, conv, stars, starsCount, arg.int_ );
+                break;
+            case FormatArg::ARG_UINT:
+                if ( convChar == 'c' )
+                    appendConversion( out, conv, stars, starsCount, static_cast<int>( arg.uint_ ) );
+                else
+                    appendConversion( out, conv, stars, starsCount, arg.uint_ );
+                break;
+            case FormatArg::ARG_DOUBLE:
+                appendConversion( out, conv, stars, starsCount, arg.double_ );
+                break;
+            case FormatArg::ARG_STR:
+                appendConversion( out, conv, stars, starsCount, arg.str_ );
+                break;
+            case FormatArg::ARG_PTR:
+                if ( convChar == 'p' )
+                    appendConversion( out, conv, stars, starsCount, arg.ptr_ );
+                else
+                    appendConversion( out, conv, stars, starsCount, static_cast<unsigned long long>( reinterpret_cast<uintptr_t>( arg.ptr_ ) ) );
+                break;
+        }
+    }
+}
+
 
 }   // end of namespace tostr
 }   // end of namespace util
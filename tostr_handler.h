@@ -18,6 +18,8 @@
 #include <type_traits>
 #include <typeinfo>         // typeid
 #include <cstdarg>          // va_list
+#include <cstring>          // strlen
+#include <cstddef>          // nullptr_t
 #if CPP11_FEATURES
 #include <memory>           // for unique_ptr,shared_ptr, weak_ptr handlers
 #else
@@ -43,6 +45,38 @@ namespace tostr{
 // Auxiliary function to decode pointer to hex string
 std::string hex_addr( const void* ptr );
 
+
+/************************* Fast number formatting  *******************************/
+// Write number to caller buffer without terminating zero. Return count of written chars.
+// No locale, no allocations: they are used for pointers, ids and levels in every line.
+
+const size_t DECIMAL_BUF_SIZE = 20;     // enough for any 64-bit value ( with sign )
+const size_t ADDR_BUF_SIZE = 19;        // "0x" + 16 digits + terminating zero
+
+size_t formatDecimal( char* buf, unsigned long long value );
+size_t formatDecimal( char* buf, long long value );
+
+// Other integral types ( including char and bool ) are printed as number
+template<typename T>
+typename std::enable_if< std::is_integral<T>::value, size_t >::type
+formatDecimal( char* buf, T value )
+{
+    return std::is_signed<T>::value ? formatDecimal( buf, static_cast<long long>( value ) )
+                                    : formatDecimal( buf, static_cast<unsigned long long>( value ) );
+}
+
+// Lowercase hex digits, no prefix. Leading zeros up to minDigits ( max 16 )
+size_t formatHex( char* buf, unsigned long long value, unsigned minDigits = 1 );
+
+// Same as hex_addr(): "0x..." or "nullptr". Buffer is zero terminated
+size_t formatAddr( char* buf, const void* ptr );
+
+// Shortest text which reads back to the same value: "0.1", "2", "1e+21", "-inf", "nan".
+// Fixed notation is used for 1e-4 <= |value| < 1e17, otherwise scientific ( tostr_float.cpp )
+const size_t FLOAT_BUF_SIZE = 32;
+size_t formatDouble( char* buf, double value );
+size_t formatFloat( char* buf, float value );
+
 /************************* SPRINTF-like functions  *******************************/
 
 // Like sprintf, but returns std::string instead of using charbuf
@@ -52,6 +86,66 @@ std::string strfmt( const std::string& fmt_str, ... );
 std::string strfmtVA( const std::string& fmt_str, va_list* args );
 
 
+/************************* Typed printf-like formatting  ***************************/
+
+// What kind of argument is expected by printf conversion
+enum FormatArgKind { FMT_INT, FMT_UINT, FMT_INT64, FMT_UINT64, FMT_DOUBLE, FMT_LDOUBLE, FMT_STR, FMT_WSTR, FMT_PTR, FMT_NONE };
+
+// Location and kind of one printf conversion ("%-8.3lf") inside of format string
+struct FormatSpec
+{
+    unsigned start_;        // offset of '%'
+    unsigned modifier_;     // offset of length modifier ( or conversion if no modifier )
+    unsigned end_;          // offset after conversion char
+    unsigned char kind_;    // FormatArgKind
+    unsigned char stars_;   // how many int arguments are taken by '*' width/precision
+    char     conv_;         // conversion char
+};
+
+// Parse conversion which starts at fmt[pos]=='%'
+// Return false if that is not a conversion which takes argument ( "%%" or invalid one )
+bool parseFormatSpec( const char* fmt, unsigned pos, FormatSpec& spec );
+
+// Typed argument of printf-like call ( strings are not copied )
+struct FormatArg
+{
+    enum Type { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_STR, ARG_PTR };
+
+    Type type_;
+    union
+    {
+        long long          int_;
+        unsigned long long uint_;
+        double             double_;
+        const void*        ptr_;
+        const char*        str_;
+    };
+    size_t len_;            // length of str_ or sizeof of integral value
+
+    FormatArg( const char* v ) : type_( ARG_STR ), str_( v ), len_( v ? strlen( v ) : 0 ) {}
+    FormatArg( const std::string& v ) : type_( ARG_STR ), str_( v.c_str() ), len_( v.size() ) {}
+    FormatArg( std::nullptr_t ) : type_( ARG_PTR ), ptr_( nullptr ), len_( 0 ) {}
+    FormatArg( bool v ) : type_( ARG_INT ), int_( v ), len_( sizeof(int) ) {}
+
+    template<typename T>
+    FormatArg( T v, typename std::enable_if< ( std::is_integral<T>::value && std::is_signed<T>::value ) || std::is_enum<T>::value, int >::type = 0 )
+        : type_( ARG_INT ), int_( static_cast<long long>( v ) ), len_( sizeof(T) ) {}
+    template<typename T>
+    FormatArg( T v, typename std::enable_if< std::is_integral<T>::value && std::is_unsigned<T>::value, int >::type = 0 )
+        : type_( ARG_UINT ), uint_( v ), len_( sizeof(T) ) {}
+    template<typename T>
+    FormatArg( T v, typename std::enable_if< std::is_floating_point<T>::value, int >::type = 0 )
+        : type_( ARG_DOUBLE ), double_( static_cast<double>( v ) ), len_( 0 ) {}
+    template<typename T>
+    FormatArg( const T* v ) : type_( ARG_PTR ), ptr_( v ), len_( 0 ) {}
+};
+
+// Append to "out" format filled with typed arguments ( type-safe sprintf )
+//  Each conversion takes the next argument and is printed according to
+//  its real type, so mismatch could not crash. Missed arguments are printed as is.
+void formatArgs( std::string& out, const char* fmt, const FormatArg* args, size_t count );
+
+
 /******************************************************
   toStr() internal processors implementations for types
 
@@ -86,20 +180,31 @@ __toString( const T& value, int mode )
     return { "", false };   // no value
 }
 
-// Integral + floating_point handler
+// Integral handler
 template<typename T>
-typename std::enable_if< std::is_arithmetic<T>::value, ToStringRV >::type
-__toString( const T& value, int mode )
+typename std::enable_if< std::is_integral<T>::value, ToStringRV >::type
+__toString( const T& value, int /*mode*/ )
 {
-#if CPP11_FEATURES
-    return { std::to_string( value ), true };
-#else
-    std::ostringstream ss;
-    ss << value;
-    std::string s( ss.str() );
-    return { s, true };
-#endif
+    char buf[DECIMAL_BUF_SIZE];
+    return { std::string( buf, formatDecimal( buf, value ) ), true };
+}
+
+// Floating_point handler ( shortest round-trip text in any mode )
+inline ToStringRV __toString( const float& value, int /*mode*/ )
+{
+    char buf[FLOAT_BUF_SIZE];
+    return { std::string( buf, formatFloat( buf, value ) ), true };
 }
+
+inline ToStringRV __toString( const double& value, int /*mode*/ )
+{
+    char buf[FLOAT_BUF_SIZE];
+    return { std::string( buf, formatDouble( buf, value ) ), true };
+}
+
+// long double is wider than any fast formatter here
+ToStringRV __toString( const long double& value, int mode );
+
 // std::string handler
 ToStringRV __toString( const std::string& value, int mode );
 
@@ -191,6 +296,29 @@ std::string toStr( void* v, int mode = ENUM_TOSTR_DEFAULT );
 std::string toStr( std::nullptr_t value, int mode = ENUM_TOSTR_DEFAULT );
 std::string toStr( const char* v, int mode = ENUM_TOSTR_DEFAULT );
 
+
+/**********************************************
+    Argument adaptor for typed printf-like calls
+
+Purpose: Pass value which is understood by FormatArg as is,
+         and convert any other value to string by toStr()
+Usage:
+    FormatArg arg( passArg( value ) );  // temporary string lives until end of full expression
+************************************************/
+template<typename T>
+typename std::enable_if< std::is_constructible< FormatArg, const T& >::value, const T& >::type
+passArg( const T& val )
+{
+    return val;
+}
+
+template<typename T>
+typename std::enable_if< !std::is_constructible< FormatArg, const T& >::value, std::string >::type
+passArg( const T& val )
+{
+    return toStr( val );
+}
+
 } // namespace tostr
 } // namespace util
 } // namespace tsv